@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    AsyncLogger.cpp
+    Registro asíncrono que se puede usar desde el hilo de audio.
+
+  ==============================================================================
+*/
+
+#include "AsyncLogger.h"
+#include <cstdarg>
+
+//==============================================================================
+AsyncLogger::AsyncLogger()
+    : juce::Thread ("Async logger"),
+      slots (new Slot[queueSize])
+{
+    static_assert ((queueSize & (queueSize - 1)) == 0, "queueSize debe ser potencia de dos");
+
+    for (size_t i = 0; i < queueSize; ++i)
+        slots[i].sequence.store (i, std::memory_order_relaxed);
+
+    lastRefillMs = juce::Time::getMillisecondCounterHiRes();
+
+    // Solo se instala si nadie más tiene puesto un logger; si no, le reenvía los mensajes
+    if (juce::Logger::getCurrentLogger() == nullptr)
+        juce::Logger::setCurrentLogger (this);
+
+    startThread (juce::Thread::Priority::low);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    if (juce::Logger::getCurrentLogger() == this)
+        juce::Logger::setCurrentLogger (nullptr);
+
+    stopThread (2000);
+    flush();
+}
+
+//==============================================================================
+bool AsyncLogger::logf (const char* format, ...)
+{
+    auto* slot = claim();
+    if (slot == nullptr)
+        return false;
+
+    va_list args;
+    va_start (args, format);
+    std::vsnprintf (slot->record.text, maximumRecordLength, format, args);
+    va_end (args);
+
+    publish (*slot);
+    return true;
+}
+
+void AsyncLogger::logMessage (const juce::String& message)
+{
+    auto* slot = claim();
+    if (slot == nullptr)
+        return;
+
+    // Copia truncada; el texto ya está en UTF-8 dentro del juce::String
+    message.copyToUTF8 (slot->record.text, maximumRecordLength);
+    publish (*slot);
+}
+
+AsyncLogger::Statistics AsyncLogger::getStatistics() const
+{
+    Statistics statistics;
+    statistics.written = written;
+    statistics.droppedQueueFull = droppedQueueFull;
+    statistics.droppedRateLimited = droppedRateLimited;
+    return statistics;
+}
+
+//==============================================================================
+AsyncLogger::Slot* AsyncLogger::claim()
+{
+    // Cola acotada con número de secuencia por registro: cada productor reserva una
+    // posición con compare_exchange y el consumidor ve el registro cuando se publica
+    auto position = enqueuePosition.load (std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& slot = slots[position & (queueSize - 1)];
+        const auto sequence = slot.sequence.load (std::memory_order_acquire);
+        const auto difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) position;
+
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                return &slot;
+        }
+        else if (difference < 0)
+        {
+            ++droppedQueueFull;
+            return nullptr;
+        }
+        else
+        {
+            position = enqueuePosition.load (std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLogger::publish (Slot& slot)
+{
+    // Al reservarlo, la secuencia del registro era su posición en la cola
+    const auto position = slot.sequence.load (std::memory_order_relaxed);
+    slot.sequence.store (position + 1, std::memory_order_release);
+}
+
+//==============================================================================
+void AsyncLogger::run()
+{
+    while (!threadShouldExit())
+    {
+        flush();
+        wait (flushIntervalMs);
+    }
+}
+
+void AsyncLogger::flush()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    tokens = juce::jmin ((double) maximumMessagesPerSecond,
+                         tokens + (now - lastRefillMs) * maximumMessagesPerSecond / 1000.0);
+    lastRefillMs = now;
+
+    for (;;)
+    {
+        auto& slot = slots[dequeuePosition & (queueSize - 1)];
+        if (slot.sequence.load (std::memory_order_acquire) != dequeuePosition + 1)
+            break;
+
+        if (tokens >= 1.0)
+        {
+            tokens -= 1.0;
+            write (slot.record);
+        }
+        else
+        {
+            ++droppedRateLimited;
+        }
+
+        // Devolver el registro a los productores para la siguiente vuelta de la cola
+        slot.sequence.store (dequeuePosition + queueSize, std::memory_order_release);
+        ++dequeuePosition;
+    }
+
+    // Avisar (una vez por tanda) de los mensajes perdidos
+    const auto drops = droppedQueueFull.load() + droppedRateLimited.load();
+    if (drops != reportedDrops)
+    {
+        Record report;
+        std::snprintf (report.text, maximumRecordLength, "AsyncLogger: %llu mensajes descartados (%llu cola llena, %llu por límite)",
+                       (unsigned long long) (drops - reportedDrops),
+                       (unsigned long long) droppedQueueFull.load(),
+                       (unsigned long long) droppedRateLimited.load());
+        write (report);
+        reportedDrops = drops;
+    }
+}
+
+void AsyncLogger::write (const Record& record)
+{
+    const auto text = juce::String::fromUTF8 (record.text);
+
+    // Si este es el logger actual, writeToLog volvería a la cola
+    if (juce::Logger::getCurrentLogger() == this)
+        juce::Logger::outputDebugString (text);
+    else
+        juce::Logger::writeToLog (text);
+
+    ++written;
+}
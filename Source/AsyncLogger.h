@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    AsyncLogger.h
+    Registro asíncrono que se puede usar desde el hilo de audio.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Los mensajes se formatean en registros de tamaño fijo ya reservados y pasan
+    por una cola circular sin locks (varios productores, un consumidor). Un hilo
+    de fondo los escribe con un límite de mensajes por segundo; si la cola está
+    llena o se supera el límite, el mensaje se descarta y se cuenta.
+
+    logf() no reserva memoria ni bloquea, así que se puede llamar desde
+    processBlock. Al crearse se instala como juce::Logger (si no hay otro), de
+    modo que los writeToLog del resto del código tampoco escriben en el hilo
+    que los llama; si ya había otro logger, la salida se le reenvía. Se usa a
+    través de juce::SharedResourcePointer.
+*/
+class AsyncLogger : public juce::Logger,
+                    private juce::Thread
+{
+public:
+    struct Statistics
+    {
+        juce::uint64 written = 0;
+        juce::uint64 droppedQueueFull = 0;      // Cola llena al escribir
+        juce::uint64 droppedRateLimited = 0;    // Por encima de maximumMessagesPerSecond
+    };
+
+    AsyncLogger();
+    ~AsyncLogger() override;
+
+    // Formato printf en un registro de la cola (el texto se trunca al tamaño del registro).
+    // Seguro en tiempo real; devuelve false si se descartó.
+    bool logf (const char* format, ...);
+
+    // juce::Logger: copia el texto en un registro (el juce::String ya existe, no se formatea nada)
+    void logMessage (const juce::String& message) override;
+
+    Statistics getStatistics() const;
+
+    static constexpr size_t queueSize = 1024;               // Potencia de dos
+    static constexpr size_t maximumRecordLength = 240;      // Bytes de texto por registro (con el terminador)
+    static constexpr int maximumMessagesPerSecond = 200;
+    static constexpr int flushIntervalMs = 50;
+
+private:
+    struct Record
+    {
+        char text[maximumRecordLength];
+    };
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        Record record;
+    };
+
+    // Reserva un registro libre o nullptr si la cola está llena; publish() lo entrega al consumidor
+    Slot* claim();
+    void publish (Slot& slot);
+
+    void run() override;
+    void flush();
+    void write (const Record& record);
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> enqueuePosition { 0 };
+    size_t dequeuePosition = 0;                 // Solo lo usa el hilo de fondo
+
+    std::atomic<juce::uint64> written { 0 }, droppedQueueFull { 0 }, droppedRateLimited { 0 };
+    juce::uint64 reportedDrops = 0;
+
+    // Límite de mensajes: cubo de fichas que se rellena con el tiempo
+    double tokens = (double) maximumMessagesPerSecond;
+    double lastRefillMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AsyncLogger)
+};
@@ -0,0 +1,712 @@
+/*
+  ==============================================================================
+
+    AudioAligner.cpp
+    Alineación de la carta MIDI con una grabación de la canción.
+
+  ==============================================================================
+*/
+
+#include "AudioAligner.h"
+#include "HitClassifier.h"
+
+namespace
+{
+    constexpr int maximumFrames = 1 << 20;              // Unas tres horas con frames de 10 ms
+    constexpr float energyCompression = 100.0f;         // log (1 + k * rms)
+    constexpr double smoothingSeconds = 0.03;
+    constexpr double leadSeconds = 0.5;                 // Margen antes y después de la actividad
+    constexpr double maximumLengthRatio = 4.0;          // Entre la grabación y la carta
+    constexpr double pathSmoothingSeconds = 0.5;
+    constexpr double minimumPathSlope = 0.1;            // Frames de grabación por frame de carta
+    constexpr double pointSeconds = 0.25;               // Separación de los puntos del WarpMap
+
+    // Banda de la secuencia para cada nota de la carta
+    int getBandForNote (int noteNumber)
+    {
+        switch (HitClassifier::getLane (noteNumber))
+        {
+            case HitClassifier::kickLane:
+            case HitClassifier::tomLane:        return 0;
+            case HitClassifier::hiHatLane:
+            case HitClassifier::cymbalLane:     return 2;
+            default:                            return 1;
+        }
+    }
+
+    // Llama a function (index) para cada índice repartiéndolos entre el pool y el hilo que llama.
+    // Vuelve cuando todos han terminado.
+    template <typename Function>
+    void parallelFor (juce::ThreadPool& pool, int numThreads, int numItems, Function&& function)
+    {
+        std::atomic<int> nextIndex { 0 };
+
+        auto work = [&]
+        {
+            for (int index = nextIndex++; index < numItems; index = nextIndex++)
+                function (index);
+        };
+
+        const int numJobs = juce::jmin (numThreads, numItems) - 1;
+        std::atomic<int> jobsRunning { numJobs };
+        juce::WaitableEvent jobsFinished;
+
+        for (int i = 0; i < numJobs; ++i)
+        {
+            pool.addJob ([&work, &jobsRunning, &jobsFinished]
+            {
+                work();
+
+                if (--jobsRunning == 0)
+                    jobsFinished.signal();
+            });
+        }
+
+        work();
+
+        if (numJobs > 0)
+            jobsFinished.wait();
+    }
+}
+
+//==============================================================================
+AudioAligner::WarpMap::WarpMap (std::vector<Point> newPoints)
+    : points (std::move (newPoints))
+{
+}
+
+double AudioAligner::WarpMap::getAverageSlope() const
+{
+    return (points.back().audioSeconds - points.front().audioSeconds)
+         / (points.back().chartSeconds - points.front().chartSeconds);
+}
+
+double AudioAligner::WarpMap::map (double chartSeconds) const
+{
+    if (isEmpty())
+        return chartSeconds;
+
+    if (chartSeconds <= points.front().chartSeconds)
+        return points.front().audioSeconds + (chartSeconds - points.front().chartSeconds) * getAverageSlope();
+
+    if (chartSeconds >= points.back().chartSeconds)
+        return points.back().audioSeconds + (chartSeconds - points.back().chartSeconds) * getAverageSlope();
+
+    const auto next = std::upper_bound (points.begin(), points.end(), chartSeconds,
+                                        [] (double seconds, const Point& point) { return seconds < point.chartSeconds; });
+    const auto& previous = *(next - 1);
+
+    return previous.audioSeconds + (chartSeconds - previous.chartSeconds) * (next->audioSeconds - previous.audioSeconds)
+                                                                          / (next->chartSeconds - previous.chartSeconds);
+}
+
+double AudioAligner::WarpMap::getSlope (double chartSeconds) const
+{
+    if (isEmpty())
+        return 1.0;
+
+    if (chartSeconds < points.front().chartSeconds || chartSeconds >= points.back().chartSeconds)
+        return getAverageSlope();
+
+    const auto next = std::upper_bound (points.begin(), points.end(), chartSeconds,
+                                        [] (double seconds, const Point& point) { return seconds < point.chartSeconds; });
+    const auto& previous = *(next - 1);
+
+    return (next->audioSeconds - previous.audioSeconds) / (next->chartSeconds - previous.chartSeconds);
+}
+
+juce::String AudioAligner::WarpMap::toString() const
+{
+    juce::StringArray pairs;
+
+    for (const auto& point : points)
+        pairs.add (juce::String (point.chartSeconds, 4) + ":" + juce::String (point.audioSeconds, 4));
+
+    return pairs.joinIntoString (";");
+}
+
+AudioAligner::WarpMap AudioAligner::WarpMap::fromString (const juce::String& text)
+{
+    const auto pairs = juce::StringArray::fromTokens (text, ";", {});
+    std::vector<Point> points;
+    points.reserve ((size_t) pairs.size());
+
+    for (const auto& pair : pairs)
+    {
+        const auto values = juce::StringArray::fromTokens (pair, ":", {});
+        if (values.size() != 2)
+            return {};
+
+        Point point;
+        point.chartSeconds = values[0].getDoubleValue();
+        point.audioSeconds = values[1].getDoubleValue();
+
+        // map() y getSlope() dividen entre la distancia de puntos consecutivos
+        if (!points.empty() && point.chartSeconds <= points.back().chartSeconds)
+            return {};
+
+        points.push_back (point);
+    }
+
+    return WarpMap (std::move (points));
+}
+
+void AudioAligner::WarpMap::applyTo (juce::MidiFile& midiFile) const
+{
+    if (isEmpty() || midiFile.getNumTracks() == 0)
+        return;
+
+    // Tempo original de cada tramo, antes de mover nada
+    std::vector<BeatGrid::TempoChange> tempoChanges;
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+        for (const auto* event : *midiFile.getTrack (track))
+            if (event->message.isTempoMetaEvent())
+                tempoChanges.push_back ({ event->message.getTimeStamp(), event->message.getTempoSecondsPerQuarterNote() });
+
+    std::stable_sort (tempoChanges.begin(), tempoChanges.end(),
+                      [] (const BeatGrid::TempoChange& a, const BeatGrid::TempoChange& b) { return a.seconds < b.seconds; });
+
+    if (tempoChanges.empty() || tempoChanges.front().seconds > 0.0)
+        tempoChanges.insert (tempoChanges.begin(), { 0.0, 0.5 });   // 120 BPM, el valor por defecto del SMF
+
+    // El tempo nuevo cambia en cada cambio original y en cada punto del mapa: en cada
+    // tramo, las negras duran lo mismo que antes multiplicado por la pendiente
+    std::vector<double> breakpoints;
+
+    for (const auto& change : tempoChanges)
+        breakpoints.push_back (change.seconds);
+
+    for (const auto& point : points)
+        breakpoints.push_back (point.chartSeconds);
+
+    std::sort (breakpoints.begin(), breakpoints.end());
+    breakpoints.erase (std::unique (breakpoints.begin(), breakpoints.end()), breakpoints.end());
+
+    // Si la carta empieza antes que la grabación, los primeros tiempos salen negativos: toda la
+    // canción se retrasa lo necesario en lugar de amontonar esos eventos en el cero
+    double earliest = 0.0;
+
+    for (auto seconds : breakpoints)
+        earliest = juce::jmin (earliest, map (seconds));
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+        for (const auto* event : *midiFile.getTrack (track))
+            earliest = juce::jmin (earliest, map (event->message.getTimeStamp()));
+
+    const double offset = -earliest;
+
+    juce::MidiFile warped;
+    const auto timeFormat = midiFile.getTimeFormat();
+
+    if (timeFormat > 0)
+        warped.setTicksPerQuarterNote (timeFormat);
+    else
+        warped.setSmpteTimeFormat (-(timeFormat >> 8), timeFormat & 0xff);
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    {
+        juce::MidiMessageSequence sequence;
+
+        for (const auto* event : *midiFile.getTrack (track))
+        {
+            if (event->message.isTempoMetaEvent())
+                continue;
+
+            auto message = event->message;
+            message.setTimeStamp (map (message.getTimeStamp()) + offset);
+            sequence.addEvent (message);
+        }
+
+        if (track == 0)
+        {
+            size_t change = 0;
+            int lastMicroseconds = -1;
+
+            for (auto seconds : breakpoints)
+            {
+                while (change + 1 < tempoChanges.size() && tempoChanges[change + 1].seconds <= seconds)
+                    ++change;
+
+                const double secondsPerQuarter = tempoChanges[change].secondsPerQuarter * getSlope (seconds);
+                const int microseconds = juce::jlimit (1, 0xffffff, juce::roundToInt (secondsPerQuarter * 1000000.0));
+
+                if (microseconds == lastMicroseconds)
+                    continue;
+
+                auto message = juce::MidiMessage::tempoMetaEvent (microseconds);
+                message.setTimeStamp (map (seconds) + offset);
+                sequence.addEvent (message);
+                lastMicroseconds = microseconds;
+            }
+        }
+
+        sequence.updateMatchedPairs();
+        warped.addTrack (sequence);
+    }
+
+    midiFile = warped;
+}
+
+//==============================================================================
+AudioAligner::AudioAligner (const Options& alignerOptions)
+    : options (alignerOptions)
+{
+}
+
+bool AudioAligner::align (const juce::File& audioFile, const PreparedSong& song, Result& result, juce::String& error) const
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    if (song.getNotes().size() == 0)
+    {
+        error = "La canción no tiene notas";
+        return false;
+    }
+
+    Features audio, chart;
+    double frameSeconds = options.hopSeconds;
+
+    if (!readAudioFeatures (audioFile, audio, frameSeconds, error))
+        return false;
+
+    if (shouldExit (error))
+        return false;
+
+    getChartFeatures (song, frameSeconds, chart);
+
+    const int leadFrames = juce::roundToInt (leadSeconds / frameSeconds);
+    const int smoothingFrames = juce::jmax (1, juce::roundToInt (smoothingSeconds / frameSeconds));
+
+    const int chartStart = prepareFeatures (chart, leadFrames, smoothingFrames);
+    const int audioStart = prepareFeatures (audio, leadFrames, smoothingFrames);
+
+    if (audioStart < 0)
+    {
+        error = "La grabación está en silencio";
+        return false;
+    }
+
+    std::vector<double> path;
+    if (chartStart < 0 || !findPath (chart, audio, path, result.cells, error))
+        return false;
+
+    // La DTW avanza a saltos: media móvil y pendiente mínima para que el mapa sea invertible
+    const int numFrames = (int) path.size();
+    const int radius = juce::jmax (1, juce::roundToInt (0.5 * pathSmoothingSeconds / frameSeconds));
+
+    std::vector<double> prefix ((size_t) numFrames + 1, 0.0);
+    for (int i = 0; i < numFrames; ++i)
+        prefix[(size_t) i + 1] = prefix[(size_t) i] + path[(size_t) i];
+
+    std::vector<double> smoothed ((size_t) numFrames);
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const int first = juce::jmax (0, i - radius);
+        const int end = juce::jmin (numFrames, i + radius + 1);
+        smoothed[(size_t) i] = (prefix[(size_t) end] - prefix[(size_t) first]) / (end - first);
+
+        if (i > 0)
+            smoothed[(size_t) i] = juce::jmax (smoothed[(size_t) i], smoothed[(size_t) i - 1] + minimumPathSlope);
+    }
+
+    std::vector<WarpMap::Point> points;
+    const int step = juce::jmax (1, juce::roundToInt (pointSeconds / frameSeconds));
+
+    for (int i = 0; i < numFrames; i += step)
+        points.push_back ({ (chartStart + i) * frameSeconds, (audioStart + smoothed[(size_t) i]) * frameSeconds });
+
+    if ((numFrames - 1) % step != 0)
+        points.push_back ({ (chartStart + numFrames - 1) * frameSeconds, (audioStart + smoothed.back()) * frameSeconds });
+
+    result.warp = WarpMap (std::move (points));
+    result.chartFrames = numFrames;
+    result.audioFrames = (int) audio[0].size();
+    result.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    return true;
+}
+
+PreparedSong::Ptr AudioAligner::alignMidiFile (const juce::File& midiFile, const juce::File& audioFile,
+                                               juce::String& error, Result* result) const
+{
+    juce::MidiFile midi;
+    if (!PreparedSong::readMidiFile (midiFile, midi))
+    {
+        error = "No se pudo leer el archivo MIDI " + midiFile.getFileName();
+        return nullptr;
+    }
+
+    Result localResult;
+    auto& alignment = result != nullptr ? *result : localResult;
+
+    if (!align (audioFile, *PreparedSong::build (midi), alignment, error))
+        return nullptr;
+
+    alignment.warp.applyTo (midi);
+    return PreparedSong::build (midi);
+}
+
+PreparedSong::Ptr AudioAligner::applyWarp (const juce::File& midiFile, const WarpMap& warp, juce::String& error)
+{
+    juce::MidiFile midi;
+    if (!PreparedSong::readMidiFile (midiFile, midi))
+    {
+        error = "No se pudo leer el archivo MIDI " + midiFile.getFileName();
+        return nullptr;
+    }
+
+    warp.applyTo (midi);
+    return PreparedSong::build (midi);
+}
+
+bool AudioAligner::shouldExit (juce::String& error) const
+{
+    if (options.shouldExit == nullptr || !options.shouldExit())
+        return false;
+
+    error = "Alineación cancelada";
+    return true;
+}
+
+//==============================================================================
+bool AudioAligner::readAudioFeatures (const juce::File& audioFile, Features& features, double& frameSeconds, juce::String& error) const
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (audioFile));
+    if (reader == nullptr || reader->sampleRate <= 0.0)
+    {
+        error = "No se pudo leer la grabación " + audioFile.getFileName();
+        return false;
+    }
+
+    const double sampleRate = reader->sampleRate;
+    const int hop = juce::jmax (1, juce::roundToInt (options.hopSeconds * sampleRate));
+    const auto numFrames = reader->lengthInSamples / hop;
+
+    if (numFrames < 2 || numFrames > maximumFrames)
+    {
+        error = "La grabación es demasiado corta o demasiado larga";
+        return false;
+    }
+
+    frameSeconds = hop / sampleRate;
+
+    // Graves (bombo, timbales), medios (caja) y agudos (charles, platos)
+    std::array<juce::IIRFilter, numBands> filters;
+    filters[0].setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, 150.0));
+    filters[1].setCoefficients (juce::IIRCoefficients::makeBandPass (sampleRate, 800.0, 0.7));
+    filters[2].setCoefficients (juce::IIRCoefficients::makeHighPass (sampleRate, juce::jmin (5000.0, sampleRate * 0.45)));
+
+    constexpr int framesPerBlock = 64;
+    const int numChannels = juce::jlimit (1, 2, (int) reader->numChannels);
+    juce::AudioBuffer<float> block (numChannels, hop * framesPerBlock);
+    juce::AudioBuffer<float> band (1, hop * framesPerBlock);
+
+    for (auto& values : features)
+        values.assign ((size_t) numFrames, 0.0f);
+
+    for (int frame = 0; frame < (int) numFrames; frame += framesPerBlock)
+    {
+        if (shouldExit (error))
+            return false;
+
+        const int count = juce::jmin (framesPerBlock, (int) numFrames - frame);
+        const int numSamples = count * hop;
+
+        reader->read (&block, 0, numSamples, (juce::int64) frame * hop, true, numChannels > 1);
+
+        if (numChannels > 1)
+        {
+            block.addFrom (0, 0, block, 1, 0, numSamples);
+            block.applyGain (0, 0, numSamples, 0.5f);
+        }
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            band.copyFrom (0, 0, block, 0, 0, numSamples);
+            filters[(size_t) b].processSamples (band.getWritePointer (0), numSamples);
+
+            for (int i = 0; i < count; ++i)
+                features[(size_t) b][(size_t) (frame + i)] = std::log1p (energyCompression * band.getRMSLevel (0, i * hop, hop));
+        }
+    }
+
+    // Solo interesan las subidas de energía (los ataques)
+    for (auto& values : features)
+    {
+        for (size_t i = values.size() - 1; i > 0; --i)
+            values[i] = juce::jmax (0.0f, values[i] - values[i - 1]);
+
+        values[0] = 0.0f;
+    }
+
+    return true;
+}
+
+void AudioAligner::getChartFeatures (const PreparedSong& song, double frameSeconds, Features& features)
+{
+    const auto numFrames = (size_t) std::ceil (song.getSummary().lengthSeconds / frameSeconds) + 1;
+
+    for (auto& values : features)
+        values.assign (numFrames, 0.0f);
+
+    song.getNotes().visit (0, [&] (const SongNote& note)
+    {
+        const auto frame = (size_t) juce::jmax (0, juce::roundToInt (note.time / frameSeconds));
+
+        if (frame < numFrames)
+            features[(size_t) getBandForNote (note.noteNumber)][frame] += note.velocity / 127.0f;
+
+        return true;
+    });
+}
+
+int AudioAligner::prepareFeatures (Features& features, int leadFrames, int smoothingFrames)
+{
+    const int numFrames = (int) features[0].size();
+    std::vector<float> smoothed ((size_t) numFrames);
+    std::vector<float> activity ((size_t) numFrames, 0.0f);
+
+    for (auto& values : features)
+    {
+        // Ventana triangular: tolera pequeños desfases entre ataques
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float sum = 0.0f, weights = 0.0f;
+
+            for (int k = juce::jmax (0, i - smoothingFrames); k <= juce::jmin (numFrames - 1, i + smoothingFrames); ++k)
+            {
+                const float weight = (float) (smoothingFrames + 1 - std::abs (k - i));
+                sum += values[(size_t) k] * weight;
+                weights += weight;
+            }
+
+            smoothed[(size_t) i] = sum / weights;
+        }
+
+        std::swap (values, smoothed);
+
+        // Cada banda en 0..1 para que ninguna domine el coste
+        const float maximum = juce::FloatVectorOperations::findMaximum (values.data(), numFrames);
+        if (maximum > 0.0f)
+            juce::FloatVectorOperations::multiply (values.data(), 1.0f / maximum, numFrames);
+
+        juce::FloatVectorOperations::add (activity.data(), values.data(), numFrames);
+    }
+
+    // Recortar silencios del principio y del final, que la DTW alinearía con cualquier cosa
+    const float threshold = 0.1f * juce::FloatVectorOperations::findMaximum (activity.data(), numFrames);
+    if (threshold <= 0.0f)
+        return -1;
+
+    int first = 0, last = numFrames - 1;
+
+    while (activity[(size_t) first] < threshold)
+        ++first;
+
+    while (activity[(size_t) last] < threshold)
+        --last;
+
+    const int start = juce::jmax (0, first - leadFrames);
+    const int end = juce::jmin (numFrames, last + leadFrames + 1);
+
+    for (auto& values : features)
+    {
+        values.erase (values.begin() + end, values.end());
+        values.erase (values.begin(), values.begin() + start);
+    }
+
+    return start;
+}
+
+//==============================================================================
+bool AudioAligner::findPath (const Features& chart, const Features& audio, std::vector<double>& audioFrameForChart,
+                             size_t& cells, juce::String& error) const
+{
+    const int numRows = (int) chart[0].size();          // Frames de la carta
+    const int numColumns = (int) audio[0].size();       // Frames de la grabación
+    const double slope = (numColumns - 1) / (double) juce::jmax (1, numRows - 1);
+
+    if (numRows < 2 || numColumns < 2 || slope > maximumLengthRatio || slope < 1.0 / maximumLengthRatio)
+    {
+        error = "La grabación y la carta tienen duraciones demasiado distintas";
+        return false;
+    }
+
+    // Banda alrededor de la diagonal, recortada si no cabe en maximumCells
+    const double frameSeconds = options.hopSeconds;
+    int radius = juce::roundToInt (juce::jmax (options.bandSeconds / frameSeconds, options.bandFraction * numColumns));
+    radius = (int) juce::jmin ((size_t) radius, (options.maximumCells / (size_t) numRows - 1) / 2);
+
+    if (radius < (int) std::ceil (slope) + 1)
+    {
+        error = "La canción es demasiado larga para alinearla";
+        return false;
+    }
+
+    const int width = 2 * radius + 1;
+    std::vector<int> lo ((size_t) numRows), hi ((size_t) numRows);
+
+    for (int i = 0; i < numRows; ++i)
+    {
+        const int centre = juce::roundToInt (i * slope);
+        lo[(size_t) i] = juce::jmax (0, centre - radius);
+        hi[(size_t) i] = juce::jmin (numColumns - 1, centre + radius);
+    }
+
+    // Coste acumulado de la banda: fila i, columna j en [i * width + j - lo[i]]
+    juce::HeapBlock<float> accumulated ((size_t) numRows * (size_t) width);
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+
+    auto computeTile = [&] (int tileRow, int tileColumn)
+    {
+        float local[tileSize], difference[tileSize];
+        const int firstColumn = tileColumn * tileSize;
+        const int endRow = juce::jmin (numRows, (tileRow + 1) * tileSize);
+
+        for (int i = tileRow * tileSize; i < endRow; ++i)
+        {
+            const int rowLo = lo[(size_t) i];
+            const int start = juce::jmax (firstColumn, rowLo);
+            const int end = juce::jmin (firstColumn + tileSize, hi[(size_t) i] + 1);
+
+            if (start >= end)
+                continue;
+
+            // Coste local: distancia L1 entre las bandas del frame i de la carta y las de la grabación
+            const int count = end - start;
+            juce::FloatVectorOperations::add (local, audio[0].data() + start, -chart[0][(size_t) i], count);
+            juce::FloatVectorOperations::abs (local, local, count);
+
+            for (int b = 1; b < numBands; ++b)
+            {
+                juce::FloatVectorOperations::add (difference, audio[(size_t) b].data() + start, -chart[(size_t) b][(size_t) i], count);
+                juce::FloatVectorOperations::abs (difference, difference, count);
+                juce::FloatVectorOperations::add (local, difference, count);
+            }
+
+            auto* row = accumulated.get() + (size_t) i * (size_t) width;
+            const auto* above = i > 0 ? accumulated.get() + (size_t) (i - 1) * (size_t) width : nullptr;
+            const int aboveLo = i > 0 ? lo[(size_t) i - 1] : 0;
+            const int aboveHi = i > 0 ? hi[(size_t) i - 1] : -1;
+
+            for (int j = start; j < end; ++j)
+            {
+                float best = (i == 0 && j == 0) ? 0.0f : infinity;
+
+                if (j > rowLo)
+                    best = juce::jmin (best, row[j - 1 - rowLo]);
+
+                if (j >= aboveLo && j <= aboveHi)
+                    best = juce::jmin (best, above[j - aboveLo]);
+
+                if (j > aboveLo && j - 1 <= aboveHi)
+                    best = juce::jmin (best, above[j - 1 - aboveLo]);
+
+                row[j - rowLo] = local[j - start] + best;
+            }
+        }
+    };
+
+    // Por antidiagonales de bloques: cada bloque depende solo del de la izquierda, el de arriba
+    // y el de arriba a la izquierda, que están en antidiagonales anteriores
+    const int numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    const int numTileRows = (numRows + tileSize - 1) / tileSize;
+    const int numTileColumns = (numColumns + tileSize - 1) / tileSize;
+
+    juce::ThreadPool pool (numThreads);
+    std::vector<std::pair<int, int>> tiles;
+
+    for (int wave = 0; wave < numTileRows + numTileColumns - 1; ++wave)
+    {
+        if (shouldExit (error))
+            return false;
+
+        tiles.clear();
+
+        for (int tileRow = juce::jmax (0, wave - numTileColumns + 1); tileRow <= juce::jmin (wave, numTileRows - 1); ++tileRow)
+        {
+            const int tileColumn = wave - tileRow;
+            const int firstRow = tileRow * tileSize;
+            const int lastRow = juce::jmin (numRows, firstRow + tileSize) - 1;
+
+            if (tileColumn * tileSize <= hi[(size_t) lastRow] && (tileColumn + 1) * tileSize > lo[(size_t) firstRow])
+                tiles.emplace_back (tileRow, tileColumn);
+        }
+
+        parallelFor (pool, numThreads, (int) tiles.size(), [&] (int index)
+        {
+            computeTile (tiles[(size_t) index].first, tiles[(size_t) index].second);
+        });
+    }
+
+    cells = 0;
+    for (int i = 0; i < numRows; ++i)
+        cells += (size_t) (hi[(size_t) i] - lo[(size_t) i] + 1);
+
+    auto getCost = [&] (int i, int j)
+    {
+        if (j < lo[(size_t) i] || j > hi[(size_t) i])
+            return infinity;
+
+        return accumulated[(size_t) i * (size_t) width + (size_t) (j - lo[(size_t) i])];
+    };
+
+    if (!std::isfinite (getCost (numRows - 1, numColumns - 1)))
+    {
+        error = "No se encontró ninguna alineación";
+        return false;
+    }
+
+    // Camino desde el final; cada frame de la carta se queda con la media de sus columnas
+    std::vector<double> sums ((size_t) numRows, 0.0);
+    std::vector<int> counts ((size_t) numRows, 0);
+
+    for (int i = numRows - 1, j = numColumns - 1;;)
+    {
+        sums[(size_t) i] += j;
+        ++counts[(size_t) i];
+
+        if (i == 0 && j == 0)
+            break;
+
+        if (i == 0)
+        {
+            --j;
+            continue;
+        }
+
+        if (j == 0)
+        {
+            --i;
+            continue;
+        }
+
+        const float diagonal = getCost (i - 1, j - 1);
+        const float up = getCost (i - 1, j);
+        const float left = getCost (i, j - 1);
+
+        if (diagonal <= up && diagonal <= left)
+        {
+            --i;
+            --j;
+        }
+        else if (up <= left)
+        {
+            --i;
+        }
+        else
+        {
+            --j;
+        }
+    }
+
+    audioFrameForChart.resize ((size_t) numRows);
+    for (int i = 0; i < numRows; ++i)
+        audioFrameForChart[(size_t) i] = sums[(size_t) i] / counts[(size_t) i];
+
+    return true;
+}
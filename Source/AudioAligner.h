@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    AudioAligner.h
+    Alineación de la carta MIDI con una grabación de la canción.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreparedSong.h"
+
+//==============================================================================
+/**
+    Ajusta los tiempos de una carta a una grabación cuyo tempo no coincide
+    exactamente con el del MIDI (versiones en directo, tempo humano...).
+
+    Las dos partes se reducen a secuencias de ataques por banda (graves, medios
+    y agudos) con un paso de hopSeconds: de la grabación, el flujo positivo de
+    energía de tres filtros IIR; de la carta, impulsos en las notas según su
+    pieza de batería. Después se busca el camino de mínimo coste entre ambas
+    (DTW) dentro de una banda alrededor de la diagonal, con la matriz de costes
+    acotada a maximumCells celdas. La matriz se calcula en bloques de
+    tileSize x tileSize por antidiagonales: los bloques de una misma
+    antidiagonal son independientes y se reparten entre hilos, y el coste
+    local de cada fila se calcula con FloatVectorOperations.
+
+    El resultado es un WarpMap (tiempo de la carta -> tiempo de la grabación)
+    que se aplica al MidiFile antes de construir la PreparedSong, así que notas,
+    densidad y rejilla de compases siguen a la grabación.
+*/
+class AudioAligner
+{
+public:
+    struct Options
+    {
+        double hopSeconds = 0.01;           // Resolución de las secuencias
+        double bandSeconds = 4.0;           // Desviación mínima permitida respecto a la diagonal
+        double bandFraction = 0.1;          // ... o esta fracción de la grabación, si es mayor
+        size_t maximumCells = (size_t) 1 << 25;    // 128 MB de costes acumulados como mucho
+        int numThreads = 0;                 // 0 = uno por núcleo
+
+        // Si devuelve true (p. ej. al cerrar el plugin) la alineación se abandona con error.
+        // Se consulta desde el hilo que alinea entre bloques de trabajo.
+        std::function<bool()> shouldExit;
+    };
+
+    //==============================================================================
+    // Correspondencia monótona entre tiempos de la carta y de la grabación
+    class WarpMap
+    {
+    public:
+        struct Point
+        {
+            double chartSeconds = 0.0;
+            double audioSeconds = 0.0;
+        };
+
+        WarpMap() = default;
+        explicit WarpMap (std::vector<Point> points);
+
+        bool isEmpty() const                            { return points.size() < 2; }
+        const std::vector<Point>& getPoints() const     { return points; }
+
+        // Interpolación lineal entre puntos; fuera de ellos, con la pendiente media
+        double map (double chartSeconds) const;
+
+        // Segundos de grabación por segundo de carta en el tramo que empieza en chartSeconds
+        double getSlope (double chartSeconds) const;
+
+        // Mueve los eventos de un MidiFile con tiempos en segundos y reescribe los
+        // cambios de tempo para que la rejilla de compases siga a la grabación. Si algún
+        // tiempo queda antes del cero, toda la canción se retrasa en vez de recortarlo.
+        void applyTo (juce::MidiFile& midiFile) const;
+
+        // Para el estado del plugin: pares "carta:grabación" separados con ';'.
+        // Un texto mal formado da un WarpMap vacío.
+        juce::String toString() const;
+        static WarpMap fromString (const juce::String& text);
+
+    private:
+        double getAverageSlope() const;
+
+        std::vector<Point> points;              // chartSeconds estrictamente creciente
+    };
+
+    struct Result
+    {
+        WarpMap warp;
+        int chartFrames = 0;
+        int audioFrames = 0;
+        size_t cells = 0;                       // Celdas de la banda calculadas
+        double seconds = 0.0;                   // Tiempo total de la alineación
+    };
+
+    explicit AudioAligner (const Options& options = {});
+
+    // Alinea la canción con la grabación. Devuelve false con el motivo en error si no se pudo.
+    bool align (const juce::File& audioFile, const PreparedSong& song, Result& result, juce::String& error) const;
+
+    // Lee el SMF, lo alinea con la grabación y construye la canción ya ajustada (nullptr si falla)
+    PreparedSong::Ptr alignMidiFile (const juce::File& midiFile, const juce::File& audioFile,
+                                     juce::String& error, Result* result = nullptr) const;
+
+    // Vuelve a construir una canción ya alineada (p. ej. al restaurar la sesión) sin repetir la alineación
+    static PreparedSong::Ptr applyWarp (const juce::File& midiFile, const WarpMap& warp, juce::String& error);
+
+    static constexpr int numBands = 3;
+    static constexpr int tileSize = 64;
+
+private:
+    // Una secuencia por banda (planas, para operar sobre tramos contiguos)
+    using Features = std::array<std::vector<float>, numBands>;
+
+    // frameSeconds: duración exacta de cada frame (un número entero de muestras)
+    bool readAudioFeatures (const juce::File& audioFile, Features& features, double& frameSeconds, juce::String& error) const;
+    static void getChartFeatures (const PreparedSong& song, double frameSeconds, Features& features);
+
+    // Suaviza, normaliza y recorta a la zona con actividad; devuelve el primer frame conservado
+    static int prepareFeatures (Features& features, int leadFrames, int smoothingFrames);
+
+    // Camino de mínimo coste: para cada frame de chart, frame medio de audio
+    bool findPath (const Features& chart, const Features& audio, std::vector<double>& audioFrameForChart,
+                   size_t& cells, juce::String& error) const;
+
+    bool shouldExit (juce::String& error) const;
+
+    Options options;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioAligner)
+};
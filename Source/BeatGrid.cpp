@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    BeatGrid.cpp
+    Rejilla de compases, tiempos y subdivisiones según el mapa de tempo y compás.
+
+  ==============================================================================
+*/
+
+#include "BeatGrid.h"
+
+//==============================================================================
+BeatGrid::BeatGrid()
+{
+    clear();
+}
+
+void BeatGrid::clear()
+{
+    tempoSegments.assign (1, TempoSegment());
+    lines.clear();
+}
+
+void BeatGrid::build (std::vector<TempoChange> tempoChanges, std::vector<MeterChange> meterChanges, double lengthSeconds)
+{
+    clear();
+
+    const auto bySeconds = [] (const auto& a, const auto& b) { return a.seconds < b.seconds; };
+    std::stable_sort (tempoChanges.begin(), tempoChanges.end(), bySeconds);
+    std::stable_sort (meterChanges.begin(), meterChanges.end(), bySeconds);
+
+    // Mapa de tempo: la negra de inicio de cada tramo se obtiene del tramo anterior
+    for (const auto& change : tempoChanges)
+    {
+        if (change.secondsPerQuarter <= 0.0)
+            continue;
+
+        auto& last = tempoSegments.back();
+
+        // Varios cambios en el mismo instante: gana el último
+        if (change.seconds <= last.startSeconds)
+        {
+            last.secondsPerQuarter = change.secondsPerQuarter;
+            continue;
+        }
+
+        TempoSegment segment;
+        segment.startSeconds = change.seconds;
+        segment.startQuarter = last.startQuarter + (change.seconds - last.startSeconds) / last.secondsPerQuarter;
+        segment.secondsPerQuarter = change.secondsPerQuarter;
+        tempoSegments.push_back (segment);
+    }
+
+    // Mapa de compás en semicorcheas; cada cambio empieza un compás nuevo
+    std::vector<MeterSegment> meterSegments (1);
+
+    for (const auto& change : meterChanges)
+    {
+        if (change.numerator <= 0 || change.denominator <= 0)
+            continue;
+
+        MeterSegment segment;
+        segment.startStep = (juce::int64) std::llround (secondsToQuarter (change.seconds) * stepsPerQuarter);
+        segment.stepsPerBar = juce::jmax (1, change.numerator * stepsPerQuarter * 4 / change.denominator);
+        segment.stepsPerBeat = juce::jmax (1, stepsPerQuarter * 4 / change.denominator);
+
+        if (segment.startStep <= meterSegments.back().startStep)
+            meterSegments.back() = segment;
+        else
+            meterSegments.push_back (segment);
+    }
+
+    const auto numSteps = (juce::int64) std::ceil (secondsToQuarter (juce::jmax (0.0, lengthSeconds)) * stepsPerQuarter) + 1;
+    lines.reserve ((size_t) juce::jmin ((juce::int64) maximumLines, numSteps));
+
+    // Cada línea se coloca por su índice entero dentro de su tramo (sin sumar intervalos)
+    size_t tempoIndex = 0;
+    size_t meterIndex = 0;
+
+    for (juce::int64 step = 0; step < numSteps && lines.size() < maximumLines; ++step)
+    {
+        const double quarter = (double) step / stepsPerQuarter;
+
+        while (tempoIndex + 1 < tempoSegments.size() && tempoSegments[tempoIndex + 1].startQuarter <= quarter)
+            ++tempoIndex;
+
+        while (meterIndex + 1 < meterSegments.size() && meterSegments[meterIndex + 1].startStep <= step)
+            ++meterIndex;
+
+        const auto& tempo = tempoSegments[tempoIndex];
+        const auto& meter = meterSegments[meterIndex];
+        const juce::int64 stepInMeter = step - meter.startStep;
+
+        Line line;
+        line.time = tempo.startSeconds + (quarter - tempo.startQuarter) * tempo.secondsPerQuarter;
+        line.type = stepInMeter % meter.stepsPerBar == 0    ? LineType::bar
+                  : stepInMeter % meter.stepsPerBeat == 0   ? LineType::beat
+                                                            : LineType::subdivision;
+        line.division = step % stepsPerQuarter == 0         ? 4
+                      : step % (stepsPerQuarter / 2) == 0   ? 8
+                                                            : 16;
+        lines.push_back (line);
+    }
+}
+
+//==============================================================================
+std::pair<size_t, size_t> BeatGrid::findLines (double startSeconds, double endSeconds) const
+{
+    const auto first = std::lower_bound (lines.begin(), lines.end(), startSeconds,
+                                         [] (const Line& line, double time) { return line.time < time; });
+    const auto last = std::upper_bound (first, lines.end(), endSeconds,
+                                        [] (double time, const Line& line) { return time < line.time; });
+
+    return { (size_t) std::distance (lines.begin(), first), (size_t) std::distance (lines.begin(), last) };
+}
+
+double BeatGrid::quarterToSeconds (double quarter) const
+{
+    const auto& segment = getSegmentForQuarter (quarter);
+    return segment.startSeconds + (quarter - segment.startQuarter) * segment.secondsPerQuarter;
+}
+
+double BeatGrid::secondsToQuarter (double seconds) const
+{
+    const auto& segment = getSegmentForSeconds (seconds);
+    return segment.startQuarter + (seconds - segment.startSeconds) / segment.secondsPerQuarter;
+}
+
+const BeatGrid::TempoSegment& BeatGrid::getSegmentForQuarter (double quarter) const
+{
+    // Último tramo que empieza en o antes de la negra pedida
+    auto found = std::upper_bound (tempoSegments.begin() + 1, tempoSegments.end(), quarter,
+                                   [] (double q, const TempoSegment& segment) { return q < segment.startQuarter; });
+    return *(found - 1);
+}
+
+const BeatGrid::TempoSegment& BeatGrid::getSegmentForSeconds (double seconds) const
+{
+    auto found = std::upper_bound (tempoSegments.begin() + 1, tempoSegments.end(), seconds,
+                                   [] (double s, const TempoSegment& segment) { return s < segment.startSeconds; });
+    return *(found - 1);
+}
+
+size_t BeatGrid::getMemoryBytes() const
+{
+    return tempoSegments.capacity() * sizeof (TempoSegment) + lines.capacity() * sizeof (Line);
+}
+
+int BeatGrid::getDivisionForTimeFigure (const juce::String& timeFigure)
+{
+    const int denominator = timeFigure.fromFirstOccurrenceOf ("/", false, false).getIntValue();
+    return denominator == 8 || denominator == 16 ? denominator : 4;
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    BeatGrid.h
+    Rejilla de compases, tiempos y subdivisiones según el mapa de tempo y compás.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Posiciones precalculadas de las líneas de compás, de tiempo (según el
+    denominador del compás) y de subdivisión hasta semicorcheas. Cada línea se
+    calcula a partir de su índice entero de semicorchea dentro del tramo de tempo
+    que le corresponde, así que no hay error acumulado por sumas sucesivas.
+    Las líneas quedan ordenadas por tiempo para extraer el tramo visible con una
+    búsqueda binaria.
+*/
+class BeatGrid
+{
+public:
+    enum class LineType : juce::uint8
+    {
+        bar,            // Inicio de compás
+        beat,           // Tiempo del compás (p. ej. negra en 4/4, corchea en 6/8)
+        subdivision     // Resto de negras, corcheas y semicorcheas
+    };
+
+    struct Line
+    {
+        double time = 0.0;          // Segundos desde el inicio del archivo
+        LineType type = LineType::subdivision;
+        juce::uint8 division = 4;   // Figura más larga en la que cae: 4, 8 o 16
+    };
+
+    // Cambios tal y como aparecen en el MIDI, con tiempos ya en segundos
+    struct TempoChange
+    {
+        double seconds = 0.0;
+        double secondsPerQuarter = 0.5;
+    };
+
+    struct MeterChange
+    {
+        double seconds = 0.0;
+        int numerator = 4;
+        int denominator = 4;
+    };
+
+    BeatGrid();
+
+    // Construye la rejilla hasta lengthSeconds. Sin cambios se asume 120 BPM y 4/4 (valores por defecto del SMF).
+    void build (std::vector<TempoChange> tempoChanges, std::vector<MeterChange> meterChanges, double lengthSeconds);
+    void clear();
+
+    const std::vector<Line>& getLines() const   { return lines; }
+
+    // Rango [first, last) de las líneas con time dentro de [startSeconds, endSeconds]
+    std::pair<size_t, size_t> findLines (double startSeconds, double endSeconds) const;
+
+    // Conversión entre segundos y negras siguiendo el mapa de tempo
+    double quarterToSeconds (double quarter) const;
+    double secondsToQuarter (double seconds) const;
+
+    // Denominador de la figura elegida en el editor ("1/4", "1/8", "1/16"); 4 si no se reconoce
+    static int getDivisionForTimeFigure (const juce::String& timeFigure);
+
+    size_t getMemoryBytes() const;
+
+    // Compases y tiempos se muestran siempre; las subdivisiones solo hasta la figura elegida
+    static bool isVisible (const Line& line, int division)
+    {
+        return line.type != LineType::subdivision || line.division <= division;
+    }
+
+    static constexpr int stepsPerQuarter = 4;           // Resolución de la rejilla: semicorcheas
+    static constexpr size_t maximumLines = 1 << 20;     // Cota de memoria para archivos patológicos
+
+private:
+    friend class SongCacheFile;   // Lee y escribe los arrays en bloque
+
+    struct TempoSegment
+    {
+        double startSeconds = 0.0;
+        double startQuarter = 0.0;
+        double secondsPerQuarter = 0.5;
+    };
+
+    struct MeterSegment
+    {
+        juce::int64 startStep = 0;
+        int stepsPerBar = 16;
+        int stepsPerBeat = 4;
+    };
+
+    const TempoSegment& getSegmentForQuarter (double quarter) const;
+    const TempoSegment& getSegmentForSeconds (double seconds) const;
+
+    std::vector<TempoSegment> tempoSegments;    // Nunca vacío; el primero empieza en 0
+    std::vector<Line> lines;                    // Ordenadas por tiempo
+
+    JUCE_LEAK_DETECTOR (BeatGrid)
+};
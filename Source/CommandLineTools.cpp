@@ -0,0 +1,395 @@
+/*
+  ==============================================================================
+
+    CommandLineTools.cpp
+    Modos sin interfaz de la aplicación Standalone (benchmarks, etc.).
+
+  ==============================================================================
+*/
+
+#include "CommandLineTools.h"
+#include "LoadBenchmark.h"
+#include "StressChartGenerator.h"
+#include "VideoExporter.h"
+#include "MidiLibrary.h"
+#include "AudioAligner.h"
+#include "PluginProcessor.h"
+
+#include <cstdio>
+#include <iostream>
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+namespace
+{
+    struct Command
+    {
+        const char* option;
+        int (*function) (const juce::ArgumentList&);
+        const char* description;
+    };
+
+    const Command commands[] =
+    {
+        { "--benchmark", CommandLineTools::runBenchmark,
+          "--benchmark [--corpus=<dir>] [--sizes=500,50000,1000000,4000000] [--min-time=0.25]" },
+        { "--generate-chart", CommandLineTools::runGenerateChart,
+          "--generate-chart --out=<archivo.mid> [--seed=1] [--tracks=1] [--length=180] [--bpm=120] [--bpm-max=120]\n"
+          "                   [--tempo-changes=0] [--steps=4] [--keys=3] [--density=1] [--cc=0] [--ppq=960]" },
+        { "--export-video", CommandLineTools::runExportVideo,
+          "--export-video=<archivo.mid> --out=<dir|archivo|-> [--format=png|rgba|y4m] [--fps=60]\n"
+          "                   [--size=1280x720] [--threads=0] [--bpm=<tempo del MIDI>] [--speed=1]" },
+        { "--scan-library", CommandLineTools::runScanLibrary,
+          "--scan-library[=<dir>] [--threads=0] [--query=<texto>] [--bpm-min=0] [--bpm-max=0]" },
+        { "--align-audio", CommandLineTools::runAlignAudio,
+          "--align-audio=<grabación> --midi=<archivo.mid> [--out=<mapa.csv>] [--threads=0] [--hop=0.01]" },
+    };
+
+    const Command* findCommand (const juce::ArgumentList& args)
+    {
+        for (const auto& command : commands)
+            if (args.containsOption (command.option))
+                return &command;
+
+        return nullptr;
+    }
+
+    void printText (const juce::String& text)
+    {
+        std::cout << text.toStdString() << std::flush;
+    }
+
+    // Los modos que escriben datos binarios en stdout informan por stderr
+    void printStatus (const juce::String& text)
+    {
+        std::cerr << text.toStdString() << std::flush;
+    }
+
+    // Salida estándar como OutputStream binario, para canalizar a otro programa
+    struct StandardOutputStream : public juce::OutputStream
+    {
+        StandardOutputStream()
+        {
+           #if JUCE_WINDOWS
+            _setmode (_fileno (stdout), _O_BINARY);
+           #endif
+        }
+
+        void flush() override                   { std::fflush (stdout); }
+        bool setPosition (juce::int64) override { return false; }
+        juce::int64 getPosition() override      { return position; }
+
+        bool write (const void* data, size_t numBytes) override
+        {
+            position += (juce::int64) numBytes;
+            return std::fwrite (data, 1, numBytes, stdout) == numBytes;
+        }
+
+        juce::int64 position = 0;
+    };
+
+    juce::File resolvePath (const juce::String& path)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (path);
+    }
+
+    double getDoubleOption (const juce::ArgumentList& args, const char* option, double defaultValue)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value.getDoubleValue() : defaultValue;
+    }
+
+    int getIntOption (const juce::ArgumentList& args, const char* option, int defaultValue)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value.getIntValue() : defaultValue;
+    }
+}
+
+//==============================================================================
+void CommandLineTools::launchIfRequested()
+{
+    static bool alreadyChecked = false;
+    if (alreadyChecked)
+        return;
+
+    alreadyChecked = true;
+
+    if (juce::JUCEApplicationBase::getInstance() == nullptr)
+        return;
+
+    juce::ArgumentList args (juce::File::getSpecialLocation (juce::File::currentExecutableFile).getFileName(),
+                             juce::JUCEApplicationBase::getCommandLineParameterArray());
+
+    if (findCommand (args) == nullptr)
+        return;
+
+    // Se difiere al bucle de mensajes para que la aplicación termine de inicializarse
+    juce::MessageManager::callAsync ([args]
+    {
+        const int exitCode = run (args);
+
+        if (auto* app = juce::JUCEApplicationBase::getInstance())
+            app->setApplicationReturnValue (exitCode);
+
+        juce::JUCEApplicationBase::quit();
+    });
+}
+
+int CommandLineTools::run (const juce::ArgumentList& args)
+{
+    if (const auto* command = findCommand (args))
+        return command->function (args);
+
+    juce::String usage ("Comandos disponibles:\n");
+    for (const auto& command : commands)
+        usage << "  " << command.description << juce::newLine;
+
+    printText (usage);
+    return 1;
+}
+
+//==============================================================================
+int CommandLineTools::runBenchmark (const juce::ArgumentList& args)
+{
+    LoadBenchmark benchmark;
+
+    const auto corpusPath = args.getValueForOption ("--corpus");
+    if (corpusPath.isNotEmpty())
+    {
+        const auto corpus = resolvePath (corpusPath);
+        if (corpus.isDirectory())
+            benchmark.addCorpusDirectory (corpus);
+        else
+            benchmark.addCorpusFile (corpus);
+    }
+
+    // Archivos sintéticos desde unos cientos hasta varios millones de eventos
+    auto sizes = juce::StringArray::fromTokens (args.getValueForOption ("--sizes"), ",", {});
+    sizes.removeEmptyStrings();
+    if (sizes.isEmpty())
+        sizes = { "500", "50000", "1000000", "4000000" };
+
+    for (const auto& size : sizes)
+        if (size.getIntValue() > 0)
+            benchmark.addSyntheticFile (size.getIntValue());
+
+    benchmark.setMinimumSecondsPerCase (getDoubleOption (args, "--min-time", 0.25));
+
+    if (benchmark.getNumCorpusFiles() == 0)
+    {
+        printText ("Error: el corpus está vacío\n");
+        return 1;
+    }
+
+    printText (LoadBenchmark::formatReport (benchmark.run()));
+    return 0;
+}
+
+int CommandLineTools::runGenerateChart (const juce::ArgumentList& args)
+{
+    const auto outPath = args.getValueForOption ("--out");
+    if (outPath.isEmpty())
+    {
+        printText ("Error: falta --out=<archivo.mid>\n");
+        return 1;
+    }
+
+    StressChartGenerator::Options options;
+    const auto seed = args.getValueForOption ("--seed");
+    options.seed = seed.isNotEmpty() ? seed.getLargeIntValue() : options.seed;
+    options.numTracks = getIntOption (args, "--tracks", options.numTracks);
+    options.lengthSeconds = getDoubleOption (args, "--length", options.lengthSeconds);
+    options.minBpm = getDoubleOption (args, "--bpm", options.minBpm);
+    options.maxBpm = getDoubleOption (args, "--bpm-max", options.minBpm);
+    options.tempoChangesPerMinute = getDoubleOption (args, "--tempo-changes", options.tempoChangesPerMinute);
+    options.stepsPerQuarter = getIntOption (args, "--steps", options.stepsPerQuarter);
+    options.numKeys = getIntOption (args, "--keys", options.numKeys);
+    options.hitProbability = getDoubleOption (args, "--density", options.hitProbability);
+    options.ccPerSecond = getDoubleOption (args, "--cc", options.ccPerSecond);
+    options.ticksPerQuarter = getIntOption (args, "--ppq", options.ticksPerQuarter);
+
+    const auto outFile = resolvePath (outPath);
+    if (!StressChartGenerator::writeToFile (options, outFile))
+    {
+        printText ("Error: no se pudo escribir " + outFile.getFullPathName() + "\n");
+        return 1;
+    }
+
+    printText ("Carta generada: " + outFile.getFullPathName()
+               + " (" + juce::String (outFile.getSize()) + " bytes)\n");
+    return 0;
+}
+
+int CommandLineTools::runExportVideo (const juce::ArgumentList& args)
+{
+    const auto midiPath = args.getValueForOption ("--export-video");
+    const auto outPath = args.getValueForOption ("--out");
+    if (midiPath.isEmpty() || outPath.isEmpty())
+    {
+        printStatus ("Error: uso --export-video=<archivo.mid> --out=<dir|archivo|->\n");
+        return 1;
+    }
+
+    DrumVisualizerAudioProcessor processor;
+    if (!processor.loadMidiFile (resolvePath (midiPath)))
+    {
+        printStatus ("Error: no se pudo cargar " + midiPath + "\n");
+        return 1;
+    }
+
+    VideoExporter::Options options;
+    options.framesPerSecond = getDoubleOption (args, "--fps", options.framesPerSecond);
+    options.numThreads = getIntOption (args, "--threads", options.numThreads);
+    options.viewState.bpm = getIntOption (args, "--bpm", (int) processor.getTempoFromMidi());
+    options.viewState.speed = (float) getDoubleOption (args, "--speed", 1.0);
+
+    const auto size = args.getValueForOption ("--size");
+    if (size.containsChar ('x'))
+    {
+        options.width = size.upToFirstOccurrenceOf ("x", false, true).getIntValue();
+        options.height = size.fromFirstOccurrenceOf ("x", false, true).getIntValue();
+    }
+
+    const auto format = args.getValueForOption ("--format").toLowerCase();
+    if (format == "rgba")
+        options.format = VideoExporter::Format::rawRgba;
+    else if (format == "y4m")
+        options.format = VideoExporter::Format::y4m;
+    else
+        options.format = VideoExporter::Format::pngSequence;
+
+    VideoExporter exporter (processor, options);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    exporter.onProgress = [] (int framesWritten, int totalFrames)
+    {
+        if (framesWritten % 60 == 0 || framesWritten == totalFrames)
+            printStatus ("\rFrames: " + juce::String (framesWritten) + "/" + juce::String (totalFrames));
+        return true;
+    };
+
+    bool ok = false;
+
+    if (outPath == "-")
+    {
+        StandardOutputStream output;
+        ok = exporter.exportToStream (output);
+    }
+    else if (options.format == VideoExporter::Format::pngSequence)
+    {
+        ok = exporter.exportToDirectory (resolvePath (outPath));
+    }
+    else
+    {
+        auto outFile = resolvePath (outPath);
+        outFile.deleteFile();
+        juce::FileOutputStream output (outFile);
+        ok = output.openedOk() && exporter.exportToStream (output);
+    }
+
+    const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    printStatus ("\n" + juce::String (exporter.getNumFrames()) + " frames en " + juce::String (seconds, 2) + " s"
+                 + (ok ? "\n" : " (con errores)\n"));
+    return ok ? 0 : 1;
+}
+
+int CommandLineTools::runScanLibrary (const juce::ArgumentList& args)
+{
+    MidiLibrary library;
+
+    // Sin carpeta solo se consulta el índice existente
+    const auto directory = args.getValueForOption ("--scan-library");
+    if (directory.isNotEmpty())
+    {
+        const auto folder = resolvePath (directory);
+        if (!folder.isDirectory())
+        {
+            printText ("Error: no existe la carpeta " + folder.getFullPathName() + "\n");
+            return 1;
+        }
+
+        library.onScanProgress = [] (int done, int total)
+        {
+            printStatus ("\rLeídos: " + juce::String (done) + "/" + juce::String (total));
+        };
+
+        const auto result = library.scan ({ folder }, getIntOption (args, "--threads", 0));
+        printStatus ("\n");
+        printText (juce::String (result.numFiles) + " archivos, " + juce::String (result.numRead) + " leídos, "
+                   + juce::String (result.numFailed) + " no válidos, " + juce::String (result.numRemoved) + " eliminados en "
+                   + juce::String (result.seconds, 3) + " s\n");
+    }
+
+    MidiLibrary::Query query;
+    query.text = args.getValueForOption ("--query");
+    query.minBpm = getDoubleOption (args, "--bpm-min", 0.0);
+    query.maxBpm = getDoubleOption (args, "--bpm-max", 0.0);
+    query.maxResults = std::numeric_limits<int>::max();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto results = library.search (query);
+    const double milliseconds = 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    if (query.text.isNotEmpty() || query.minBpm > 0.0 || query.maxBpm > 0.0)
+        for (const auto& entry : results)
+            printText (entry.path + "  " + juce::String (entry.lengthSeconds, 1) + " s  "
+                       + juce::String (entry.minBpm, 1) + "-" + juce::String (entry.maxBpm, 1) + " BPM  "
+                       + juce::String (entry.numNotes) + " notas\n");
+
+    printText (juce::String ((int) results.size()) + " de " + juce::String (library.getNumEntries())
+               + " entradas en " + juce::String (milliseconds, 3) + " ms (" + MidiLibrary::getDefaultIndexFile().getFullPathName() + ")\n");
+    return 0;
+}
+
+int CommandLineTools::runAlignAudio (const juce::ArgumentList& args)
+{
+    const auto audioPath = args.getValueForOption ("--align-audio");
+    const auto midiPath = args.getValueForOption ("--midi");
+    if (audioPath.isEmpty() || midiPath.isEmpty())
+    {
+        printText ("Error: uso --align-audio=<grabación> --midi=<archivo.mid>\n");
+        return 1;
+    }
+
+    AudioAligner::Options options;
+    options.numThreads = getIntOption (args, "--threads", options.numThreads);
+    options.hopSeconds = juce::jlimit (0.002, 0.1, getDoubleOption (args, "--hop", options.hopSeconds));
+
+    juce::String error;
+    AudioAligner::Result result;
+
+    if (AudioAligner (options).alignMidiFile (resolvePath (midiPath), resolvePath (audioPath), error, &result) == nullptr)
+    {
+        printText ("Error: " + error + "\n");
+        return 1;
+    }
+
+    const auto& points = result.warp.getPoints();
+    printText (juce::String (result.chartFrames) + " x " + juce::String (result.audioFrames) + " frames, "
+               + juce::String ((juce::int64) result.cells) + " celdas, " + juce::String ((int) points.size())
+               + " puntos en " + juce::String (result.seconds, 3) + " s\n");
+
+    // Mapa de tiempos: una línea "carta,grabación" por punto, en segundos
+    const auto outPath = args.getValueForOption ("--out");
+    if (outPath.isNotEmpty())
+    {
+        juce::String csv ("chart_seconds,audio_seconds\n");
+        for (const auto& point : points)
+            csv << juce::String (point.chartSeconds, 3) << "," << juce::String (point.audioSeconds, 3) << "\n";
+
+        const auto outFile = resolvePath (outPath);
+        if (!outFile.replaceWithText (csv))
+        {
+            printText ("Error: no se pudo escribir " + outFile.getFullPathName() + "\n");
+            return 1;
+        }
+
+        printText ("Mapa escrito en " + outFile.getFullPathName() + "\n");
+    }
+
+    return 0;
+}
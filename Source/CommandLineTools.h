@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    CommandLineTools.h
+    Modos sin interfaz de la aplicación Standalone (benchmarks, etc.).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+namespace CommandLineTools
+{
+    // Si la aplicación Standalone se lanzó con un comando conocido, lo ejecuta en el
+    // hilo de mensajes y cierra la aplicación con el código de salida del comando.
+    // Solo tiene efecto la primera vez que se llama.
+    void launchIfRequested();
+
+    // Ejecuta el comando indicado en los argumentos. Devuelve el código de salida.
+    int run (const juce::ArgumentList& args);
+
+    // --benchmark [--corpus=<dir>] [--sizes=500,50000,...] [--min-time=<s>]
+    int runBenchmark (const juce::ArgumentList& args);
+
+    // --generate-chart --out=<archivo.mid> [--seed=1] [--tracks=1] [--length=180] [--bpm=120]
+    //                  [--bpm-max=120] [--tempo-changes=0] [--steps=4] [--keys=3] [--density=1]
+    //                  [--cc=0] [--ppq=960]
+    int runGenerateChart (const juce::ArgumentList& args);
+
+    // --export-video=<archivo.mid> --out=<dir|archivo|-> [--format=png|rgba|y4m] [--fps=60]
+    //                [--size=1280x720] [--threads=0] [--bpm=<tempo del MIDI>] [--speed=1]
+    int runExportVideo (const juce::ArgumentList& args);
+
+    // --scan-library[=<dir>] [--threads=0] [--query=<texto>] [--bpm-min=0] [--bpm-max=0]
+    int runScanLibrary (const juce::ArgumentList& args);
+
+    // --align-audio=<grabación> --midi=<archivo.mid> [--out=<mapa.csv>] [--threads=0] [--hop=0.01]
+    int runAlignAudio (const juce::ArgumentList& args);
+}
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    ControllerLanes.cpp
+    Curvas de los controladores continuos (CC) de la canción, por controlador.
+
+  ==============================================================================
+*/
+
+#include "ControllerLanes.h"
+
+namespace
+{
+    // Primer índice desde first con tiempo >= seconds
+    size_t findFirstAtOrAfter (const std::vector<float>& times, size_t first, double seconds)
+    {
+        const auto found = std::lower_bound (times.begin() + (std::ptrdiff_t) first, times.end(), seconds,
+                                             [] (float time, double value) { return (double) time < value; });
+        return (size_t) (found - times.begin());
+    }
+}
+
+//==============================================================================
+void ControllerLanes::build (std::vector<Event> events)
+{
+    lanes.clear();
+
+    std::stable_sort (events.begin(), events.end(),
+                      [] (const Event& a, const Event& b) { return a.time < b.time; });
+
+    // Un carril por controlador usado, con los arrays reservados de una vez
+    std::array<size_t, 128> counts {};
+    for (const auto& event : events)
+        ++counts[event.controller & 127];
+
+    std::array<int, 128> laneForController;
+    laneForController.fill (-1);
+
+    for (int controller = 0; controller < 128; ++controller)
+    {
+        if (counts[(size_t) controller] == 0)
+            continue;
+
+        laneForController[(size_t) controller] = (int) lanes.size();
+        lanes.emplace_back();
+        lanes.back().controller = controller;
+        lanes.back().times.reserve (counts[(size_t) controller]);
+        lanes.back().values.reserve (counts[(size_t) controller]);
+    }
+
+    for (const auto& event : events)
+    {
+        auto& lane = lanes[(size_t) laneForController[event.controller & 127]];
+        lane.times.push_back ((float) event.time);
+        lane.values.push_back ((juce::uint8) juce::jmin (127, (int) event.value));
+    }
+
+    for (auto& lane : lanes)
+        lane.buildPyramid();
+}
+
+void ControllerLanes::clear()
+{
+    lanes.clear();
+}
+
+const ControllerLanes::Lane* ControllerLanes::findLane (int controller) const
+{
+    for (const auto& lane : lanes)
+        if (lane.controller == controller)
+            return &lane;
+
+    return nullptr;
+}
+
+size_t ControllerLanes::getMemoryBytes() const
+{
+    size_t bytes = lanes.capacity() * sizeof (Lane);
+
+    for (const auto& lane : lanes)
+    {
+        bytes += lane.times.capacity() * sizeof (float) + lane.values.capacity();
+
+        for (const auto& level : lane.pyramid)
+            bytes += level.capacity() * sizeof (Lane::Range);
+    }
+
+    return bytes;
+}
+
+//==============================================================================
+void ControllerLanes::Lane::buildPyramid()
+{
+    pyramid.clear();
+
+    // Solo bloques completos: un tramo [first, end) nunca pide uno que se salga del array
+    for (size_t blockSize = 2; blockSize <= values.size(); blockSize *= 2)
+    {
+        std::vector<Range> level (values.size() / blockSize);
+
+        for (size_t block = 0; block < level.size(); ++block)
+        {
+            if (pyramid.empty())
+            {
+                const auto a = values[block * 2], b = values[block * 2 + 1];
+                level[block] = { juce::jmin (a, b), juce::jmax (a, b) };
+            }
+            else
+            {
+                const auto& a = pyramid.back()[block * 2];
+                const auto& b = pyramid.back()[block * 2 + 1];
+                level[block] = { juce::jmin (a.minimum, b.minimum), juce::jmax (a.maximum, b.maximum) };
+            }
+        }
+
+        pyramid.push_back (std::move (level));
+    }
+}
+
+ControllerLanes::Lane::Range ControllerLanes::Lane::getRange (size_t first, size_t end) const
+{
+    Range range { 127, 0 };
+
+    // En cada paso, el bloque alineado más grande que empieza en first y cabe en el tramo
+    while (first < end)
+    {
+        size_t level = 0;
+
+        while (level < pyramid.size()
+               && (first & (((size_t) 2 << level) - 1)) == 0
+               && first + ((size_t) 2 << level) <= end)
+            ++level;
+
+        if (level == 0)
+        {
+            range.minimum = juce::jmin (range.minimum, values[first]);
+            range.maximum = juce::jmax (range.maximum, values[first]);
+            ++first;
+        }
+        else
+        {
+            const auto& block = pyramid[level - 1][first >> level];
+            range.minimum = juce::jmin (range.minimum, block.minimum);
+            range.maximum = juce::jmax (range.maximum, block.maximum);
+            first += (size_t) 1 << level;
+        }
+    }
+
+    return range;
+}
+
+ControllerLanes::Column ControllerLanes::Lane::getColumn (double startSeconds, double endSeconds, size_t& first) const
+{
+    Column column;
+
+    const auto begin = findFirstAtOrAfter (times, juce::jmin (first, times.size()), startSeconds);
+    const auto end = findFirstAtOrAfter (times, begin, endSeconds);
+    first = end;
+
+    if (begin == end)
+        return column;
+
+    const auto range = getRange (begin, end);
+    column.minimum = range.minimum;
+    column.maximum = range.maximum;
+    column.last = values[end - 1];
+    column.hasEvents = true;
+    return column;
+}
+
+bool ControllerLanes::Lane::getValueBefore (double seconds, juce::uint8& value) const
+{
+    const auto index = findFirstAtOrAfter (times, 0, seconds);
+    if (index == 0)
+        return false;
+
+    value = values[index - 1];
+    return true;
+}
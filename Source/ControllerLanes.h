@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    ControllerLanes.h
+    Curvas de los controladores continuos (CC) de la canción, por controlador.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Los mensajes de control de todas las pistas y canales, separados por número
+    de controlador (p. ej. CC4, la apertura del charles en las baterías
+    electrónicas) en dos arrays compactos por carril: tiempos en float y
+    valores en un byte.
+
+    Sobre los valores de cada carril se guarda una pirámide de mínimos y
+    máximos por bloques alineados de 2, 4, 8... eventos, así que el mínimo y el
+    máximo de cualquier tramo se obtienen en O(log n). Dibujar un carril por
+    columnas de píxeles cuesta lo mismo con mil eventos que con un millón.
+*/
+class ControllerLanes
+{
+public:
+    // Mensaje de control tal y como sale del MIDI, con el tiempo ya en segundos
+    struct Event
+    {
+        double time = 0.0;
+        juce::uint8 controller = 0;
+        juce::uint8 value = 0;
+    };
+
+    // Resumen de los eventos de una columna de píxeles
+    struct Column
+    {
+        juce::uint8 minimum = 0;
+        juce::uint8 maximum = 0;
+        juce::uint8 last = 0;           // Valor con el que queda la columna
+        bool hasEvents = false;         // Sin eventos, vale el último valor anterior (si lo hay)
+    };
+
+    class Lane
+    {
+    public:
+        int getController() const               { return controller; }
+        size_t size() const                     { return times.size(); }
+
+        // Columna [startSeconds, endSeconds); first es un índice desde el que empezar a buscar
+        // (la primera columna de un recorrido empieza en 0) y se actualiza para la siguiente.
+        Column getColumn (double startSeconds, double endSeconds, size_t& first) const;
+
+        // Valor vigente justo antes de seconds; false si todavía no hay ninguno
+        bool getValueBefore (double seconds, juce::uint8& value) const;
+
+    private:
+        friend class ControllerLanes;
+        friend class SongCacheFile;     // Lee y escribe los arrays en bloque
+
+        struct Range
+        {
+            juce::uint8 minimum, maximum;
+        };
+
+        void buildPyramid();
+        Range getRange (size_t first, size_t end) const;
+
+        int controller = 0;
+        std::vector<float> times;                   // Segundos, en orden
+        std::vector<juce::uint8> values;
+        std::vector<std::vector<Range>> pyramid;    // pyramid[k][b]: eventos [b * 2^(k+1), (b+1) * 2^(k+1))
+    };
+
+    ControllerLanes() = default;
+
+    // Separa los eventos por controlador (en cualquier orden; a igual tiempo se conserva el orden recibido)
+    void build (std::vector<Event> events);
+    void clear();
+
+    // Carriles ordenados por número de controlador; solo los que tienen eventos
+    const std::vector<Lane>& getLanes() const   { return lanes; }
+    const Lane* findLane (int controller) const;
+
+    size_t getMemoryBytes() const;
+
+private:
+    friend class SongCacheFile;
+
+    std::vector<Lane> lanes;
+
+    JUCE_LEAK_DETECTOR (ControllerLanes)
+};
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    DensityPyramid.cpp
+    Pirámide multirresolución de densidad de notas por carril (pista, canal y
+    nota MIDI).
+
+  ==============================================================================
+*/
+
+#include "DensityPyramid.h"
+
+//==============================================================================
+namespace
+{
+    // Nota, pista y canal en un entero: ordenar las claves ordena los carriles por nota
+    juce::uint32 getLaneKey (int track, int channel, int noteNumber)
+    {
+        return ((juce::uint32) noteNumber << 24) | ((juce::uint32) track << 8) | (juce::uint32) channel;
+    }
+}
+
+//==============================================================================
+DensityPyramid::DensityPyramid()
+{
+}
+
+void DensityPyramid::clear()
+{
+    firstLaneForNote.fill (0);
+    lanes.clear();
+    levels.clear();
+}
+
+void DensityPyramid::build (const std::vector<SongNote>& notes, double lengthSeconds)
+{
+    clear();
+
+    // Un carril por cada combinación de pista, canal y nota presente
+    std::vector<juce::uint32> keys;
+
+    for (const auto& note : notes)
+    {
+        const auto key = getLaneKey (note.track, note.channel, note.noteNumber);
+        if (keys.empty() || keys.back() != key)
+            keys.push_back (key);
+    }
+
+    std::sort (keys.begin(), keys.end());
+    keys.erase (std::unique (keys.begin(), keys.end()), keys.end());
+
+    if (keys.empty())
+        return;
+
+    lanes.reserve (keys.size());
+
+    for (auto key : keys)
+    {
+        Lane lane;
+        lane.noteNumber = (juce::uint8) (key >> 24);
+        lane.track = (juce::uint16) ((key >> 8) & 0xffff);
+        lane.channel = (juce::uint8) (key & 0xff);
+        lanes.push_back (lane);
+        ++firstLaneForNote[(size_t) lane.noteNumber + 1];
+    }
+
+    for (size_t noteNumber = 1; noteNumber < firstLaneForNote.size(); ++noteNumber)
+        firstLaneForNote[noteNumber] += firstLaneForNote[noteNumber - 1];
+
+    const int numLanes = getNumLanes();
+
+    // Nivel 0: resolución fija salvo en canciones muy largas o con muchos carriles
+    Level base;
+    base.bucketSeconds = juce::jmax (minimumBucketSeconds,
+                                     lengthSeconds / maximumBaseBuckets,
+                                     lengthSeconds * numLanes / (double) maximumBaseCells);
+    base.numBuckets = juce::jmax (1, (int) std::ceil (lengthSeconds / base.bucketSeconds) + 1);
+    base.counts.assign ((size_t) numLanes * (size_t) base.numBuckets, 0);
+    base.maxVelocities.assign ((size_t) numLanes * (size_t) base.numBuckets, 0);
+
+    for (const auto& note : notes)
+    {
+        const auto key = getLaneKey (note.track, note.channel, note.noteNumber);
+        const auto lane = (size_t) (std::lower_bound (keys.begin(), keys.end(), key) - keys.begin());
+        const int bucket = juce::jlimit (0, base.numBuckets - 1, (int) (note.time / base.bucketSeconds));
+        const size_t index = lane * (size_t) base.numBuckets + (size_t) bucket;
+
+        if (base.counts[index] < std::numeric_limits<juce::uint16>::max())
+            ++base.counts[index];
+
+        base.maxVelocities[index] = juce::jmax (base.maxVelocities[index], note.velocity);
+    }
+
+    levels.push_back (std::move (base));
+
+    // Cada nivel superior agrupa pares de intervalos del anterior hasta cubrir la canción con uno
+    while (levels.back().numBuckets > 1)
+    {
+        const auto& finer = levels.back();
+
+        Level coarser;
+        coarser.bucketSeconds = finer.bucketSeconds * 2.0;
+        coarser.numBuckets = (finer.numBuckets + 1) / 2;
+        coarser.counts.assign ((size_t) numLanes * (size_t) coarser.numBuckets, 0);
+        coarser.maxVelocities.assign ((size_t) numLanes * (size_t) coarser.numBuckets, 0);
+
+        for (size_t lane = 0; lane < (size_t) numLanes; ++lane)
+        {
+            for (int bucket = 0; bucket < finer.numBuckets; ++bucket)
+            {
+                const size_t from = lane * (size_t) finer.numBuckets + (size_t) bucket;
+                const size_t to = lane * (size_t) coarser.numBuckets + (size_t) (bucket / 2);
+
+                coarser.counts[to] = (juce::uint16) juce::jmin ((int) std::numeric_limits<juce::uint16>::max(),
+                                                                (int) coarser.counts[to] + (int) finer.counts[from]);
+                coarser.maxVelocities[to] = juce::jmax (coarser.maxVelocities[to], finer.maxVelocities[from]);
+            }
+        }
+
+        levels.push_back (std::move (coarser));
+    }
+}
+
+//==============================================================================
+int DensityPyramid::getNumLevels() const
+{
+    return (int) levels.size();
+}
+
+double DensityPyramid::getBucketSeconds (int level) const
+{
+    return juce::isPositiveAndBelow (level, getNumLevels()) ? levels[(size_t) level].bucketSeconds
+                                                             : minimumBucketSeconds;
+}
+
+int DensityPyramid::getNumBuckets (int level) const
+{
+    return juce::isPositiveAndBelow (level, getNumLevels()) ? levels[(size_t) level].numBuckets : 0;
+}
+
+int DensityPyramid::getLevelForResolution (double secondsPerPixel) const
+{
+    for (int level = 0; level < getNumLevels(); ++level)
+        if (levels[(size_t) level].bucketSeconds >= secondsPerPixel)
+            return level;
+
+    return getNumLevels() - 1;
+}
+
+bool DensityPyramid::hasLane (int noteNumber) const
+{
+    return juce::isPositiveAndBelow (noteNumber, 128) && getFirstLane (noteNumber + 1) > getFirstLane (noteNumber);
+}
+
+int DensityPyramid::getFirstLane (int noteNumber) const
+{
+    return firstLaneForNote[(size_t) juce::jlimit (0, 128, noteNumber)];
+}
+
+DensityPyramid::Bucket DensityPyramid::getBucket (int level, int noteNumber, int bucketIndex) const
+{
+    Bucket sum;
+
+    if (!hasLane (noteNumber))
+        return sum;
+
+    for (int lane = getFirstLane (noteNumber); lane < getFirstLane (noteNumber + 1); ++lane)
+    {
+        const auto cell = getLaneBucket (level, lane, bucketIndex);
+        sum.count += cell.count;
+        sum.maxVelocity = juce::jmax (sum.maxVelocity, cell.maxVelocity);
+    }
+
+    return sum;
+}
+
+DensityPyramid::Bucket DensityPyramid::getLaneBucket (int level, int lane, int bucketIndex) const
+{
+    if (!juce::isPositiveAndBelow (lane, getNumLanes()) || !juce::isPositiveAndBelow (level, getNumLevels()))
+        return {};
+
+    const auto& data = levels[(size_t) level];
+    if (!juce::isPositiveAndBelow (bucketIndex, data.numBuckets))
+        return {};
+
+    const size_t index = (size_t) lane * (size_t) data.numBuckets + (size_t) bucketIndex;
+    return { (int) data.counts[index], (int) data.maxVelocities[index] };
+}
+
+size_t DensityPyramid::getMemoryBytes() const
+{
+    size_t bytes = levels.capacity() * sizeof (Level) + lanes.capacity() * sizeof (Lane);
+
+    for (const auto& level : levels)
+        bytes += level.counts.capacity() * sizeof (juce::uint16) + level.maxVelocities.capacity();
+
+    return bytes;
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    DensityPyramid.h
+    Pirámide multirresolución de densidad de notas por carril (pista, canal y
+    nota MIDI).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SongNote.h"
+
+//==============================================================================
+/**
+    Para cada carril (combinación de pista, canal y nota MIDI usada en la
+    canción) guarda el número de golpes y la velocidad máxima por intervalo de
+    tiempo, en niveles cuya resolución se duplica de uno al siguiente. Permite
+    dibujar vistas alejadas con un coste proporcional al número de píxeles y no
+    al número de notas, también con pistas o canales ocultos: basta con sumar
+    solo los carriles visibles de cada nota.
+
+    Los carriles están ordenados por nota, así que los de una nota son un
+    tramo contiguo. El tamaño de la base está acotado en celdas (carriles por
+    intervalos): con muchos carriles los intervalos se agrandan.
+*/
+class DensityPyramid
+{
+public:
+    struct Bucket
+    {
+        int count = 0;
+        int maxVelocity = 0;
+    };
+
+    // Clave de un carril (4 bytes, se guarda tal cual en la caché)
+    struct Lane
+    {
+        juce::uint16 track = 0;
+        juce::uint8 channel = 1;
+        juce::uint8 noteNumber = 0;
+    };
+
+    DensityPyramid();
+
+    // Construye la pirámide a partir de las notas de la canción (en cualquier orden)
+    void build (const std::vector<SongNote>& notes, double lengthSeconds);
+    void clear();
+
+    int getNumLevels() const;
+    double getBucketSeconds (int level) const;
+    int getNumBuckets (int level) const;
+
+    // Nivel más fino cuyo intervalo cubre al menos secondsPerPixel (como mucho un intervalo por píxel)
+    int getLevelForResolution (double secondsPerPixel) const;
+
+    // Suma de todos los carriles de la nota
+    bool hasLane (int noteNumber) const;
+    Bucket getBucket (int level, int noteNumber, int bucketIndex) const;
+
+    // Carriles de una nota: [getFirstLane (nota), getFirstLane (nota + 1))
+    int getNumLanes() const                             { return (int) lanes.size(); }
+    int getFirstLane (int noteNumber) const;            // 0..128
+    const Lane& getLane (int lane) const                { return lanes[(size_t) lane]; }
+    Bucket getLaneBucket (int level, int lane, int bucketIndex) const;
+
+    size_t getMemoryBytes() const;
+
+    // Intervalo más fino de la base. Se agranda en canciones muy largas para acotar la memoria.
+    static constexpr double minimumBucketSeconds = 1.0 / 32.0;
+    static constexpr int maximumBaseBuckets = 1 << 16;
+    static constexpr size_t maximumBaseCells = (size_t) 1 << 23;    // 24 MB de base como mucho
+
+private:
+    friend class SongCacheFile;   // Lee y escribe los arrays en bloque
+
+    struct Level
+    {
+        double bucketSeconds = 0.0;
+        int numBuckets = 0;
+        std::vector<juce::uint16> counts;          // [carril * numBuckets + intervalo]
+        std::vector<juce::uint8> maxVelocities;
+    };
+
+    std::array<int, 129> firstLaneForNote {};       // Carriles de cada nota en lanes
+    std::vector<Lane> lanes;                        // Ordenados por nota, pista y canal
+    std::vector<Level> levels;
+
+    JUCE_LEAK_DETECTOR (DensityPyramid)
+};
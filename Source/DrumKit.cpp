@@ -0,0 +1,342 @@
+/*
+  ==============================================================================
+
+    DrumKit.cpp
+    Muestras de batería GM por nota, con capas de velocidad y round-robins.
+
+  ==============================================================================
+*/
+
+#include "DrumKit.h"
+
+//==============================================================================
+// Reúne las tomas sueltas y las empaqueta en el orden nota, capa, round-robin
+class DrumKit::Builder
+{
+public:
+    // source/totalLength: la toma sigue en ese archivo (ver DrumKit::Sample)
+    void add (int noteNumber, int layer, int roundRobin, juce::AudioBuffer<float> audio, int source = -1, int totalLength = 0)
+    {
+        if (juce::isPositiveAndBelow (noteNumber, 128) && audio.getNumSamples() > 0)
+            pending.push_back ({ noteNumber, layer, roundRobin, std::move (audio), source, totalLength });
+    }
+
+    int addSource (const juce::File& file, int numChannels)
+    {
+        streamSources.push_back ({ file, numChannels });
+        return (int) streamSources.size() - 1;
+    }
+
+    bool isEmpty() const    { return pending.empty(); }
+
+    Ptr build (double sampleRate, const juce::File& folder)
+    {
+        std::sort (pending.begin(), pending.end(), [] (const Pending& a, const Pending& b)
+        {
+            return std::tie (a.noteNumber, a.layer, a.roundRobin) < std::tie (b.noteNumber, b.layer, b.roundRobin);
+        });
+
+        std::shared_ptr<DrumKit> kit (new DrumKit());
+        kit->sampleRate = sampleRate;
+        kit->folder = folder;
+        kit->streamSources = std::move (streamSources);
+
+        size_t totalFloats = 0;
+        for (const auto& take : pending)
+            totalFloats += (size_t) (take.audio.getNumChannels() * take.audio.getNumSamples());
+
+        kit->sampleData.reserve (totalFloats);
+        kit->samples.reserve (pending.size());
+
+        for (size_t i = 0; i < pending.size();)
+        {
+            const int noteNumber = pending[i].noteNumber;
+            auto& instrument = kit->instruments[(size_t) noteNumber];
+            instrument.firstLayer = kit->layers.size();
+
+            // Una capa por cada número de capa distinto de la nota (como mucho maximumLayers)
+            while (i < pending.size() && pending[i].noteNumber == noteNumber)
+            {
+                const int layerNumber = pending[i].layer;
+                const bool addLayer = instrument.numLayers < maximumLayers;
+
+                if (addLayer)
+                {
+                    Layer layer;
+                    layer.firstSample = kit->samples.size();
+                    kit->layers.push_back (layer);
+                    ++instrument.numLayers;
+                }
+
+                for (; i < pending.size() && pending[i].noteNumber == noteNumber && pending[i].layer == layerNumber; ++i)
+                {
+                    if (!addLayer)
+                        continue;
+
+                    const auto& audio = pending[i].audio;
+
+                    Sample sample;
+                    sample.offset = kit->sampleData.size();
+                    sample.length = audio.getNumSamples();
+                    sample.numChannels = audio.getNumChannels();
+                    sample.source = pending[i].source;
+                    sample.totalLength = juce::jmax (pending[i].totalLength, sample.length);
+
+                    for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                        kit->sampleData.insert (kit->sampleData.end(), audio.getReadPointer (channel),
+                                                audio.getReadPointer (channel) + audio.getNumSamples());
+
+                    kit->samples.push_back (sample);
+                    ++kit->layers.back().numRoundRobins;
+                }
+            }
+
+            // Las capas se reparten el rango de velocidades a partes iguales
+            for (int layer = 0; layer < instrument.numLayers; ++layer)
+                kit->layers[instrument.firstLayer + (size_t) layer].maximumVelocity
+                    = juce::roundToInt (127.0 * (layer + 1) / instrument.numLayers);
+        }
+
+        pending.clear();
+        return kit;
+    }
+
+private:
+    struct Pending
+    {
+        int noteNumber = 0;
+        int layer = 0;
+        int roundRobin = 0;
+        juce::AudioBuffer<float> audio;
+        int source = -1;
+        int totalLength = 0;
+    };
+
+    std::vector<Pending> pending;
+    std::vector<StreamSource> streamSources;
+};
+
+//==============================================================================
+namespace
+{
+    // Receta de un instrumento sintetizado: tono con barrido de frecuencia más ruido
+    struct Recipe
+    {
+        int note;
+        int alternateNote;      // Otra nota GM con el mismo sonido, o -1
+        double lengthSeconds;
+        double toneStart, toneEnd, toneDecay, toneLevel;
+        double noiseDecay, noiseLevel;
+        bool brightNoise;       // Ruido con paso alto (platos y charles)
+    };
+
+    const Recipe recipes[] =
+    {
+        // nota, alternativa  duración  tono: inicio, final, caída, nivel   ruido: caída, nivel  brillante
+        { 35,  -1,   0.6,    120.0,   45.0,    0.30, 1.00,  0.005, 0.30,  false },   // Bombo acústico
+        { 36,  -1,   0.6,    150.0,   50.0,    0.30, 1.00,  0.005, 0.30,  false },   // Bombo
+        { 37,  -1,   0.1,    1700.0,  1600.0,  0.02, 0.60,  0.015, 0.60,  true  },   // Aro
+        { 38,  -1,   0.5,    220.0,   180.0,   0.08, 0.50,  0.180, 0.80,  false },   // Caja
+        { 39,  -1,   0.35,   0.0,     0.0,     0.01, 0.00,  0.120, 1.00,  false },   // Palmas
+        { 40,  -1,   0.5,    240.0,   200.0,   0.08, 0.50,  0.150, 0.80,  true  },   // Caja eléctrica
+        { 41,  -1,   0.8,    123.0,   82.0,    0.40, 1.00,  0.030, 0.20,  false },   // Timbales
+        { 43,  -1,   0.8,    147.0,   98.0,    0.40, 1.00,  0.030, 0.20,  false },
+        { 45,  -1,   0.8,    165.0,   110.0,   0.35, 1.00,  0.030, 0.20,  false },
+        { 47,  -1,   0.8,    196.0,   131.0,   0.35, 1.00,  0.030, 0.20,  false },
+        { 48,  -1,   0.8,    220.0,   147.0,   0.30, 1.00,  0.030, 0.20,  false },
+        { 50,  -1,   0.8,    247.0,   165.0,   0.30, 1.00,  0.030, 0.20,  false },
+        { 42,  -1,   0.15,   0.0,     0.0,     0.01, 0.00,  0.035, 0.80,  true  },   // Charles cerrado
+        { 44,  -1,   0.2,    0.0,     0.0,     0.01, 0.00,  0.050, 0.70,  true  },   // Charles con pedal
+        { 46,  -1,   0.8,    0.0,     0.0,     0.01, 0.00,  0.300, 0.80,  true  },   // Charles abierto
+        { 49,  57,   1.6,    0.0,     0.0,     0.01, 0.00,  0.500, 0.70,  true  },   // Crash
+        { 51,  59,   1.4,    3200.0,  3200.0,  0.50, 0.15,  0.400, 0.40,  true  },   // Ride
+        { 52,  -1,   1.4,    0.0,     0.0,     0.01, 0.00,  0.400, 0.80,  true  },   // China
+        { 53,  -1,   1.0,    2600.0,  2600.0,  0.40, 0.50,  0.200, 0.15,  true  },   // Campana del ride
+        { 54,  -1,   0.4,    0.0,     0.0,     0.01, 0.00,  0.100, 0.70,  true  },   // Pandereta
+        { 55,  -1,   1.0,    0.0,     0.0,     0.01, 0.00,  0.250, 0.70,  true  },   // Splash
+        { 56,  -1,   0.4,    800.0,   800.0,   0.12, 0.60,  0.010, 0.20,  true  },   // Cencerro
+    };
+
+    constexpr int synthesizedLayers = 3;
+    constexpr double roundRobinMaximumSeconds = 0.6;   // Solo los golpes cortos (los que se repiten rápido) alternan tomas
+
+    juce::AudioBuffer<float> synthesize (const Recipe& recipe, double sampleRate, int layer, int roundRobin)
+    {
+        const float velocity = (float) (layer + 1) / synthesizedLayers;
+        const float level = 0.5f + 0.5f * velocity;    // El resto de la dinámica lo da la velocidad de cada golpe
+        const double pitch = 1.0 + 0.01 * roundRobin;
+        const int length = juce::jmax (1, juce::roundToInt (recipe.lengthSeconds * sampleRate));
+
+        juce::AudioBuffer<float> audio (1, length);
+        auto* data = audio.getWritePointer (0);
+
+        juce::Random random (0x5eed + recipe.note * 131 + layer * 17 + roundRobin);
+        const float lowpass = 0.3f + 0.7f * velocity;  // Los golpes suaves suenan más apagados
+        float filtered = 0.0f, previous = 0.0f;
+        double phase = 0.0;
+
+        for (int i = 0; i < length; ++i)
+        {
+            const double t = i / sampleRate;
+
+            const double frequency = pitch * (recipe.toneEnd + (recipe.toneStart - recipe.toneEnd) * std::exp (-t / 0.03));
+            phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+            const double tone = std::sin (phase) * std::exp (-t / recipe.toneDecay);
+
+            filtered += (random.nextFloat() * 2.0f - 1.0f - filtered) * lowpass;
+            const float noise = recipe.brightNoise ? filtered - previous : filtered;
+            previous = filtered;
+
+            // Fundido final para que la muestra termine en cero aunque se recorte
+            const double tail = juce::jmin (1.0, (double) (length - i) / (0.005 * sampleRate));
+
+            data[i] = level * (float) (tail * (tone * recipe.toneLevel + noise * std::exp (-t / recipe.noiseDecay) * recipe.noiseLevel));
+        }
+
+        return audio;
+    }
+
+    // "38_v2_rr1" -> nota 38, capa 2, round-robin 1; false si el nombre no empieza por una nota
+    bool parseSampleName (const juce::String& name, int& noteNumber, int& layer, int& roundRobin)
+    {
+        const auto tokens = juce::StringArray::fromTokens (name, "_- ", {});
+        if (tokens.isEmpty() || !tokens[0].containsOnly ("0123456789"))
+            return false;
+
+        noteNumber = tokens[0].getIntValue();
+        layer = 1;
+        roundRobin = 1;
+
+        for (const auto& token : tokens)
+        {
+            if (token.startsWithIgnoreCase ("rr"))
+                roundRobin = token.substring (2).getIntValue();
+            else if (token.startsWithIgnoreCase ("v"))
+                layer = token.substring (1).getIntValue();
+        }
+
+        return juce::isPositiveAndBelow (noteNumber, 128);
+    }
+
+    juce::AudioBuffer<float> resample (const juce::AudioBuffer<float>& input, double ratio)
+    {
+        const int numOutput = juce::jmax (1, (int) std::floor (input.getNumSamples() / ratio));
+        juce::AudioBuffer<float> output (input.getNumChannels(), numOutput);
+
+        for (int channel = 0; channel < input.getNumChannels(); ++channel)
+        {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process (ratio, input.getReadPointer (channel), output.getWritePointer (channel),
+                                  numOutput, input.getNumSamples(), 0);
+        }
+
+        return output;
+    }
+}
+
+//==============================================================================
+DrumKit::Ptr DrumKit::createSynthesized (double sampleRate)
+{
+    Builder builder;
+
+    for (const auto& recipe : recipes)
+    {
+        const int numRoundRobins = recipe.lengthSeconds <= roundRobinMaximumSeconds ? 2 : 1;
+
+        for (int layer = 0; layer < synthesizedLayers; ++layer)
+            for (int roundRobin = 0; roundRobin < numRoundRobins; ++roundRobin)
+            {
+                const auto audio = synthesize (recipe, sampleRate, layer, roundRobin);
+
+                builder.add (recipe.note, layer, roundRobin, audio);
+
+                if (recipe.alternateNote >= 0)
+                    builder.add (recipe.alternateNote, layer, roundRobin, audio);
+            }
+    }
+
+    return builder.build (sampleRate, {});
+}
+
+DrumKit::Ptr DrumKit::loadFromFolder (const juce::File& folder, double sampleRate, juce::String& error)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    Builder builder;
+
+    for (const auto& entry : juce::RangedDirectoryIterator (folder, false, formatManager.getWildcardForAllFormats()))
+    {
+        const auto file = entry.getFile();
+
+        int noteNumber = 0, layer = 1, roundRobin = 1;
+        if (!parseSampleName (file.getFileNameWithoutExtension(), noteNumber, layer, roundRobin))
+            continue;
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+        if (reader == nullptr || reader->sampleRate <= 0.0)
+        {
+            juce::Logger::writeToLog ("Aviso: No se pudo leer la muestra " + file.getFileName());
+            continue;
+        }
+
+        const int numChannels = (int) juce::jmin (2u, reader->numChannels);
+
+        // A la frecuencia del host, solo el comienzo: el resto se lee del disco al sonar
+        if (reader->sampleRate == sampleRate)
+        {
+            const auto totalLength = (int) juce::jmin (reader->lengthInSamples, (juce::int64) (maximumStreamedSeconds * sampleRate));
+            const auto length = juce::jmin (totalLength, (int) (preloadSeconds * sampleRate));
+
+            juce::AudioBuffer<float> audio (numChannels, length);
+            reader->read (&audio, 0, length, 0, true, numChannels > 1);
+
+            const int source = totalLength > length ? builder.addSource (file, numChannels) : -1;
+            builder.add (noteNumber, layer, roundRobin, std::move (audio), source, totalLength);
+            continue;
+        }
+
+        // Otra frecuencia: la toma entera, convertida (las voces se mezclan sin interpolar)
+        const auto length = (int) juce::jmin (reader->lengthInSamples, (juce::int64) (maximumSampleSeconds * reader->sampleRate));
+        juce::AudioBuffer<float> audio (numChannels, length);
+        reader->read (&audio, 0, length, 0, true, numChannels > 1);
+
+        builder.add (noteNumber, layer, roundRobin, resample (audio, reader->sampleRate / sampleRate));
+    }
+
+    if (builder.isEmpty())
+    {
+        error = "No hay muestras con nombre \"<nota>[_v<capa>][_rr<n>]\" en " + folder.getFullPathName();
+        return {};
+    }
+
+    return builder.build (sampleRate, folder);
+}
+
+//==============================================================================
+const DrumKit::Sample* DrumKit::findSample (int noteNumber, int velocity, juce::uint32 roundRobin) const
+{
+    if (!juce::isPositiveAndBelow (noteNumber, 128))
+        return nullptr;
+
+    const auto& instrument = instruments[(size_t) noteNumber];
+    if (instrument.numLayers == 0)
+        return nullptr;
+
+    // Primera capa que cubre la velocidad (la última cubre hasta 127)
+    auto layerIndex = instrument.firstLayer;
+    const auto lastLayer = instrument.firstLayer + (size_t) instrument.numLayers - 1;
+
+    while (layerIndex < lastLayer && layers[layerIndex].maximumVelocity < velocity)
+        ++layerIndex;
+
+    const auto& layer = layers[layerIndex];
+    return &samples[layer.firstSample + roundRobin % (juce::uint32) layer.numRoundRobins];
+}
+
+size_t DrumKit::getMemoryBytes() const
+{
+    return sampleData.capacity() * sizeof (float)
+         + samples.capacity() * sizeof (Sample)
+         + layers.capacity() * sizeof (Layer);
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    DrumKit.h
+    Muestras de batería GM por nota, con capas de velocidad y round-robins.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Kit de batería inmutable listo para el hilo de audio. Todas las muestras
+    están ya a la frecuencia de muestreo del host en un único bloque de floats,
+    ordenadas por nota, capa de velocidad y round-robin, y cada muestra guarda
+    sus canales uno detrás de otro. Así los round-robins de una capa quedan
+    contiguos y una voz lee siempre hacia delante en memoria.
+
+    Se comparte como std::shared_ptr<const DrumKit>, igual que PreparedSong.
+    El kit integrado se sintetiza al preparar el audio; un kit de muestras se
+    carga de una carpeta con archivos "<nota>[_v<capa>][_rr<n>].wav", p. ej.
+    "38_v2_rr1.wav" (la capa 1 es la más suave).
+
+    En un kit de muestras solo se carga el comienzo de cada toma (preloadSeconds);
+    el resto lo lee del archivo el DrumStreamer mientras suena, así que la
+    memoria no crece con el tamaño de la librería. Las tomas grabadas a otra
+    frecuencia de muestreo se cargan enteras ya convertidas.
+*/
+class DrumKit
+{
+public:
+    using Ptr = std::shared_ptr<const DrumKit>;
+
+    // Una toma de una nota: numChannels bloques de length floats desde offset. Si la toma
+    // continúa en disco, source es su archivo y totalLength su duración completa.
+    struct Sample
+    {
+        size_t offset = 0;
+        int length = 0;
+        int numChannels = 1;
+        int source = -1;
+        int totalLength = 0;
+
+        bool isStreamed() const     { return source >= 0 && totalLength > length; }
+    };
+
+    // Archivo del que se lee el resto de las tomas paginadas
+    struct StreamSource
+    {
+        juce::File file;
+        int numChannels = 1;
+    };
+
+    // Kit de batería GM sintetizado (no necesita archivos)
+    static Ptr createSynthesized (double sampleRate);
+
+    // Kit de muestras de una carpeta, convertido a sampleRate; nullptr y error si no hay muestras válidas
+    static Ptr loadFromFolder (const juce::File& folder, double sampleRate, juce::String& error);
+
+    double getSampleRate() const                { return sampleRate; }
+    const juce::File& getFolder() const         { return folder; }      // Vacío en el kit integrado
+    int getNumSamples() const                   { return (int) samples.size(); }
+
+    // Toma para un golpe según la velocidad (capa) y un contador de round-robin; nullptr si la nota no suena
+    const Sample* findSample (int noteNumber, int velocity, juce::uint32 roundRobin) const;
+
+    const float* getChannel (const Sample& sample, int channel) const
+    {
+        return sampleData.data() + sample.offset + (size_t) juce::jmin (channel, sample.numChannels - 1) * (size_t) sample.length;
+    }
+
+    const std::vector<StreamSource>& getStreamSources() const   { return streamSources; }
+
+    size_t getMemoryBytes() const;
+
+    static constexpr double maximumSampleSeconds = 8.0;    // Las muestras residentes más largas se recortan
+    static constexpr double maximumStreamedSeconds = 60.0; // Ídem para las que se leen del disco
+    static constexpr double preloadSeconds = 0.25;         // Comienzo residente de las tomas en disco
+    static constexpr int maximumLayers = 16;
+
+private:
+    class Builder;
+
+    struct Layer
+    {
+        int maximumVelocity = 127;
+        size_t firstSample = 0;     // Índice en samples
+        int numRoundRobins = 0;
+    };
+
+    struct Instrument
+    {
+        size_t firstLayer = 0;      // Índice en layers
+        int numLayers = 0;
+    };
+
+    DrumKit() = default;
+
+    double sampleRate = 44100.0;
+    juce::File folder;
+    std::array<Instrument, 128> instruments {};
+    std::vector<Layer> layers;
+    std::vector<Sample> samples;
+    std::vector<float> sampleData;
+    std::vector<StreamSource> streamSources;
+
+    JUCE_LEAK_DETECTOR (DrumKit)
+};
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    DrumSampler.cpp
+    Reproducción de un DrumKit con un conjunto fijo de voces.
+
+  ==============================================================================
+*/
+
+#include "DrumSampler.h"
+
+//==============================================================================
+namespace
+{
+    // Panorama desde el punto de vista del batería (-1 izquierda, 1 derecha)
+    float getPan (int noteNumber)
+    {
+        switch (noteNumber)
+        {
+            case 42: case 44: case 46:  return -0.35f;     // Charles
+            case 49: case 52: case 55:  return -0.45f;     // Crash, china, splash
+            case 57:                    return 0.45f;      // Crash 2
+            case 51: case 53: case 59:  return 0.40f;      // Ride
+            case 50:                    return -0.30f;     // Timbales de agudo a grave
+            case 48:                    return -0.15f;
+            case 47:                    return 0.0f;
+            case 45:                    return 0.15f;
+            case 43:                    return 0.30f;
+            case 41:                    return 0.40f;
+            default:                    return 0.0f;
+        }
+    }
+}
+
+//==============================================================================
+DrumSampler::DrumSampler (DrumStreamer& s)
+    : streamer (s)
+{
+    prepare (44100.0);
+}
+
+void DrumSampler::prepare (double sampleRate)
+{
+    const int fadeLength = juce::jmax (1, juce::roundToInt (chokeFadeSeconds * sampleRate));
+    fadeRamp.resize ((size_t) fadeLength);
+
+    for (int i = 0; i < fadeLength; ++i)
+        fadeRamp[(size_t) i] = 1.0f - (float) (i + 1) / (float) fadeLength;
+
+    fadeLeft.assign ((size_t) fadeLength, 0.0f);
+    fadeRight.assign ((size_t) fadeLength, 0.0f);
+
+    // Panorama de igual potencia
+    for (int note = 0; note < 128; ++note)
+    {
+        const float angle = (getPan (note) + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+        panLeft[(size_t) note] = std::cos (angle);
+        panRight[(size_t) note] = std::sin (angle);
+    }
+
+    reset();
+}
+
+void DrumSampler::reset()
+{
+    for (int i = 0; i < numVoices; ++i)
+        stopVoice (voices[(size_t) i]);
+
+    numVoices = 0;
+}
+
+void DrumSampler::setKitGeneration (int generation)
+{
+    reset();
+    kitGeneration = generation;
+}
+
+void DrumSampler::stopVoice (const Voice& voice)
+{
+    if (voice.stream >= 0)
+        streamer.stopStream (voice.stream);
+}
+
+int DrumSampler::getChokeGroup (int noteNumber)
+{
+    // Grupos exclusivos de la percusión GM
+    switch (noteNumber)
+    {
+        case 42: case 44: case 46:  return 1;   // Charles cerrado, pedal y abierto
+        case 71: case 72:           return 2;   // Silbato corto y largo
+        case 73: case 74:           return 3;   // Güiro corto y largo
+        case 78: case 79:           return 4;   // Cuíca apagada y abierta
+        case 80: case 81:           return 5;   // Triángulo apagado y abierto
+        default:                    return 0;
+    }
+}
+
+//==============================================================================
+void DrumSampler::noteOn (const DrumKit& kit, int noteNumber, int velocity)
+{
+    if (!juce::isPositiveAndBelow (noteNumber, 128))
+        return;
+
+    const auto* sample = kit.findSample (noteNumber, velocity, roundRobins[(size_t) noteNumber]++);
+    if (sample == nullptr)
+        return;
+
+    // Cortar las voces del mismo grupo (p. ej. el charles cerrado apaga el abierto)
+    const int chokeGroup = getChokeGroup (noteNumber);
+
+    if (chokeGroup != 0)
+        for (int i = 0; i < numVoices; ++i)
+            if (voices[(size_t) i].chokeGroup == chokeGroup && voices[(size_t) i].fadePosition < 0)
+                voices[(size_t) i].fadePosition = 0;
+
+    // Sin voces libres se reutiliza la más antigua (la primera)
+    if (numVoices == maximumVoices)
+    {
+        stopVoice (voices.front());
+        std::move (voices.begin() + 1, voices.end(), voices.begin());
+        --numVoices;
+    }
+
+    const float gain = outputLevel * (float) juce::jlimit (0, 127, velocity) / 127.0f;
+
+    auto& voice = voices[(size_t) numVoices++];
+    voice.left = kit.getChannel (*sample, 0);
+    voice.right = kit.getChannel (*sample, 1);
+    voice.remaining = sample->length;
+    voice.gainLeft = gain * panLeft[(size_t) noteNumber];
+    voice.gainRight = gain * panRight[(size_t) noteNumber];
+    voice.chokeGroup = chokeGroup;
+    voice.fadePosition = -1;
+    voice.stream = -1;
+    voice.streamRemaining = 0;
+
+    // Sin canal libre solo suena el comienzo residente
+    if (sample->isStreamed())
+    {
+        voice.stream = streamer.startStream (*sample, kitGeneration);
+        if (voice.stream >= 0)
+            voice.streamRemaining = sample->totalLength - sample->length;
+    }
+}
+
+void DrumSampler::render (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0 || numVoices == 0 || buffer.getNumChannels() == 0)
+        return;
+
+    auto* left = buffer.getWritePointer (0, startSample);
+    auto* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer (1, startSample) : nullptr;
+    const int fadeLength = (int) fadeRamp.size();
+    int keptVoices = 0;
+
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto voice = voices[(size_t) i];
+        int done = 0;
+
+        // Por tramos: la parte residente y luego lo que el DrumStreamer ya haya leído
+        while (done < numSamples)
+        {
+            const float* sourceLeft = voice.left;
+            const float* sourceRight = voice.right;
+            int count = juce::jmin (numSamples - done, voice.remaining);
+            const bool fromStream = count == 0;
+
+            if (fromStream)
+            {
+                if (voice.streamRemaining <= 0)
+                    break;
+
+                count = streamer.getReadable (voice.stream, sourceLeft, sourceRight, juce::jmin (numSamples - done, voice.streamRemaining));
+
+                // El disco no ha llegado: la voz espera en silencio al siguiente bloque
+                if (count == 0)
+                {
+                    streamer.noteUnderrun();
+                    break;
+                }
+            }
+
+            // Voz cortada: solo suena lo que queda del fundido, multiplicado por la rampa
+            bool faded = false;
+
+            if (voice.fadePosition >= 0)
+            {
+                count = juce::jmin (count, fadeLength - voice.fadePosition);
+                juce::FloatVectorOperations::multiply (fadeLeft.data(), sourceLeft, fadeRamp.data() + voice.fadePosition, count);
+                juce::FloatVectorOperations::multiply (fadeRight.data(), sourceRight, fadeRamp.data() + voice.fadePosition, count);
+                sourceLeft = fadeLeft.data();
+                sourceRight = fadeRight.data();
+
+                voice.fadePosition += count;
+                faded = voice.fadePosition >= fadeLength;
+            }
+
+            if (right != nullptr)
+            {
+                juce::FloatVectorOperations::addWithMultiply (left + done, sourceLeft, voice.gainLeft, count);
+                juce::FloatVectorOperations::addWithMultiply (right + done, sourceRight, voice.gainRight, count);
+            }
+            else
+            {
+                // Salida mono: los dos canales de la muestra con la ganancia media
+                const float gain = 0.5f * (voice.gainLeft + voice.gainRight);
+                juce::FloatVectorOperations::addWithMultiply (left + done, sourceLeft, gain * 0.5f, count);
+                juce::FloatVectorOperations::addWithMultiply (left + done, sourceRight, gain * 0.5f, count);
+            }
+
+            if (fromStream)
+            {
+                streamer.consume (voice.stream, count);
+                voice.streamRemaining -= count;
+            }
+            else
+            {
+                voice.left += count;
+                voice.right += count;
+                voice.remaining -= count;
+            }
+
+            done += count;
+
+            if (faded)
+                voice.remaining = voice.streamRemaining = 0;
+        }
+
+        if (voice.remaining > 0 || voice.streamRemaining > 0)
+            voices[(size_t) keptVoices++] = voice;
+        else
+            stopVoice (voice);
+    }
+
+    numVoices = keptVoices;
+}
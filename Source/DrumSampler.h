@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    DrumSampler.h
+    Reproducción de un DrumKit con un conjunto fijo de voces.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DrumKit.h"
+#include "DrumStreamer.h"
+
+//==============================================================================
+/**
+    Motor de batería del hilo de audio. Las voces salen de un array de tamaño
+    fijo (al llenarse se reutiliza la más antigua) y cada una se mezcla entera
+    en el bloque con FloatVectorOperations, con la ganancia de velocidad y
+    panorama ya calculada en el golpe. Los grupos de corte GM (charles
+    abierto/cerrado, triángulo, cuíca, silbato) apagan con un fundido corto
+    las voces del mismo grupo.
+
+    Para colocar cada golpe en su muestra, el llamador mezcla hasta la
+    posición del golpe con render(), llama a noteOn() y sigue desde ahí.
+    Ni render() ni noteOn() reservan memoria ni bloquean.
+
+    Las tomas que siguen en disco suenan primero desde su comienzo residente
+    y después desde el canal del DrumStreamer que reservan en el golpe. Si el
+    disco no llega a tiempo la voz espera en silencio hasta tener datos.
+*/
+class DrumSampler
+{
+public:
+    explicit DrumSampler (DrumStreamer& streamer);
+
+    // Fundido de corte y tabla de panorama (fuera del hilo de audio)
+    void prepare (double sampleRate);
+
+    // Apaga todas las voces (al cambiar de kit, las voces apuntan a sus muestras)
+    void reset();
+
+    // Generación del kit con la que se piden canales al DrumStreamer; apaga las voces
+    void setKitGeneration (int generation);
+
+    // Empieza un golpe en la posición actual de la mezcla
+    void noteOn (const DrumKit& kit, int noteNumber, int velocity);
+
+    // Suma las voces activas a buffer[startSample, startSample + numSamples)
+    void render (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    int getNumActiveVoices() const      { return numVoices; }
+
+    // Grupo de corte GM de una nota; 0 si no corta a nadie
+    static int getChokeGroup (int noteNumber);
+
+    static constexpr int maximumVoices = 128;
+    static constexpr double chokeFadeSeconds = 0.003;
+    static constexpr float outputLevel = 0.5f;
+
+private:
+    struct Voice
+    {
+        const float* left = nullptr;        // Lo que queda por sonar de cada canal
+        const float* right = nullptr;
+        int remaining = 0;
+        float gainLeft = 0.0f, gainRight = 0.0f;
+        int chokeGroup = 0;
+        int fadePosition = -1;              // Posición en fadeRamp; -1 si no se está cortando
+        int stream = -1;                    // Canal del DrumStreamer; -1 si la toma es residente
+        int streamRemaining = 0;            // Lo que queda por leer del disco tras la parte residente
+    };
+
+    void stopVoice (const Voice& voice);
+
+    DrumStreamer& streamer;
+    int kitGeneration = 0;
+
+    std::array<Voice, maximumVoices> voices;
+    int numVoices = 0;                      // Activas en voices[0, numVoices), de la más antigua a la más nueva
+    std::array<juce::uint32, 128> roundRobins {};
+
+    std::vector<float> fadeRamp;            // De 1 a 0 en chokeFadeSeconds
+    std::vector<float> fadeLeft, fadeRight; // Trozo de la voz ya multiplicado por el fundido
+    std::array<float, 128> panLeft {}, panRight {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumSampler)
+};
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    DrumStreamer.cpp
+    Lectura desde disco del resto de las tomas largas de un kit de muestras.
+
+  ==============================================================================
+*/
+
+#include "DrumStreamer.h"
+
+//==============================================================================
+DrumStreamer::DrumStreamer()
+    : juce::Thread ("Drum streaming"),
+      streams (new Stream[(size_t) maximumStreams])
+{
+    formatManager.registerBasicFormats();
+    readBuffer.setSize (2, readChunkFrames);
+}
+
+DrumStreamer::~DrumStreamer()
+{
+    stopThread (5000);
+}
+
+void DrumStreamer::setKit (DrumKit::Ptr newKit, int generation)
+{
+    const bool needsThread = newKit != nullptr && !newKit->getStreamSources().empty();
+
+    {
+        const juce::ScopedLock sl (kitLock);
+        pendingKit = std::move (newKit);
+        pendingGeneration = generation;
+    }
+
+    // Buffers e hilo solo a partir del primer kit con tomas en disco (antes de que el audio pueda usarlos)
+    if (needsThread && !isThreadRunning())
+    {
+        for (int i = 0; i < maximumStreams; ++i)
+            for (auto& buffer : streams[(size_t) i].buffers)
+                buffer.calloc ((size_t) bufferFrames);
+
+        startThread (juce::Thread::Priority::high);
+    }
+}
+
+//==============================================================================
+int DrumStreamer::startStream (const DrumKit::Sample& sample, int generation)
+{
+    for (int i = 0; i < maximumStreams; ++i)
+    {
+        const int index = (nextFreeHint + i) % maximumStreams;
+        auto& stream = streams[(size_t) index];
+
+        if (stream.state.load (std::memory_order_acquire) != streamFree)
+            continue;
+
+        // El hilo de fondo no toca los canales libres: se preparan sin sincronizar y se publican
+        stream.generation = generation;
+        stream.source = sample.source;
+        stream.numChannels = juce::jlimit (1, 2, sample.numChannels);
+        stream.startFrame = sample.length;
+        stream.endFrame = sample.totalLength;
+        stream.writePosition.store (0, std::memory_order_relaxed);
+        stream.readPosition.store (0, std::memory_order_relaxed);
+        stream.state.store (streamActive, std::memory_order_release);
+
+        nextFreeHint = (index + 1) % maximumStreams;
+        return index;
+    }
+
+    return -1;
+}
+
+void DrumStreamer::stopStream (int stream)
+{
+    if (juce::isPositiveAndBelow (stream, maximumStreams))
+        streams[(size_t) stream].state.store (streamReleasing, std::memory_order_release);
+}
+
+int DrumStreamer::getReadable (int stream, const float*& left, const float*& right, int maximumFrames) const
+{
+    const auto& s = streams[(size_t) stream];
+    const auto read = s.readPosition.load (std::memory_order_relaxed);
+    const auto available = s.writePosition.load (std::memory_order_acquire) - read;
+    const auto index = read & (size_t) (bufferFrames - 1);
+
+    // Hasta el final del buffer circular; el resto se lee en la siguiente llamada
+    const int count = (int) juce::jmin (available, (size_t) bufferFrames - index, (size_t) juce::jmax (0, maximumFrames));
+
+    left = s.buffers[0].get() + index;
+    right = s.numChannels > 1 ? s.buffers[1].get() + index : left;
+    return count;
+}
+
+void DrumStreamer::consume (int stream, int numFrames)
+{
+    auto& s = streams[(size_t) stream];
+    s.readPosition.store (s.readPosition.load (std::memory_order_relaxed) + (size_t) numFrames, std::memory_order_release);
+}
+
+DrumStreamer::Statistics DrumStreamer::getStatistics() const
+{
+    Statistics statistics;
+    statistics.underruns = underruns.load();
+    statistics.framesRead = framesRead.load();
+
+    for (int i = 0; i < maximumStreams; ++i)
+        if (streams[(size_t) i].state.load() == streamActive)
+            ++statistics.activeStreams;
+
+    return statistics;
+}
+
+//==============================================================================
+void DrumStreamer::run()
+{
+    while (!threadShouldExit())
+    {
+        // Adoptar el kit nuevo; los lectores del anterior ya no sirven
+        {
+            const juce::ScopedLock sl (kitLock);
+            if (pendingGeneration != kitGeneration)
+            {
+                kit = pendingKit;
+                kitGeneration = pendingGeneration;
+                readers.clear();
+                readers.resize (kit != nullptr ? kit->getStreamSources().size() : 0);
+            }
+        }
+
+        bool busy = false;
+
+        for (int i = 0; i < maximumStreams && !threadShouldExit(); ++i)
+        {
+            auto& stream = streams[(size_t) i];
+            const int state = stream.state.load (std::memory_order_acquire);
+
+            if (state == streamReleasing)
+                stream.state.store (streamFree, std::memory_order_release);
+            else if (state == streamActive && stream.generation == kitGeneration)
+                busy = fill (stream) || busy;
+        }
+
+        // Cortes avisados como mucho una vez por segundo
+        const auto totalUnderruns = underruns.load();
+        const auto now = juce::Time::getMillisecondCounter();
+
+        if (totalUnderruns != reportedUnderruns && now - lastReportMs >= 1000)
+        {
+            juce::Logger::writeToLog ("Aviso: " + juce::String ((juce::int64) (totalUnderruns - reportedUnderruns))
+                                      + " cortes de streaming de batería (el disco no llega a tiempo)");
+            reportedUnderruns = totalUnderruns;
+            lastReportMs = now;
+        }
+
+        // Si todos los buffers están llenos, esperar a que el audio los vacíe
+        if (!busy)
+            wait (pollIntervalMs);
+    }
+}
+
+bool DrumStreamer::fill (Stream& stream)
+{
+    const auto written = stream.writePosition.load (std::memory_order_relaxed);
+    const auto space = (size_t) bufferFrames - (written - stream.readPosition.load (std::memory_order_acquire));
+    const auto firstFrame = (juce::int64) stream.startFrame + (juce::int64) written;
+    const auto index = written & (size_t) (bufferFrames - 1);
+
+    const int count = (int) juce::jmin ((juce::int64) space, (juce::int64) stream.endFrame - firstFrame,
+                                        (juce::int64) bufferFrames - (juce::int64) index, (juce::int64) readChunkFrames);
+    if (count <= 0)
+        return false;
+
+    // Si el archivo no se puede leer la voz sigue en silencio hasta su final en vez de quedarse esperando
+    if (auto* reader = getReader (stream.source))
+        reader->read (&readBuffer, 0, count, firstFrame, true, stream.numChannels > 1);
+    else
+        readBuffer.clear (0, count);
+
+    for (int channel = 0; channel < stream.numChannels; ++channel)
+        std::memcpy (stream.buffers[channel].get() + index, readBuffer.getReadPointer (channel), (size_t) count * sizeof (float));
+
+    stream.writePosition.store (written + (size_t) count, std::memory_order_release);
+    framesRead.fetch_add ((juce::uint64) count, std::memory_order_relaxed);
+    return true;
+}
+
+juce::AudioFormatReader* DrumStreamer::getReader (int source)
+{
+    if (!juce::isPositiveAndBelow (source, (int) readers.size()))
+        return nullptr;
+
+    auto& cached = readers[(size_t) source];
+    cached.lastUsed = ++useCounter;
+
+    if (cached.reader != nullptr || cached.failed)
+        return cached.reader.get();
+
+    // Cerrar el lector usado hace más tiempo si hay demasiados abiertos
+    int numOpen = 0;
+    CachedReader* oldest = nullptr;
+
+    for (auto& other : readers)
+    {
+        if (other.reader == nullptr)
+            continue;
+
+        ++numOpen;
+        if (oldest == nullptr || other.lastUsed < oldest->lastUsed)
+            oldest = &other;
+    }
+
+    if (numOpen >= maximumOpenReaders && oldest != nullptr)
+        oldest->reader.reset();
+
+    // Mapeado en memoria si el formato lo permite (WAV, AIFF): las páginas las gestiona el sistema
+    const auto& file = kit->getStreamSources()[(size_t) source].file;
+
+    if (auto* format = formatManager.findFormatForFileExtension (file.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped (format->createMemoryMappedReader (file));
+        if (mapped != nullptr && mapped->mapEntireFile())
+            cached.reader = std::move (mapped);
+    }
+
+    if (cached.reader == nullptr)
+        cached.reader.reset (formatManager.createReaderFor (file));
+
+    if (cached.reader == nullptr)
+    {
+        cached.failed = true;
+        juce::Logger::writeToLog ("Error: No se pudo abrir la muestra " + file.getFullPathName());
+    }
+
+    return cached.reader.get();
+}
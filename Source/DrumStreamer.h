@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    DrumStreamer.h
+    Lectura desde disco del resto de las tomas largas de un kit de muestras.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DrumKit.h"
+
+//==============================================================================
+/**
+    Cada voz que toca una toma en disco reserva un canal de streaming: un
+    buffer circular por canal de audio, con posiciones atómicas (un productor,
+    un consumidor). Mientras la voz suena el comienzo residente de la toma, un
+    hilo de fondo lee el resto del archivo (mapeado en memoria si el formato lo
+    permite) por delante de la posición de reproducción.
+
+    El hilo de audio solo reserva y libera canales y lee de los buffers con
+    atomics, sin locks ni reservas de memoria. Si un buffer se vacía antes de
+    tiempo la voz espera en silencio y se cuenta un corte; el hilo de fondo
+    avisa de los cortes por el log.
+*/
+class DrumStreamer : private juce::Thread
+{
+public:
+    struct Statistics
+    {
+        int activeStreams = 0;
+        juce::uint64 underruns = 0;
+        juce::uint64 framesRead = 0;
+    };
+
+    DrumStreamer();
+    ~DrumStreamer() override;
+
+    // Kit del que se leen las tomas (hilo de mensajes). generation es la que usará el hilo de audio
+    // al reservar canales; los canales de otra generación no se rellenan. Los buffers
+    // (maximumStreams * 2 * bufferFrames floats) se reservan con el primer kit que tenga tomas en disco.
+    void setKit (DrumKit::Ptr kit, int generation);
+
+    //==============================================================================
+    // Hilo de audio
+
+    // Canal para seguir la toma desde su parte residente; -1 si no queda ninguno libre
+    int startStream (const DrumKit::Sample& sample, int generation);
+    void stopStream (int stream);
+
+    // Tramo contiguo ya leído (como mucho maximumFrames); 0 si el buffer está vacío
+    int getReadable (int stream, const float*& left, const float*& right, int maximumFrames) const;
+    void consume (int stream, int numFrames);
+
+    void noteUnderrun()                 { underruns.fetch_add (1, std::memory_order_relaxed); }
+
+    //==============================================================================
+    Statistics getStatistics() const;
+
+    static constexpr int maximumStreams = 128;          // Una por voz del DrumSampler
+    static constexpr int bufferFrames = 1 << 14;        // Por canal de audio (potencia de dos)
+    static constexpr int maximumOpenReaders = 256;
+    static constexpr int readChunkFrames = 4096;        // Lectura máxima por canal y pasada
+    static constexpr int pollIntervalMs = 2;
+
+private:
+    enum State { streamFree, streamActive, streamReleasing };
+
+    struct Stream
+    {
+        std::atomic<int> state { streamFree };
+
+        // Los escribe el hilo de audio antes de publicar state = streamActive
+        int generation = 0;
+        int source = 0;
+        int numChannels = 1;
+        int startFrame = 0;                 // Primera muestra que falta por leer del archivo
+        int endFrame = 0;
+
+        // Muestras escritas y leídas desde startFrame (la escritura solo la avanza el hilo de fondo)
+        std::atomic<size_t> writePosition { 0 }, readPosition { 0 };
+        juce::HeapBlock<float> buffers[2];
+    };
+
+    struct CachedReader
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        juce::uint32 lastUsed = 0;
+        bool failed = false;                // No se vuelve a intentar abrir
+    };
+
+    void run() override;
+    bool fill (Stream& stream);
+    juce::AudioFormatReader* getReader (int source);
+
+    std::unique_ptr<Stream[]> streams;
+    std::atomic<juce::uint64> underruns { 0 }, framesRead { 0 };
+    juce::uint64 reportedUnderruns = 0;
+    juce::uint32 lastReportMs = 0;
+    int nextFreeHint = 0;                   // Solo lo usa el hilo de audio
+
+    // Kit pedido desde el hilo de mensajes; el hilo de fondo lo adopta al empezar cada pasada
+    juce::CriticalSection kitLock;
+    DrumKit::Ptr pendingKit;
+    int pendingGeneration = 0;
+
+    // Solo los usa el hilo de fondo
+    DrumKit::Ptr kit;
+    int kitGeneration = -1;
+    std::vector<CachedReader> readers;      // Uno por StreamSource, abiertos bajo demanda
+    juce::uint32 useCounter = 0;
+    juce::AudioFormatManager formatManager;
+    juce::AudioBuffer<float> readBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumStreamer)
+};
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    HitClassifier.cpp
+    Clasificación de los golpes de la entrada por pieza de la batería.
+
+  ==============================================================================
+*/
+
+#include "HitClassifier.h"
+
+//==============================================================================
+HitClassifier::Ptr HitClassifier::createDefault()
+{
+    // dB de cada banda de octava (60 Hz ... 7.7 kHz) respecto a la más fuerte
+    static constexpr float defaults[numLanes][OnsetDetector::numBands] = {
+        {   0.0f,  -3.0f, -12.0f, -20.0f, -28.0f, -32.0f, -36.0f, -40.0f },    // Bombo
+        { -18.0f, -10.0f,  -2.0f,  -4.0f,   0.0f,  -4.0f,  -8.0f, -14.0f },    // Caja
+        { -40.0f, -36.0f, -30.0f, -24.0f, -16.0f,  -8.0f,  -2.0f,   0.0f },    // Charles
+        { -10.0f,  -2.0f,   0.0f, -10.0f, -20.0f, -26.0f, -30.0f, -34.0f },    // Timbales
+        { -30.0f, -26.0f, -20.0f, -14.0f,  -8.0f,  -2.0f,   0.0f,  -2.0f }     // Platos
+    };
+
+    std::shared_ptr<HitClassifier> classifier (new HitClassifier());
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        std::copy (std::begin (defaults[lane]), std::end (defaults[lane]), classifier->centroids[(size_t) lane].begin());
+
+    return classifier;
+}
+
+HitClassifier::Ptr HitClassifier::fromString (const juce::String& text)
+{
+    // Un carril por grupo separado con ';' y sus bandas separadas con ','
+    const auto lanes = juce::StringArray::fromTokens (text, ";", {});
+    if (lanes.size() != numLanes)
+        return nullptr;
+
+    std::shared_ptr<HitClassifier> classifier (new HitClassifier());
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto values = juce::StringArray::fromTokens (lanes[lane], ",", {});
+        if (values.size() != OnsetDetector::numBands)
+            return nullptr;
+
+        for (int band = 0; band < OnsetDetector::numBands; ++band)
+            classifier->centroids[(size_t) lane][(size_t) band] = values[band].getFloatValue();
+    }
+
+    return classifier;
+}
+
+juce::String HitClassifier::toString() const
+{
+    juce::StringArray lanes;
+
+    for (const auto& centroid : centroids)
+    {
+        juce::StringArray values;
+        for (auto value : centroid)
+            values.add (juce::String (value, 1));
+
+        lanes.add (values.joinIntoString (","));
+    }
+
+    return lanes.joinIntoString (";");
+}
+
+//==============================================================================
+int HitClassifier::classify (const Features& features) const
+{
+    int bestLane = 0;
+    float bestDistance = std::numeric_limits<float>::max();
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto& centroid = centroids[(size_t) lane];
+        float distance = 0.0f;
+
+        for (int band = 0; band < OnsetDetector::numBands; ++band)
+        {
+            const float difference = features[(size_t) band] - centroid[(size_t) band];
+            distance += difference * difference;
+        }
+
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            bestLane = lane;
+        }
+    }
+
+    return bestLane;
+}
+
+int HitClassifier::getNoteNumber (int lane)
+{
+    switch (lane)
+    {
+        case kickLane:      return 36;
+        case snareLane:     return 38;
+        case hiHatLane:     return 42;
+        case tomLane:       return 45;
+        default:            return 49;     // Crash
+    }
+}
+
+int HitClassifier::getLane (int noteNumber)
+{
+    switch (noteNumber)
+    {
+        case 35: case 36:                               return kickLane;
+        case 37: case 38: case 39: case 40:             return snareLane;
+        case 42: case 44: case 46:                      return hiHatLane;
+        case 41: case 43: case 45: case 47: case 48: case 50:
+                                                        return tomLane;
+        case 49: case 51: case 52: case 53: case 55: case 57: case 59:
+                                                        return cymbalLane;
+        default:                                        return -1;
+    }
+}
+
+juce::String HitClassifier::getLaneName (int lane)
+{
+    switch (lane)
+    {
+        case kickLane:      return "Bombo";
+        case snareLane:     return "Caja";
+        case hiHatLane:     return "Charles";
+        case tomLane:       return "Timbales";
+        default:            return "Platos";
+    }
+}
+
+//==============================================================================
+void HitClassifier::Trainer::add (int lane, const Features& features)
+{
+    if (!juce::isPositiveAndBelow (lane, (int) numLanes))
+        return;
+
+    juce::FloatVectorOperations::add (sums[(size_t) lane].data(), features.data(), OnsetDetector::numBands);
+    ++counts[(size_t) lane];
+}
+
+HitClassifier::Ptr HitClassifier::Trainer::build (const HitClassifier& previous) const
+{
+    std::shared_ptr<HitClassifier> classifier (new HitClassifier (previous));
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        if (counts[(size_t) lane] > 0)
+            juce::FloatVectorOperations::multiply (classifier->centroids[(size_t) lane].data(), sums[(size_t) lane].data(),
+                                                   1.0f / (float) counts[(size_t) lane], OnsetDetector::numBands);
+
+    return classifier;
+}
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    HitClassifier.h
+    Clasificación de los golpes de la entrada por pieza de la batería.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "OnsetDetector.h"
+
+//==============================================================================
+/**
+    Asigna a cada golpe detectado un carril (bombo, caja, charles, timbales o
+    platos) por el centroide más cercano a sus features de banda. Es una tabla
+    fija de numLanes x numBands valores, así que clasificar cuesta lo mismo
+    siempre y se puede hacer en el hilo de audio.
+
+    Se comparte como std::shared_ptr<const HitClassifier>, igual que el kit.
+    Los centroides por defecto son formas de espectro típicas; con un Trainer
+    se calibran para una batería concreta tocando cada pieza unas cuantas
+    veces, y se guardan con la sesión (toString / fromString).
+*/
+class HitClassifier
+{
+public:
+    using Ptr = std::shared_ptr<const HitClassifier>;
+    using Features = OnsetDetector::Features;
+
+    enum Lane { kickLane, snareLane, hiHatLane, tomLane, cymbalLane, numLanes };
+
+    static Ptr createDefault();
+
+    // Centroides guardados con toString; nullptr si el texto no es válido
+    static Ptr fromString (const juce::String& text);
+    juce::String toString() const;
+
+    // Carril más parecido a las features de un golpe
+    int classify (const Features& features) const;
+
+    // Nota GM con la que se dibuja un carril y carril de una nota GM (-1 si no es de batería)
+    static int getNoteNumber (int lane);
+    static int getLane (int noteNumber);
+    static juce::String getLaneName (int lane);
+
+    //==============================================================================
+    // Calibración (hilo de mensajes): media de las features de los golpes de cada carril
+    class Trainer
+    {
+    public:
+        void add (int lane, const Features& features);
+        int getNumExamples (int lane) const     { return counts[(size_t) lane]; }
+
+        // Clasificador con las medias entrenadas; los carriles sin ejemplos conservan los de previous
+        Ptr build (const HitClassifier& previous) const;
+
+    private:
+        std::array<Features, numLanes> sums {};
+        std::array<int, numLanes> counts {};
+    };
+
+private:
+    HitClassifier() = default;
+
+    std::array<Features, numLanes> centroids {};
+
+    JUCE_LEAK_DETECTOR (HitClassifier)
+};
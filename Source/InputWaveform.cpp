@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    InputWaveform.cpp
+    Picos de la entrada de audio para el carril de forma de onda.
+
+  ==============================================================================
+*/
+
+#include "InputWaveform.h"
+
+//==============================================================================
+InputWaveform::InputWaveform()
+{
+    prepare (44100.0);
+}
+
+void InputWaveform::prepare (double sampleRate)
+{
+    samplesPerBucket = juce::jmax (1, juce::roundToInt (bucketSeconds * sampleRate));
+    reset();
+}
+
+void InputWaveform::reset()
+{
+    bucketPosition = 0;
+}
+
+//==============================================================================
+void InputWaveform::process (const juce::AudioBuffer<float>& input, int numChannels, int numSamples, const TransportTimeline& timeline)
+{
+    numChannels = juce::jmin (numChannels, input.getNumChannels());
+
+    if (numChannels <= 0)
+        return;
+
+    int position = 0;
+
+    // Los intervalos son de tamaño fijo: se completan con lo que traiga cada bloque
+    while (position < numSamples)
+    {
+        if (bucketPosition == 0)
+        {
+            bucket.time = timeline.getSeconds (timeline.firstSample + position);
+            bucket.minimum = std::numeric_limits<float>::max();
+            bucket.maximum = std::numeric_limits<float>::lowest();
+        }
+
+        const int count = juce::jmin (samplesPerBucket - bucketPosition, numSamples - position);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax (input.getReadPointer (channel, position), count);
+            bucket.minimum = juce::jmin (bucket.minimum, range.getStart());
+            bucket.maximum = juce::jmax (bucket.maximum, range.getEnd());
+        }
+
+        bucketPosition += count;
+        position += count;
+
+        if (bucketPosition == samplesPerBucket)
+        {
+            fifo.write (1).forEach ([this] (int slot)
+            {
+                queue[(size_t) slot] = bucket;
+            });
+
+            bucketPosition = 0;
+        }
+    }
+}
+
+int InputWaveform::read (Peak* destination, int maximum)
+{
+    int numPeaks = 0;
+
+    fifo.read (maximum).forEach ([&] (int slot)
+    {
+        destination[numPeaks++] = queue[(size_t) slot];
+    });
+
+    return numPeaks;
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    InputWaveform.h
+    Picos de la entrada de audio para el carril de forma de onda.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TransportTimeline.h"
+
+//==============================================================================
+/**
+    Reduce la entrada de audio a un par mínimo/máximo por cada intervalo de
+    bucketSeconds (unas 44 muestras a 44.1 kHz) y lo deja en una cola de un
+    productor (processBlock) y un consumidor (editor). Al editor nunca llegan
+    muestras, solo picos con el tiempo de la canción en que empezó su
+    intervalo, así que lo que se dibuja va sincronizado con la partitura.
+
+    process() no reserva memoria ni bloquea; si el editor no vacía la cola
+    (cerrado), los picos que no caben se descartan.
+*/
+class InputWaveform
+{
+public:
+    struct Peak
+    {
+        double time = 0.0;          // Tiempo de la canción al empezar el intervalo
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+    };
+
+    InputWaveform();
+
+    // Muestras por intervalo para la frecuencia del host (fuera del hilo de audio)
+    void prepare (double sampleRate);
+
+    // Descarta el intervalo a medias (al buscar)
+    void reset();
+
+    // Analiza numSamples muestras de los numChannels primeros canales; el bloque empieza en timeline.firstSample
+    void process (const juce::AudioBuffer<float>& input, int numChannels, int numSamples, const TransportTimeline& timeline);
+
+    // Saca como mucho maximum picos de la cola (un solo lector). Sin locks.
+    int read (Peak* destination, int maximum);
+
+    static constexpr double bucketSeconds = 0.001;
+    static constexpr int queueSize = 8192;          // Unos 8 s de picos
+
+private:
+    juce::AbstractFifo fifo { queueSize };
+    std::array<Peak, queueSize> queue;
+
+    int samplesPerBucket = 44;
+    int bucketPosition = 0;                 // Muestras ya acumuladas en bucket
+    Peak bucket;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InputWaveform)
+};
@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+    LoadBenchmark.cpp
+    Microbenchmarks de las rutas de carga, parseo y consulta de archivos MIDI.
+
+  ==============================================================================
+*/
+
+#include "LoadBenchmark.h"
+#include "PluginProcessor.h"
+#include "StressChartGenerator.h"
+#include "SongCacheFile.h"
+#include "SharedSongCache.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+#else
+ #include <sys/resource.h>
+ #include <cstdio>
+#endif
+
+namespace
+{
+    // Logger que descarta los mensajes, para que writeToLog no contamine las mediciones
+    struct SilentLogger : public juce::Logger
+    {
+        void logMessage (const juce::String&) override {}
+    };
+
+   #if JUCE_LINUX
+    // Campo en kB de /proc/self/status ("VmHWM", "VmRSS") en bytes, o 0 si no está
+    juce::int64 readProcessStatusBytes (const juce::String& field)
+    {
+        const auto lines = juce::StringArray::fromLines (juce::File ("/proc/self/status").loadFileAsString());
+
+        for (const auto& line : lines)
+            if (line.startsWith (field + ":"))
+                return line.fromFirstOccurrenceOf (":", false, false).trim().getLargeIntValue() * 1024;
+
+        return 0;
+    }
+   #endif
+}
+
+//==============================================================================
+LoadBenchmark::LoadBenchmark()
+{
+}
+
+LoadBenchmark::~LoadBenchmark()
+{
+}
+
+void LoadBenchmark::addCorpusFile (const juce::File& file)
+{
+    if (file.existsAsFile())
+        corpus.addIfNotAlreadyThere (file);
+}
+
+void LoadBenchmark::addCorpusDirectory (const juce::File& directory)
+{
+    for (const auto& entry : juce::RangedDirectoryIterator (directory, true, "*.mid;*.midi"))
+        addCorpusFile (entry.getFile());
+}
+
+void LoadBenchmark::addSyntheticFile (int numEvents)
+{
+    // Carta de estrés: dos pistas, seis teclas en garrapateas al 50 % y cambios de tempo,
+    // con la duración ajustada para obtener aproximadamente numEvents eventos de nota
+    StressChartGenerator::Options options;
+    options.numTracks = 2;
+    options.numKeys = 6;
+    options.stepsPerQuarter = 16;
+    options.hitProbability = 0.5;
+    options.minBpm = 100.0;
+    options.maxBpm = 140.0;
+    options.tempoChangesPerMinute = 2.0;
+    options.seed = numEvents;
+    options.lengthSeconds = juce::jmax (1.0, numEvents / StressChartGenerator::getNoteEventsPerSecond (options));
+
+    auto* temp = syntheticFiles.add (new juce::TemporaryFile (".mid"));
+    if (StressChartGenerator::writeToFile (options, temp->getFile()))
+        corpus.add (temp->getFile());
+}
+
+int LoadBenchmark::getNumCorpusFiles() const
+{
+    return corpus.size();
+}
+
+void LoadBenchmark::setMinimumSecondsPerCase (double seconds)
+{
+    minimumSecondsPerCase = juce::jmax (0.0, seconds);
+}
+
+//==============================================================================
+juce::Array<LoadBenchmark::CaseResult> LoadBenchmark::run()
+{
+    juce::Array<CaseResult> results;
+
+    SilentLogger silentLogger;
+    auto* previousLogger = juce::Logger::getCurrentLogger();
+    juce::Logger::setCurrentLogger (&silentLogger);
+
+    // Las cachés van a un directorio temporal: borrarlas para el caso sin caché no toca las del usuario
+    const auto cacheDirectory = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                    .getNonexistentChildFile ("drumVisualizerBenchmark", {}, false);
+    cacheDirectory.createDirectory();
+    SongCacheFile::setCacheDirectoryOverride (cacheDirectory);
+
+    juce::SharedResourcePointer<SharedSongCache> songCache;
+
+    for (const auto& file : corpus)
+    {
+        DrumVisualizerAudioProcessor processor;
+
+        // Sin la canción anterior ni lo que el procesador retiene hasta el siguiente bloque de
+        // audio: si no, la carga siguiente sería un acierto de la caché compartida
+        const auto dropSong = [&]
+        {
+            processor.clearMidiData();
+            processor.releaseRetiredObjects();
+        };
+
+        // Comprobación antes de medir: la carga tiene que contar como fallo de la caché compartida
+        const auto loadsFromScratch = [&] (const std::function<void()>& load)
+        {
+            const int missesBefore = songCache->getStatistics().misses;
+            load();
+            return songCache->getStatistics().misses > missesBefore;
+        };
+
+        const auto coldLoad = [&]
+        {
+            dropSong();
+            SongCacheFile::remove (file);
+            processor.loadMidiFile (file);
+        };
+
+        const auto cachedLoad = [&]
+        {
+            dropSong();
+            processor.loadMidiFile (file);
+        };
+
+        // La carga se mide primero: sin caché, desde la caché en disco y compartida en memoria
+        // (la canción sigue cargada). El resto de casos consulta el archivo ya cargado.
+        // Si otra instancia retiene la canción, los casos sin compartir se marcan como no válidos.
+        const juce::String sharedWarning = " (no válido: compartida)";
+
+        const bool coldIsMiss = loadsFromScratch (coldLoad);
+        auto coldLoadResult = measure ("loadMidiFile (sin caché)", file, 0, coldLoad);
+
+        const bool cachedIsMiss = loadsFromScratch (cachedLoad);
+        auto cachedLoadResult = measure ("loadMidiFile (caché)", file, 0, cachedLoad);
+
+        if (!coldIsMiss)
+            coldLoadResult.caseName << sharedWarning;
+
+        if (!cachedIsMiss)
+            cachedLoadResult.caseName << sharedWarning;
+
+        const auto sharedLoadResult = measure ("loadMidiFile (compartida)", file, 0, [&] { processor.loadMidiFile (file); });
+
+        if (!processor.hasMidiLoaded())
+            continue;
+
+        const int numEvents = processor.getPreparedSong()->getSummary().numEvents;
+
+        for (auto loadCase : { coldLoadResult, cachedLoadResult, sharedLoadResult })
+        {
+            loadCase.numEvents = numEvents;
+            loadCase.eventsPerSecond = loadCase.secondsPerIteration > 0.0 ? numEvents / loadCase.secondsPerIteration : 0.0;
+            results.add (loadCase);
+        }
+
+        results.add (measure ("getAllNotes (recorrido)", file, numEvents, [&]
+        {
+            const auto notes = processor.getAllNotes();
+            juce::ignoreUnused (std::distance (notes.begin(), notes.end()));
+        }));
+
+        results.add (measure ("getLowestNote/getHighestNote", file, numEvents, [&]
+        {
+            juce::ignoreUnused (processor.getLowestNote(), processor.getHighestNote());
+        }));
+
+        results.add (measure ("getTempoFromMidi", file, numEvents, [&]
+        {
+            juce::ignoreUnused (processor.getTempoFromMidi());
+        }));
+
+        results.add (measure ("getFirstNoteTime", file, numEvents, [&]
+        {
+            juce::ignoreUnused (processor.getFirstNoteTime());
+        }));
+    }
+
+    // Los procesadores ya no existen: nada tiene abiertas (paginadas) las cachés temporales
+    SongCacheFile::setCacheDirectoryOverride ({});
+    cacheDirectory.deleteRecursively();
+
+    juce::Logger::setCurrentLogger (previousLogger);
+    return results;
+}
+
+LoadBenchmark::CaseResult LoadBenchmark::measure (const juce::String& caseName, const juce::File& file, int numEvents,
+                                                  const std::function<void()>& body)
+{
+    CaseResult result;
+    result.fileName = file.getFileName();
+    result.caseName = caseName;
+    result.numEvents = numEvents;
+
+    // El pico del proceso incluye todos los casos anteriores: solo se reporta si se puede
+    // reiniciar, y como lo que el caso sube sobre la memoria residente al empezar
+    const bool peakReset = resetPeakMemory();
+    const auto residentBefore = getResidentMemoryBytes();
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    double elapsed = 0.0;
+
+    // Repetir hasta superar el tiempo mínimo (al menos una iteración)
+    do
+    {
+        body();
+        ++result.iterations;
+        elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    }
+    while (elapsed < minimumSecondsPerCase);
+
+    result.secondsPerIteration = elapsed / result.iterations;
+    result.eventsPerSecond = result.secondsPerIteration > 0.0 ? numEvents / result.secondsPerIteration : 0.0;
+
+    if (peakReset)
+        result.peakMemoryBytes = juce::jmax ((juce::int64) 0, getPeakMemoryBytes() - residentBefore);
+
+    return result;
+}
+
+//==============================================================================
+juce::String LoadBenchmark::formatReport (const juce::Array<CaseResult>& results)
+{
+    juce::String report;
+    report << juce::String ("archivo").paddedRight (' ', 32)
+           << juce::String ("caso").paddedRight (' ', 30)
+           << juce::String ("eventos").paddedLeft (' ', 10)
+           << juce::String ("iter").paddedLeft (' ', 8)
+           << juce::String ("ms/iter").paddedLeft (' ', 12)
+           << juce::String ("eventos/s").paddedLeft (' ', 14)
+           << juce::String ("pico MB").paddedLeft (' ', 10) << juce::newLine;
+
+    for (const auto& r : results)
+    {
+        report << r.fileName.substring (0, 31).paddedRight (' ', 32)
+               << r.caseName.paddedRight (' ', 30)
+               << juce::String (r.numEvents).paddedLeft (' ', 10)
+               << juce::String (r.iterations).paddedLeft (' ', 8)
+               << juce::String (r.secondsPerIteration * 1000.0, 3).paddedLeft (' ', 12)
+               << juce::String ((juce::int64) r.eventsPerSecond).paddedLeft (' ', 14)
+               << (r.peakMemoryBytes < 0 ? juce::String ("-")
+                                         : juce::String ((double) r.peakMemoryBytes / (1024.0 * 1024.0), 1)).paddedLeft (' ', 10)
+               << juce::newLine;
+    }
+
+    return report;
+}
+
+//==============================================================================
+juce::int64 LoadBenchmark::getPeakMemoryBytes()
+{
+   #if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+        return (juce::int64) counters.PeakWorkingSetSize;
+    return 0;
+   #elif JUCE_LINUX
+    // VmHWM, a diferencia de ru_maxrss, se reinicia con clear_refs
+    return readProcessStatusBytes ("VmHWM");
+   #else
+    struct rusage usage;
+    if (getrusage (RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return (juce::int64) usage.ru_maxrss;           // bytes en macOS
+   #endif
+}
+
+juce::int64 LoadBenchmark::getResidentMemoryBytes()
+{
+   #if JUCE_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+        return (juce::int64) counters.WorkingSetSize;
+    return 0;
+   #elif JUCE_LINUX
+    return readProcessStatusBytes ("VmRSS");
+   #else
+    return 0;
+   #endif
+}
+
+bool LoadBenchmark::resetPeakMemory()
+{
+   #if JUCE_LINUX
+    // Solo Linux permite reiniciar el high-water mark; en el resto de plataformas el pico
+    // es el acumulado del proceso y no dice nada de un caso concreto
+    if (auto* clearRefs = std::fopen ("/proc/self/clear_refs", "w"))
+    {
+        const bool written = std::fputs ("5", clearRefs) >= 0;
+        return std::fclose (clearRefs) == 0 && written;
+    }
+   #endif
+
+    return false;
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    LoadBenchmark.h
+    Microbenchmarks de las rutas de carga, parseo y consulta de archivos MIDI.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Ejecuta loadMidiFile, getAllNotes, getLowestNote/getHighestNote,
+    getTempoFromMidi y getFirstNoteTime sobre un corpus de archivos MIDI
+    (reales y sintéticos) y mide tiempo, throughput y memoria pico.
+*/
+class LoadBenchmark
+{
+public:
+    // Resultado de un caso (una función medida sobre un archivo)
+    struct CaseResult
+    {
+        juce::String fileName;
+        juce::String caseName;
+        int numEvents = 0;
+        int iterations = 0;
+        double secondsPerIteration = 0.0;
+        double eventsPerSecond = 0.0;
+        juce::int64 peakMemoryBytes = -1;   // Pico del caso sobre la memoria residente al empezarlo;
+                                            // -1 donde el pico del proceso no se puede reiniciar
+    };
+
+    LoadBenchmark();
+    ~LoadBenchmark();
+
+    // Construcción del corpus
+    void addCorpusFile (const juce::File& file);
+    void addCorpusDirectory (const juce::File& directory);
+    void addSyntheticFile (int numEvents);
+    int getNumCorpusFiles() const;
+
+    // Tiempo mínimo de medición por caso (se repite el caso hasta alcanzarlo)
+    void setMinimumSecondsPerCase (double seconds);
+
+    // Ejecuta todos los casos sobre todo el corpus
+    juce::Array<CaseResult> run();
+
+    static juce::String formatReport (const juce::Array<CaseResult>& results);
+
+    // Memoria pico (high-water mark) y residente del proceso en bytes, o 0 si no está disponible
+    static juce::int64 getPeakMemoryBytes();
+    static juce::int64 getResidentMemoryBytes();
+
+private:
+    // Devuelve false si la plataforma no permite reiniciar el pico
+    static bool resetPeakMemory();
+    CaseResult measure (const juce::String& caseName, const juce::File& file, int numEvents,
+                        const std::function<void()>& body);
+
+    juce::Array<juce::File> corpus;
+    juce::OwnedArray<juce::TemporaryFile> syntheticFiles;
+    double minimumSecondsPerCase = 0.25;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadBenchmark)
+};
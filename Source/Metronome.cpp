@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    Metronome.cpp
+    Clics de compás, tiempo y subdivisión sincronizados con la rejilla de la canción.
+
+  ==============================================================================
+*/
+
+#include "Metronome.h"
+
+//==============================================================================
+Metronome::Metronome()
+{
+    prepare (44100.0, 512);
+}
+
+void Metronome::prepare (double sampleRate, int maximumBlockSize)
+{
+    // Compás más agudo y fuerte; la subdivisión, corta y suave para no tapar los tiempos
+    barClick = makeClick (sampleRate, 1760.0, 0.030, 1.0f);
+    beatClick = makeClick (sampleRate, 1320.0, 0.030, 0.7f);
+    subdivisionClick = makeClick (sampleRate, 990.0, 0.015, 0.35f);
+
+    mixBuffer.setSize (1, juce::jmax (1, maximumBlockSize));
+    reset();
+}
+
+void Metronome::reset()
+{
+    numVoices = 0;
+}
+
+//==============================================================================
+void Metronome::render (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                        const BeatGrid& grid, const TransportTimeline& timeline, int division)
+{
+    // Si el host entrega bloques mayores que los anunciados, se mezclan por partes
+    for (int done = 0; done < numSamples;)
+    {
+        const int chunkSize = juce::jmin (numSamples - done, mixBuffer.getNumSamples());
+        renderChunk (chunkSize, grid, timeline, timeline.firstSample + done, division);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::addWithMultiply (buffer.getWritePointer (channel, startSample + done),
+                                                          mixBuffer.getReadPointer (0), outputLevel, chunkSize);
+
+        done += chunkSize;
+    }
+}
+
+void Metronome::renderChunk (int numSamples, const BeatGrid& grid, const TransportTimeline& timeline, juce::int64 firstSample, int division)
+{
+    auto* mix = mixBuffer.getWritePointer (0);
+    juce::FloatVectorOperations::clear (mix, numSamples);
+
+    // Continuar los clics que empezaron en bloques anteriores
+    int keptVoices = 0;
+
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto voice = voices[(size_t) i];
+        const int count = juce::jmin (voice.remaining, numSamples);
+        juce::FloatVectorOperations::add (mix, voice.samples, count);
+
+        voice.samples += count;
+        voice.remaining -= count;
+
+        if (voice.remaining > 0)
+            voices[(size_t) keptVoices++] = voice;
+    }
+
+    numVoices = keptVoices;
+
+    // Los extremos salen del ancla: ninguna línea se pierde ni se repite entre bloques
+    const double startSeconds = timeline.getSeconds (firstSample);
+    const double endSeconds = timeline.getSeconds (firstSample + numSamples);
+
+    const auto& lines = grid.getLines();
+    const auto range = grid.findLines (startSeconds, endSeconds);
+
+    for (auto index = range.first; index < range.second; ++index)
+    {
+        const auto& line = lines[index];
+        if (line.time >= endSeconds || !BeatGrid::isVisible (line, division))
+            continue;
+
+        // Primera muestra cuyo tiempo alcanza el de la línea
+        const int offset = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples - 1,
+                                               timeline.getSampleAtOrAfter (line.time) - firstSample);
+
+        const auto& click = getClick (line.type);
+        const int length = (int) click.size();
+        const int count = juce::jmin (length, numSamples - offset);
+        juce::FloatVectorOperations::add (mix + offset, click.data(), count);
+
+        // El resto suena en los bloques siguientes; sin voces libres se corta
+        if (count < length && numVoices < maximumVoices)
+            voices[(size_t) numVoices++] = { click.data() + count, length - count };
+    }
+}
+
+const std::vector<float>& Metronome::getClick (BeatGrid::LineType type) const
+{
+    switch (type)
+    {
+        case BeatGrid::LineType::bar:   return barClick;
+        case BeatGrid::LineType::beat:  return beatClick;
+        default:                        return subdivisionClick;
+    }
+}
+
+std::vector<float> Metronome::makeClick (double sampleRate, double frequency, double lengthSeconds, float gain)
+{
+    // Seno con caída exponencial; empieza en cero para no producir un escalón
+    std::vector<float> click ((size_t) juce::jmax (1, juce::roundToInt (sampleRate * lengthSeconds)));
+    const double decaySamples = (double) click.size() / 5.0;
+
+    for (size_t i = 0; i < click.size(); ++i)
+    {
+        const double phase = juce::MathConstants<double>::twoPi * frequency * (double) i / sampleRate;
+        click[i] = gain * (float) (std::sin (phase) * std::exp (-(double) i / decaySamples));
+    }
+
+    return click;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    Metronome.h
+    Clics de compás, tiempo y subdivisión sincronizados con la rejilla de la canción.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BeatGrid.h"
+#include "TransportTimeline.h"
+
+//==============================================================================
+/**
+    Metrónomo del hilo de audio. Las formas de onda de los tres clics (compás,
+    tiempo y subdivisión) se calculan una vez en prepare(); en cada bloque se
+    buscan en la BeatGrid las líneas que caen dentro del bloque y cada clic se
+    suma entero en su muestra exacta con FloatVectorOperations. Los clics que
+    no terminan en el bloque siguen sonando en el siguiente desde una lista de
+    voces de tamaño fijo.
+
+    La posición de cada bloque sale del TransportTimeline, así que el clic cae
+    en la misma muestra sea cual sea el tamaño de bloque. render() no reserva
+    memoria ni bloquea.
+*/
+class Metronome
+{
+public:
+    Metronome();
+
+    // Calcula los clics y reserva el buffer de mezcla (fuera del hilo de audio)
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    // Corta los clics que están sonando (al buscar otra posición)
+    void reset();
+
+    // Suma al buffer los clics del bloque; division es la figura elegida (4, 8 o 16)
+    void render (juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                 const BeatGrid& grid, const TransportTimeline& timeline, int division);
+
+    static constexpr int maximumVoices = 8;         // Clics superpuestos como máximo
+    static constexpr float outputLevel = 0.5f;
+
+private:
+    struct Voice
+    {
+        const float* samples = nullptr;             // Lo que queda por sonar del clic
+        int remaining = 0;
+    };
+
+    const std::vector<float>& getClick (BeatGrid::LineType type) const;
+    void renderChunk (int numSamples, const BeatGrid& grid, const TransportTimeline& timeline, juce::int64 firstSample, int division);
+
+    static std::vector<float> makeClick (double sampleRate, double frequency, double lengthSeconds, float gain);
+
+    std::vector<float> barClick, beatClick, subdivisionClick;
+    std::array<Voice, maximumVoices> voices;
+    int numVoices = 0;
+    juce::AudioBuffer<float> mixBuffer;             // Mezcla mono del bloque; se suma a cada canal
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Metronome)
+};
@@ -0,0 +1,579 @@
+/*
+  ==============================================================================
+
+    MidiLibrary.cpp
+    Biblioteca de archivos MIDI: escaneo paralelo e índice persistente de metadatos.
+
+  ==============================================================================
+*/
+
+#include "MidiLibrary.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+//==============================================================================
+namespace
+{
+    // Lectura de los bytes del SMF con comprobación de límites
+    struct SmfReader
+    {
+        const juce::uint8* data;
+        size_t size;
+        size_t position = 0;
+
+        bool canRead (size_t numBytes) const
+        {
+            return size - position >= numBytes;
+        }
+
+        juce::uint32 readBigEndian (int numBytes)
+        {
+            juce::uint32 value = 0;
+            for (int i = 0; i < numBytes; ++i)
+                value = (value << 8) | data[position++];
+            return value;
+        }
+
+        bool readVariableLength (juce::uint32& value, size_t end)
+        {
+            value = 0;
+
+            for (int i = 0; i < 4 && position < end; ++i)
+            {
+                const auto byte = data[position++];
+                value = (value << 7) | (byte & 0x7f);
+
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+    };
+
+    struct TempoEvent
+    {
+        juce::int64 tick;
+        juce::uint32 microsecondsPerQuarter;
+    };
+}
+
+//==============================================================================
+MidiLibrary::MidiLibrary()
+    : MidiLibrary (getDefaultIndexFile())
+{
+}
+
+MidiLibrary::MidiLibrary (const juce::File& file)
+    : indexFile (file), entries (std::make_shared<const std::vector<Entry>>())
+{
+    loadIndex();
+}
+
+MidiLibrary::~MidiLibrary()
+{
+}
+
+MidiLibrary::Snapshot MidiLibrary::getSnapshot() const
+{
+    return std::atomic_load (&entries);
+}
+
+int MidiLibrary::getNumEntries() const
+{
+    return (int) getSnapshot()->size();
+}
+
+juce::File MidiLibrary::getDefaultIndexFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("drumVisualizer")
+               .getChildFile ("LibraryIndex.dvidx");
+}
+
+//==============================================================================
+MidiLibrary::ScanResult MidiLibrary::scan (const juce::Array<juce::File>& directories, int numThreads,
+                                           std::function<bool()> shouldExit)
+{
+    const juce::ScopedLock sl (scanLock);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    ScanResult result;
+    std::atomic<bool> cancelled { false };
+
+    // Se consulta desde todos los hilos del escaneo; una vez cancelado no se vuelve a llamar
+    auto isCancelled = [&]
+    {
+        if (!cancelled && shouldExit != nullptr && shouldExit())
+            cancelled = true;
+
+        return cancelled.load();
+    };
+
+    const auto previous = getSnapshot();
+
+    std::unordered_map<juce::String, const Entry*> known;
+    for (const auto& entry : *previous)
+        known[entry.path] = &entry;
+
+    // Recorrer las carpetas: los archivos sin cambios de tamaño ni fecha reutilizan su entrada
+    std::vector<Entry> updated;
+    std::vector<Entry> toRead;
+    std::unordered_set<juce::String> seen;
+
+    for (const auto& directory : directories)
+    {
+        for (const auto& item : juce::RangedDirectoryIterator (directory, true, "*.mid;*.midi", juce::File::findFiles))
+        {
+            if (isCancelled())
+                break;
+
+            auto path = item.getFile().getFullPathName();
+            if (!seen.insert (path).second)
+                continue; // Carpetas anidadas en la lista
+
+            ++result.numFiles;
+
+            const auto fileSize = item.getFileSize();
+            const auto modificationTime = item.getModificationTime().toMilliseconds();
+            const auto found = known.find (path);
+
+            if (found != known.end() && found->second->fileSize == fileSize
+                && found->second->modificationTime == modificationTime)
+            {
+                updated.push_back (*found->second);
+                continue;
+            }
+
+            Entry entry;
+            entry.path = std::move (path);
+            toRead.push_back (std::move (entry));
+        }
+    }
+
+    // Las entradas fuera de las carpetas escaneadas se conservan; las de dentro que ya no existen se quitan
+    for (const auto& entry : *previous)
+    {
+        if (seen.count (entry.path) > 0)
+            continue;
+
+        const juce::File file (entry.path);
+        const bool insideScan = std::any_of (directories.begin(), directories.end(),
+                                             [&file] (const juce::File& directory) { return file.isAChildOf (directory); });
+
+        if (insideScan)
+            ++result.numRemoved;
+        else
+            updated.push_back (entry);
+    }
+
+    // Leer los archivos nuevos o modificados repartiéndolos entre todos los hilos
+    const int total = (int) toRead.size();
+    std::vector<char> readOk ((size_t) total, 0);
+    std::atomic<int> nextIndex { 0 };
+    std::atomic<int> numDone { 0 };
+
+    if (total > 0)
+    {
+        const int threads = juce::jmin (total, numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus());
+        juce::ThreadPool pool (threads);
+
+        for (int i = 0; i < threads; ++i)
+        {
+            pool.addJob ([&toRead, &readOk, &nextIndex, &numDone, &isCancelled, total]
+            {
+                for (int index = nextIndex++; index < total; index = nextIndex++)
+                {
+                    // Cancelado: los archivos que quedan se cuentan sin leerlos
+                    if (!isCancelled())
+                    {
+                        auto& entry = toRead[(size_t) index];
+                        readOk[(size_t) index] = readMetadata (juce::File (entry.path), entry) ? 1 : 0;
+                    }
+
+                    ++numDone;
+                }
+            });
+        }
+
+        while (numDone < total)
+        {
+            if (onScanProgress != nullptr)
+                onScanProgress (numDone, total);
+
+            juce::Thread::sleep (50);
+        }
+
+        if (onScanProgress != nullptr)
+            onScanProgress (total, total);
+    }
+
+    if (isCancelled())
+    {
+        result.cancelled = true;
+        result.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        return result;
+    }
+
+    for (int i = 0; i < total; ++i)
+    {
+        if (readOk[(size_t) i] != 0)
+            updated.push_back (std::move (toRead[(size_t) i]));
+        else
+            ++result.numFailed;
+    }
+
+    result.numRead = total - result.numFailed;
+
+    std::sort (updated.begin(), updated.end(), [] (const Entry& a, const Entry& b) { return a.path < b.path; });
+    std::atomic_store (&entries, Snapshot (std::make_shared<const std::vector<Entry>> (std::move (updated))));
+
+    if (!saveIndex())
+        juce::Logger::writeToLog ("Aviso: No se pudo guardar el índice de la biblioteca en " + indexFile.getFullPathName());
+
+    result.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    return result;
+}
+
+std::vector<MidiLibrary::Entry> MidiLibrary::search (const Query& query) const
+{
+    const auto snapshot = getSnapshot();
+
+    auto words = juce::StringArray::fromTokens (query.text.toLowerCase(), true);
+    words.removeEmptyStrings();
+
+    std::vector<Entry> results;
+
+    for (const auto& entry : *snapshot)
+    {
+        if ((int) results.size() >= query.maxResults)
+            break;
+
+        if ((query.minBpm > 0.0 && entry.maxBpm < query.minBpm)
+            || (query.maxBpm > 0.0 && entry.minBpm > query.maxBpm)
+            || (query.minLengthSeconds > 0.0 && entry.lengthSeconds < query.minLengthSeconds)
+            || (query.maxLengthSeconds > 0.0 && entry.lengthSeconds > query.maxLengthSeconds))
+            continue;
+
+        const bool matchesText = std::all_of (words.begin(), words.end(),
+                                              [&entry] (const juce::String& word) { return entry.searchText.contains (word); });
+
+        if (matchesText)
+            results.push_back (entry);
+    }
+
+    return results;
+}
+
+void MidiLibrary::updateSearchText (Entry& entry)
+{
+    entry.searchText = (juce::File (entry.path).getFileNameWithoutExtension() + " "
+                        + entry.trackNames.joinIntoString (" ")).toLowerCase();
+}
+
+//==============================================================================
+bool MidiLibrary::readMetadata (const juce::File& file, Entry& entry)
+{
+    juce::MemoryMappedFile mapped (file, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr)
+        return false;
+
+    SmfReader reader { static_cast<const juce::uint8*> (mapped.getData()), mapped.getSize() };
+
+    // Cabecera MThd: formato, número de pistas y división
+    if (!reader.canRead (14) || std::memcmp (reader.data, "MThd", 4) != 0)
+        return false;
+
+    reader.position = 4;
+    const auto headerLength = reader.readBigEndian (4);
+    if (headerLength < 6 || !reader.canRead (headerLength))
+        return false;
+
+    reader.readBigEndian (2); // Formato
+    const int numTracks = (int) reader.readBigEndian (2);
+    const auto division = reader.readBigEndian (2);
+    reader.position = 8 + headerLength;
+
+    entry = Entry();
+    entry.path = file.getFullPathName();
+    entry.fileSize = file.getSize();
+    entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+
+    std::vector<TempoEvent> tempoEvents;
+    juce::int64 lastTick = 0;
+    juce::int64 timeSignatureTick = std::numeric_limits<juce::int64>::max();
+    int lowestNote = 127, highestNote = 0;
+
+    for (int track = 0; track < numTracks && reader.canRead (8);)
+    {
+        const bool isTrack = std::memcmp (reader.data + reader.position, "MTrk", 4) == 0;
+        reader.position += 4;
+
+        // Un archivo truncado se lee hasta donde llegue
+        const size_t chunkLength = juce::jmin ((size_t) reader.readBigEndian (4), reader.size - reader.position);
+        const size_t end = reader.position + chunkLength;
+
+        if (!isTrack)
+        {
+            reader.position = end;
+            continue;
+        }
+
+        ++track;
+
+        juce::int64 tick = 0;
+        juce::uint8 runningStatus = 0;
+
+        while (reader.position < end)
+        {
+            juce::uint32 delta = 0;
+            if (!reader.readVariableLength (delta, end) || reader.position >= end)
+                break;
+
+            tick += delta;
+            lastTick = juce::jmax (lastTick, tick);
+
+            auto status = reader.data[reader.position];
+
+            if ((status & 0x80) != 0)
+                ++reader.position;
+            else if (runningStatus != 0)
+                status = runningStatus;
+            else
+                break;
+
+            if (status == 0xff)
+            {
+                // Meta evento: solo interesan tempo, compás, nombre de pista y fin de pista
+                runningStatus = 0;
+                juce::uint32 length = 0;
+
+                if (reader.position >= end)
+                    break;
+
+                const auto type = reader.data[reader.position++];
+                if (!reader.readVariableLength (length, end) || length > end - reader.position)
+                    break;
+
+                const auto* payload = reader.data + reader.position;
+                reader.position += length;
+
+                if (type == 0x51 && length == 3)
+                {
+                    tempoEvents.push_back ({ tick, (juce::uint32) ((payload[0] << 16) | (payload[1] << 8) | payload[2]) });
+                }
+                else if (type == 0x58 && length >= 2 && tick < timeSignatureTick)
+                {
+                    timeSignatureTick = tick;
+                    entry.timeSigNumerator = juce::jmax (1, (int) payload[0]);
+                    entry.timeSigDenominator = 1 << juce::jmin (7, (int) payload[1]);
+                }
+                else if (type == 0x03 && length > 0)
+                {
+                    const auto name = juce::String::fromUTF8 (reinterpret_cast<const char*> (payload), (int) length).trim();
+                    if (name.isNotEmpty())
+                        entry.trackNames.addIfNotAlreadyThere (name);
+                }
+                else if (type == 0x2f)
+                {
+                    break;
+                }
+            }
+            else if (status == 0xf0 || status == 0xf7)
+            {
+                // SysEx: se salta
+                runningStatus = 0;
+                juce::uint32 length = 0;
+
+                if (!reader.readVariableLength (length, end) || length > end - reader.position)
+                    break;
+
+                reader.position += length;
+            }
+            else if (status > 0xf0)
+            {
+                break; // Mensajes de sistema no válidos dentro de un SMF
+            }
+            else
+            {
+                runningStatus = status;
+                const size_t numDataBytes = ((status & 0xf0) == 0xc0 || (status & 0xf0) == 0xd0) ? 1 : 2;
+
+                if (end - reader.position < numDataBytes)
+                    break;
+
+                if ((status & 0xf0) == 0x90 && reader.data[reader.position + 1] > 0)
+                {
+                    const int noteNumber = reader.data[reader.position] & 0x7f;
+                    ++entry.numNotes;
+                    lowestNote = juce::jmin (lowestNote, noteNumber);
+                    highestNote = juce::jmax (highestNote, noteNumber);
+                }
+
+                reader.position += numDataBytes;
+            }
+        }
+
+        reader.position = end;
+    }
+
+    if (entry.numNotes > 0)
+    {
+        entry.lowestNote = lowestNote;
+        entry.highestNote = highestNote;
+    }
+
+    // Duración: SMPTE con ticks por frame, o negras integrando el mapa de tempo
+    if ((division & 0x8000) != 0)
+    {
+        const int framesPerSecond = -(int) (juce::int8) (division >> 8);
+        const int ticksPerFrame = (int) (division & 0xff);
+
+        if (framesPerSecond <= 0 || ticksPerFrame <= 0)
+            return false;
+
+        entry.lengthSeconds = (double) lastTick / (framesPerSecond * ticksPerFrame);
+    }
+    else
+    {
+        if (division == 0)
+            return false;
+
+        std::stable_sort (tempoEvents.begin(), tempoEvents.end(),
+                          [] (const TempoEvent& a, const TempoEvent& b) { return a.tick < b.tick; });
+
+        const double ticksPerQuarter = (double) division;
+        double seconds = 0.0;
+        juce::int64 previousTick = 0;
+        juce::uint32 microsecondsPerQuarter = 500000;
+
+        for (const auto& tempo : tempoEvents)
+        {
+            if (tempo.tick >= lastTick)
+                break;
+
+            seconds += (double) (tempo.tick - previousTick) * microsecondsPerQuarter / (ticksPerQuarter * 1000000.0);
+            previousTick = tempo.tick;
+            microsecondsPerQuarter = tempo.microsecondsPerQuarter;
+        }
+
+        entry.lengthSeconds = seconds + (double) (lastTick - previousTick) * microsecondsPerQuarter / (ticksPerQuarter * 1000000.0);
+    }
+
+    // Rango de tempo (120 BPM si el archivo no tiene eventos de tempo)
+    bool foundTempo = false;
+
+    for (const auto& tempo : tempoEvents)
+    {
+        if (tempo.microsecondsPerQuarter == 0)
+            continue;
+
+        const double bpm = 60000000.0 / tempo.microsecondsPerQuarter;
+        entry.minBpm = foundTempo ? juce::jmin (entry.minBpm, bpm) : bpm;
+        entry.maxBpm = foundTempo ? juce::jmax (entry.maxBpm, bpm) : bpm;
+        foundTempo = true;
+    }
+
+    updateSearchText (entry);
+    return true;
+}
+
+//==============================================================================
+bool MidiLibrary::loadIndex()
+{
+    juce::MemoryBlock block;
+    if (!indexFile.existsAsFile() || !indexFile.loadFileAsData (block))
+        return false;
+
+    juce::MemoryInputStream in (block, false);
+
+    if (in.readInt() != indexMagic || in.readInt() != indexVersion)
+        return false;
+
+    // Cada entrada ocupa al menos su ruta vacía (1 byte), 5 valores de 8 bytes y 6 de 4:
+    // un recuento mayor que lo que queda es un índice dañado, no algo que reservar
+    constexpr juce::int64 minimumEntryBytes = 1 + 5 * 8 + 6 * 4;
+
+    const int numEntries = in.readInt();
+    if (numEntries < 0 || numEntries > in.getNumBytesRemaining() / minimumEntryBytes)
+        return false;
+
+    std::vector<Entry> loaded;
+    loaded.reserve ((size_t) numEntries);
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        Entry entry;
+        entry.path = in.readString();
+        entry.fileSize = in.readInt64();
+        entry.modificationTime = in.readInt64();
+        entry.lengthSeconds = in.readDouble();
+        entry.minBpm = in.readDouble();
+        entry.maxBpm = in.readDouble();
+        entry.numNotes = in.readInt();
+        entry.lowestNote = in.readInt();
+        entry.highestNote = in.readInt();
+        entry.timeSigNumerator = in.readInt();
+        entry.timeSigDenominator = in.readInt();
+
+        const int numTrackNames = in.readInt();
+        for (int name = 0; name < numTrackNames && !in.isExhausted(); ++name)
+            entry.trackNames.add (in.readString());
+
+        if (in.isExhausted() && i < numEntries - 1)
+            return false; // Índice truncado
+
+        updateSearchText (entry);
+        loaded.push_back (std::move (entry));
+    }
+
+    std::atomic_store (&entries, Snapshot (std::make_shared<const std::vector<Entry>> (std::move (loaded))));
+    return true;
+}
+
+bool MidiLibrary::saveIndex() const
+{
+    const auto snapshot = getSnapshot();
+
+    if (!indexFile.getParentDirectory().createDirectory())
+        return false;
+
+    // Escribir en un temporal y reemplazar para no dejar un índice a medias
+    juce::TemporaryFile temporary (indexFile);
+
+    {
+        juce::FileOutputStream out (temporary.getFile());
+        if (!out.openedOk())
+            return false;
+
+        out.writeInt (indexMagic);
+        out.writeInt (indexVersion);
+        out.writeInt ((int) snapshot->size());
+
+        for (const auto& entry : *snapshot)
+        {
+            out.writeString (entry.path);
+            out.writeInt64 (entry.fileSize);
+            out.writeInt64 (entry.modificationTime);
+            out.writeDouble (entry.lengthSeconds);
+            out.writeDouble (entry.minBpm);
+            out.writeDouble (entry.maxBpm);
+            out.writeInt (entry.numNotes);
+            out.writeInt (entry.lowestNote);
+            out.writeInt (entry.highestNote);
+            out.writeInt (entry.timeSigNumerator);
+            out.writeInt (entry.timeSigDenominator);
+            out.writeInt (entry.trackNames.size());
+
+            for (const auto& name : entry.trackNames)
+                out.writeString (name);
+        }
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    MidiLibrary.h
+    Biblioteca de archivos MIDI: escaneo paralelo e índice persistente de metadatos.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Recorre carpetas de forma recursiva, extrae los metadatos de cada MIDI con
+    una sola pasada sobre los bytes del SMF (sin construir un juce::MidiFile) y
+    los guarda en un índice en disco. Al volver a escanear solo se leen los
+    archivos nuevos o cuyo tamaño/fecha cambió.
+
+    Las búsquedas trabajan sobre una instantánea inmutable del índice, así que se
+    pueden hacer desde el hilo de mensajes mientras otro hilo escanea. Se usa a
+    través de juce::SharedResourcePointer para compartir un único índice.
+*/
+class MidiLibrary
+{
+public:
+    struct Entry
+    {
+        juce::String path;
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;   // Milisegundos desde 1970
+        double lengthSeconds = 0.0;
+        double minBpm = 120.0;
+        double maxBpm = 120.0;
+        int numNotes = 0;                   // Note On con velocidad > 0
+        int lowestNote = 0;                 // 0 si no hay notas
+        int highestNote = 127;              // 127 si no hay notas
+        int timeSigNumerator = 4;           // Primer compás del archivo
+        int timeSigDenominator = 4;
+        juce::StringArray trackNames;
+
+        juce::String searchText;            // Nombre de archivo y pistas en minúsculas (no se guarda)
+    };
+
+    // Filtros de búsqueda; los límites a 0 no filtran
+    struct Query
+    {
+        juce::String text;                  // Palabras que deben aparecer en el nombre o las pistas
+        double minBpm = 0.0, maxBpm = 0.0;
+        double minLengthSeconds = 0.0, maxLengthSeconds = 0.0;
+        int maxResults = 100;
+    };
+
+    struct ScanResult
+    {
+        int numFiles = 0;                   // Archivos MIDI encontrados en las carpetas
+        int numRead = 0;                    // Archivos leídos (nuevos o modificados)
+        int numFailed = 0;                  // Archivos que no son SMF válidos
+        int numRemoved = 0;                 // Entradas de archivos que ya no existen
+        bool cancelled = false;             // shouldExit lo interrumpió: índice sin cambios
+        double seconds = 0.0;
+    };
+
+    // Carga el índice por defecto del usuario (si existe)
+    MidiLibrary();
+    explicit MidiLibrary (const juce::File& indexFile);
+    ~MidiLibrary();
+
+    // Escanea las carpetas en un pool de hilos (0 = uno por núcleo) y guarda el índice.
+    // Bloquea hasta terminar; llamar desde un hilo de fondo. Si shouldExit devuelve true
+    // (se consulta entre archivos) el escaneo se abandona sin tocar la biblioteca.
+    ScanResult scan (const juce::Array<juce::File>& directories, int numThreads = 0,
+                     std::function<bool()> shouldExit = {});
+
+    // Se llama desde el hilo que escanea con (archivos leídos, archivos por leer)
+    std::function<void (int, int)> onScanProgress;
+
+    std::vector<Entry> search (const Query& query) const;
+    int getNumEntries() const;
+
+    bool loadIndex();
+    bool saveIndex() const;
+
+    // Extrae los metadatos leyendo los chunks del SMF directamente
+    static bool readMetadata (const juce::File& file, Entry& entry);
+
+    static juce::File getDefaultIndexFile();
+
+private:
+    using Snapshot = std::shared_ptr<const std::vector<Entry>>;
+
+    Snapshot getSnapshot() const;
+    static void updateSearchText (Entry& entry);
+
+    juce::File indexFile;
+    Snapshot entries;               // Ordenadas por ruta; acceso con std::atomic_load/atomic_store
+    juce::CriticalSection scanLock; // Un solo escaneo a la vez
+
+    static constexpr int indexMagic = 0x44564c49;   // "DVLI"
+    static constexpr int indexVersion = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiLibrary)
+};
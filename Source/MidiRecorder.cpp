@@ -0,0 +1,372 @@
+/*
+  ==============================================================================
+
+    MidiRecorder.cpp
+    Grabación de lo que se toca (pads MIDI y golpes de la entrada) en un .mid.
+
+  ==============================================================================
+*/
+
+#include "MidiRecorder.h"
+
+namespace
+{
+    // Cabecera MThd (14 bytes) y MTrk: la longitud de la pista va justo antes de sus datos
+    constexpr juce::int64 trackLengthPosition = 18;
+    constexpr juce::int64 trackDataPosition = 22;
+
+    const juce::uint8 tempoEvent[] = { 0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20 };    // 500000 µs por negra
+    const juce::uint8 endOfTrackEvent[] = { 0x00, 0xff, 0x2f, 0x00 };
+
+    bool isEarlier (const MidiRecorder::Event& a, const MidiRecorder::Event& b)
+    {
+        return a.time < b.time;
+    }
+
+    void writeVariableLength (juce::OutputStream& out, juce::int64 value)
+    {
+        auto remaining = (juce::uint32) juce::jlimit ((juce::int64) 0, (juce::int64) 0x0fffffff, value);
+        juce::uint8 bytes[4];
+        int numBytes = 0;
+
+        bytes[numBytes++] = (juce::uint8) (remaining & 0x7f);
+
+        while ((remaining >>= 7) != 0)
+            bytes[numBytes++] = (juce::uint8) ((remaining & 0x7f) | 0x80);
+
+        while (numBytes > 0)
+            out.writeByte ((char) bytes[--numBytes]);
+    }
+}
+
+//==============================================================================
+MidiRecorder::MidiRecorder()
+    : juce::Thread ("MIDI recorder")
+{
+}
+
+MidiRecorder::~MidiRecorder()
+{
+    stop();
+}
+
+//==============================================================================
+bool MidiRecorder::start (const juce::File& newFile, juce::String& error)
+{
+    stop();
+
+    if (!newFile.getParentDirectory().createDirectory().wasOk())
+    {
+        error = "No se pudo crear la carpeta " + newFile.getParentDirectory().getFullPathName();
+        return false;
+    }
+
+    auto newStream = std::make_unique<juce::FileOutputStream> (newFile);
+
+    if (newStream->failedToOpen() || !newStream->setPosition (0) || newStream->truncate().failed())
+    {
+        error = "No se pudo crear " + newFile.getFullPathName();
+        return false;
+    }
+
+    // Desde el principio el archivo es un MIDI válido (vacío)
+    writeHeader (*newStream);
+    endOfTrackPosition = newStream->getPosition();
+    newStream->write (endOfTrackEvent, sizeof (endOfTrackEvent));
+    newStream->flush();
+
+    if (newStream->getStatus().failed())
+    {
+        error = "No se pudo escribir en " + newFile.getFullPathName();
+        return false;
+    }
+
+    // El pool se reserva una vez y se conserva: construir cada bloque escribe todas sus
+    // páginas aquí, así el hilo de audio no provoca fallos de página al llenarlo
+    if (chunks == nullptr)
+    {
+        chunks.reset (new Chunk[(size_t) numChunks]);
+        int index = 0;
+
+        freeFifo.write (numChunks).forEach ([&] (int slot)
+        {
+            freeQueue[(size_t) slot] = index++;
+        });
+    }
+
+    file = newFile;
+    stream = std::move (newStream);
+    trackEvents.clear();
+    numWrittenEvents = 0;
+    lastWrittenTick = 0;
+    rewritePending = false;
+    recordedEvents = 0;
+    droppedEvents = 0;
+    handOffRequested = false;
+    writingSession = ++lastSession;
+
+    startThread();
+    activeSession.store (writingSession, std::memory_order_release);
+    return true;
+}
+
+juce::File MidiRecorder::stop()
+{
+    activeSession.store (0, std::memory_order_release);
+
+    if (isThreadRunning())
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread (10000);
+    }
+
+    return file;
+}
+
+MidiRecorder::Statistics MidiRecorder::getStatistics() const
+{
+    Statistics statistics;
+    statistics.recordedEvents = recordedEvents.load (std::memory_order_relaxed);
+    statistics.droppedEvents = droppedEvents.load (std::memory_order_relaxed);
+    return statistics;
+}
+
+//==============================================================================
+void MidiRecorder::beginBlock()
+{
+    const bool requested = handOffRequested.exchange (false, std::memory_order_relaxed);
+
+    // Al parar (o empezar otra toma) el bloque a medio llenar se entrega sin esperar a que se pida
+    if (currentChunk >= 0
+        && (requested || chunks[(size_t) currentChunk].session != activeSession.load (std::memory_order_acquire)))
+        handOff();
+}
+
+void MidiRecorder::add (double time, const juce::uint8* data, int size)
+{
+    const int session = activeSession.load (std::memory_order_acquire);
+
+    if (session == 0 || size < 1 || size > 3 || data[0] < 0x80 || data[0] >= 0xf0)
+        return;
+
+    if (currentChunk >= 0 && chunks[(size_t) currentChunk].session != session)
+        handOff();
+
+    if (currentChunk < 0)
+    {
+        freeFifo.read (1).forEach ([this] (int slot)
+        {
+            currentChunk = freeQueue[(size_t) slot];
+        });
+
+        if (currentChunk < 0)
+        {
+            droppedEvents.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        chunks[(size_t) currentChunk].session = session;
+        chunks[(size_t) currentChunk].count = 0;
+        holdingChunk.store (true, std::memory_order_release);
+    }
+
+    auto& chunk = chunks[(size_t) currentChunk];
+    auto& event = chunk.events[(size_t) chunk.count++];
+    event.time = time;
+    event.size = (juce::uint8) size;
+    std::copy (data, data + size, event.data);
+
+    recordedEvents.fetch_add (1, std::memory_order_relaxed);
+
+    if (chunk.count == eventsPerChunk)
+        handOff();
+}
+
+void MidiRecorder::addHit (double time, int noteNumber, float strength)
+{
+    const auto note = (juce::uint8) juce::jlimit (0, 127, noteNumber);
+    const auto velocity = (juce::uint8) juce::jlimit (1, 127, juce::roundToInt (strength * 127.0f));
+
+    const juce::uint8 noteOn[] = { 0x99, note, velocity };
+    const juce::uint8 noteOff[] = { 0x89, note, 0 };
+
+    add (time, noteOn, 3);
+    add (time, noteOff, 3);
+}
+
+void MidiRecorder::handOff()
+{
+    // Hay tantos huecos como bloques: la cola de llenos nunca está completa
+    fullFifo.write (1).forEach ([this] (int slot)
+    {
+        fullQueue[(size_t) slot] = currentChunk;
+    });
+
+    currentChunk = -1;
+    holdingChunk.store (false, std::memory_order_release);
+}
+
+//==============================================================================
+void MidiRecorder::run()
+{
+    auto nextFlush = juce::Time::getMillisecondCounter() + (juce::uint32) flushIntervalMs;
+
+    while (!threadShouldExit())
+    {
+        wait (pollIntervalMs);
+        drainChunks();
+
+        const auto now = juce::Time::getMillisecondCounter();
+
+        if (now >= nextFlush)
+        {
+            writePendingEvents();
+
+            // Lo que el hilo de audio tenga a medio llenar entra en la siguiente escritura
+            handOffRequested.store (true, std::memory_order_relaxed);
+            nextFlush = now + (juce::uint32) flushIntervalMs;
+        }
+    }
+
+    // El último bloque llega en cuanto el host procese otro bloque; si no lo hace, se pierde
+    for (int i = 0; i < 50 && holdingChunk.load (std::memory_order_acquire); ++i)
+        juce::Thread::sleep (10);
+
+    drainChunks();
+    writePendingEvents();
+    stream.reset();
+
+    juce::Logger::writeToLog ("Toma grabada: " + file.getFullPathName() + " ("
+                              + juce::String ((juce::int64) trackEvents.size()) + " eventos, "
+                              + juce::String (droppedEvents.load()) + " descartados)");
+}
+
+void MidiRecorder::drainChunks()
+{
+    fullFifo.read (fullFifo.getNumReady()).forEach ([this] (int slot)
+    {
+        const int index = fullQueue[(size_t) slot];
+        const auto& chunk = chunks[(size_t) index];
+
+        // Un bloque de una toma anterior que el hilo de audio entregó tarde se descarta
+        if (chunk.session == writingSession)
+            trackEvents.insert (trackEvents.end(), chunk.events.begin(), chunk.events.begin() + chunk.count);
+
+        freeFifo.write (1).forEach ([&] (int freeSlot)
+        {
+            freeQueue[(size_t) freeSlot] = index;
+        });
+    });
+}
+
+bool MidiRecorder::writePendingEvents()
+{
+    if (rewritePending)
+        return rewriteFile();
+
+    if (stream == nullptr || numWrittenEvents == trackEvents.size())
+        return true;
+
+    const auto firstNew = trackEvents.begin() + (std::ptrdiff_t) numWrittenEvents;
+    std::stable_sort (firstNew, trackEvents.end(), isEarlier);
+
+    // Tras una búsqueda hacia atrás los nuevos caen antes de lo ya escrito
+    if (numWrittenEvents > 0 && firstNew->time < trackEvents[numWrittenEvents - 1].time)
+        return rewriteFile();
+
+    // Los eventos nuevos sustituyen al fin de pista, que se vuelve a escribir detrás
+    stream->setPosition (endOfTrackPosition);
+
+    for (auto event = firstNew; event != trackEvents.end(); ++event)
+        writeEvent (*stream, *event, lastWrittenTick);
+
+    endOfTrackPosition = stream->getPosition();
+    stream->write (endOfTrackEvent, sizeof (endOfTrackEvent));
+    stream->flush();
+
+    // La longitud se corrige al final, cuando los datos ya están en el archivo
+    stream->setPosition (trackLengthPosition);
+    stream->writeIntBigEndian ((int) (endOfTrackPosition + (juce::int64) sizeof (endOfTrackEvent) - trackDataPosition));
+    stream->flush();
+
+    numWrittenEvents = trackEvents.size();
+
+    if (stream->getStatus().failed())
+    {
+        juce::Logger::writeToLog ("Error al escribir la toma: " + stream->getStatus().getErrorMessage());
+        return false;
+    }
+
+    return true;
+}
+
+bool MidiRecorder::rewriteFile()
+{
+    std::stable_sort (trackEvents.begin(), trackEvents.end(), isEarlier);
+
+    juce::MemoryOutputStream data;
+    juce::int64 lastTick = 0;
+    writeHeader (data);
+
+    for (const auto& event : trackEvents)
+        writeEvent (data, event, lastTick);
+
+    const auto endOfTrack = data.getPosition();
+    data.write (endOfTrackEvent, sizeof (endOfTrackEvent));
+    data.setPosition (trackLengthPosition);
+    data.writeIntBigEndian ((int) (endOfTrack + (juce::int64) sizeof (endOfTrackEvent) - trackDataPosition));
+
+    // Sobre un temporal: si algo falla, la toma anterior queda intacta y se reintenta en la
+    // siguiente escritura (lo ya escrito ya no es un prefijo de trackEvents)
+    rewritePending = true;
+    stream.reset();
+
+    juce::TemporaryFile temporary (file);
+    const bool replaced = temporary.getFile().replaceWithData (data.getData(), data.getDataSize())
+                          && temporary.overwriteTargetFileWithTemporary();
+
+    // Se abre al final del archivo; la siguiente escritura se coloca en endOfTrackPosition
+    stream = std::make_unique<juce::FileOutputStream> (file);
+
+    if (stream->failedToOpen())
+    {
+        juce::Logger::writeToLog ("Error al reabrir la toma: " + file.getFullPathName());
+        stream.reset();
+        return false;
+    }
+
+    if (!replaced)
+    {
+        juce::Logger::writeToLog ("Error al reescribir la toma: " + file.getFullPathName());
+        return false;
+    }
+
+    endOfTrackPosition = endOfTrack;
+    lastWrittenTick = lastTick;
+    numWrittenEvents = trackEvents.size();
+    rewritePending = false;
+    return true;
+}
+
+void MidiRecorder::writeHeader (juce::OutputStream& out)
+{
+    out.write ("MThd", 4);
+    out.writeIntBigEndian (6);
+    out.writeShortBigEndian (0);        // Formato 0: una sola pista
+    out.writeShortBigEndian (1);
+    out.writeShortBigEndian ((short) ticksPerQuarterNote);
+
+    out.write ("MTrk", 4);
+    out.writeIntBigEndian ((int) (sizeof (tempoEvent) + sizeof (endOfTrackEvent)));
+    out.write (tempoEvent, sizeof (tempoEvent));
+}
+
+void MidiRecorder::writeEvent (juce::OutputStream& out, const Event& event, juce::int64& lastTick)
+{
+    const auto tick = juce::jmax (lastTick, (juce::int64) std::llround (juce::jmax (0.0, event.time) * ticksPerSecond));
+
+    writeVariableLength (out, tick - lastTick);
+    out.write (event.data, (size_t) event.size);
+    lastTick = tick;
+}
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    MidiRecorder.h
+    Grabación de lo que se toca (pads MIDI y golpes de la entrada) en un .mid.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Graba los golpes del hilo de audio en un archivo MIDI estándar (formato 0)
+    mientras se practica, para abrirlo después junto a la carta.
+
+    El hilo de audio no reserva memoria ni toma locks: escribe los eventos en
+    bloques de un pool reservado (y tocado página a página) al empezar la
+    primera grabación. Los índices de los bloques libres y de los llenos pasan
+    de un hilo a otro por dos colas AbstractFifo de un productor y un
+    consumidor, así que una sesión larga no hace crecer nada en el hilo de
+    audio. Si el pool se agota, los eventos se descartan y se cuentan.
+
+    El hilo de escritura vacía los bloques llenos y cada flushIntervalMs añade
+    los eventos nuevos al final de la pista y corrige su longitud: si el
+    programa se cierra de golpe, el archivo sigue siendo un MIDI válido con
+    todo lo tocado hasta uno o dos intervalos antes. El bloque a medio llenar
+    se pide al hilo de audio en cada intervalo.
+
+    Los tiempos son segundos de la canción; se escriben a tempo fijo
+    (ticksPerQuarterNote a 120 BPM), así que al cargar la toma cada golpe cae
+    en el mismo segundo que la nota de la carta. Si llegan eventos anteriores
+    a los ya escritos (una búsqueda hacia atrás), la toma se reescribe entera,
+    ordenada, sobre un archivo temporal.
+*/
+class MidiRecorder : private juce::Thread
+{
+public:
+    struct Event
+    {
+        double time = 0.0;              // Segundos de la canción
+        juce::uint8 data[3] {};
+        juce::uint8 size = 0;
+    };
+
+    struct Statistics
+    {
+        juce::int64 recordedEvents = 0;
+        juce::int64 droppedEvents = 0;  // Pool agotado (el hilo de escritura no da abasto)
+    };
+
+    MidiRecorder();
+    ~MidiRecorder() override;
+
+    //==============================================================================
+    // Hilo de mensajes
+    bool start (const juce::File& file, juce::String& error);
+    juce::File stop();                  // Termina el archivo y devuelve su ruta
+
+    juce::File getFile() const          { return file; }
+    Statistics getStatistics() const;
+
+    //==============================================================================
+    // Hilo de audio. Sin reservas de memoria ni locks.
+    bool isRecording() const            { return activeSession.load (std::memory_order_acquire) != 0; }
+
+    // Al empezar cada bloque (también en pausa): entrega el bloque a medio llenar si se pidió
+    void beginBlock();
+
+    // Mensaje de canal de 1 a 3 bytes (lo demás se ignora)
+    void add (double time, const juce::uint8* data, int size);
+
+    // Golpe detectado en la entrada: Note On y Note Off en el canal de batería
+    void addHit (double time, int noteNumber, float strength);
+
+    static constexpr int eventsPerChunk = 256;              // 4 KB por bloque
+    static constexpr int numChunks = 512;
+    static constexpr int ticksPerQuarterNote = 960;
+    static constexpr double ticksPerSecond = ticksPerQuarterNote * 2.0;     // 120 BPM
+    static constexpr int flushIntervalMs = 1000;
+    static constexpr int pollIntervalMs = 50;
+
+private:
+    struct Chunk
+    {
+        int session = 0;
+        int count = 0;
+        std::array<Event, eventsPerChunk> events;
+    };
+
+    void run() override;
+
+    void handOff();
+    void drainChunks();
+    bool writePendingEvents();
+    bool rewriteFile();
+    static void writeHeader (juce::OutputStream& out);
+    static void writeEvent (juce::OutputStream& out, const Event& event, juce::int64& lastTick);
+
+    // Compartido: pool y colas de índices (tamaño numChunks + 1: AbstractFifo deja un hueco libre)
+    std::unique_ptr<Chunk[]> chunks;
+    juce::AbstractFifo freeFifo { numChunks + 1 };
+    juce::AbstractFifo fullFifo { numChunks + 1 };
+    std::array<int, numChunks + 1> freeQueue {};
+    std::array<int, numChunks + 1> fullQueue {};
+
+    std::atomic<int> activeSession { 0 };       // 0 sin grabar
+    std::atomic<bool> handOffRequested { false };
+    std::atomic<bool> holdingChunk { false };   // El hilo de audio tiene un bloque a medio llenar
+    std::atomic<juce::int64> recordedEvents { 0 };
+    std::atomic<juce::int64> droppedEvents { 0 };
+
+    // Solo hilo de audio
+    int currentChunk = -1;
+
+    // Solo hilo de mensajes
+    int lastSession = 0;
+
+    // Hilo de escritura (start() lo prepara antes de arrancarlo)
+    juce::File file;
+    int writingSession = 0;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::vector<Event> trackEvents;             // Toda la toma, por si hay que reescribirla
+    size_t numWrittenEvents = 0;
+    juce::int64 lastWrittenTick = 0;
+    juce::int64 endOfTrackPosition = 0;         // Donde empieza el evento de fin de pista
+    bool rewritePending = false;                // Falló una reescritura: se reintenta entera
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiRecorder)
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    MinimapComponent.cpp
+    Vista general de la canción sobre el piano roll, con búsqueda por clic.
+
+  ==============================================================================
+*/
+
+#include "MinimapComponent.h"
+
+//==============================================================================
+MinimapComponent::MinimapComponent()
+{
+    setOpaque (true);
+    setMouseCursor (juce::MouseCursor::PointingHandCursor);
+}
+
+MinimapComponent::~MinimapComponent()
+{
+}
+
+void MinimapComponent::setSong (PreparedSong::Ptr newSong, juce::Image prerenderedOverview)
+{
+    song = std::move (newSong);
+    cachedImage = std::move (prerenderedOverview);
+    playheadTime = 0.0;
+    repaint();
+}
+
+void MinimapComponent::setPlayheadTime (double seconds)
+{
+    if (seconds == playheadTime)
+        return;
+
+    // Repintar solo la zona del cursor anterior y la del nuevo
+    repaint (getPlayheadBounds (playheadTime));
+    playheadTime = seconds;
+    repaint (getPlayheadBounds (playheadTime));
+}
+
+//==============================================================================
+void MinimapComponent::paint (juce::Graphics& g)
+{
+    if (cachedImage.isNull() || cachedImage.getWidth() != getWidth() || cachedImage.getHeight() != getHeight())
+        cachedImage = renderOverview (song.get(), getWidth(), getHeight());
+
+    g.drawImageAt (cachedImage, 0, 0);
+
+    if (song != nullptr)
+    {
+        g.setColour (juce::Colours::white);
+        g.fillRect (getPlayheadBounds (playheadTime).withSizeKeepingCentre (2, getHeight()));
+    }
+}
+
+void MinimapComponent::resized()
+{
+    cachedImage = {};
+}
+
+juce::Image MinimapComponent::renderOverview (const PreparedSong* song, int width, int height)
+{
+    width = juce::jmax (1, width);
+    height = juce::jmax (1, height);
+
+    // Imagen de software: se puede generar en un hilo de fondo (precarga del setlist)
+    juce::Image image (juce::Image::RGB, width, height, true, juce::SoftwareImageType());
+    juce::Graphics g (image);
+    g.fillAll (juce::Colour (0xff1a1a1a));
+
+    if (song == nullptr || song->getSummary().lengthSeconds <= 0.0)
+        return image;
+
+    const auto& density = song->getDensity();
+    const double lengthSeconds = song->getSummary().lengthSeconds;
+    const int level = density.getLevelForResolution (lengthSeconds / width);
+    const double bucketSeconds = density.getBucketSeconds (level);
+
+    // Golpes y velocidad máxima por columna sumando todos los carriles
+    std::vector<int> counts ((size_t) width, 0);
+    std::vector<int> velocities ((size_t) width, 0);
+    int maxCount = 1;
+
+    for (int x = 0; x < width; ++x)
+    {
+        const double columnStart = lengthSeconds * x / width;
+        const double columnEnd = lengthSeconds * (x + 1) / width;
+        const int firstBucket = (int) (columnStart / bucketSeconds);
+        const int lastBucket = juce::jmax (firstBucket, (int) (columnEnd / bucketSeconds) - 1);
+
+        for (int noteNumber = 0; noteNumber < 128; ++noteNumber)
+        {
+            if (!density.hasLane (noteNumber))
+                continue;
+
+            for (int bucket = firstBucket; bucket <= lastBucket; ++bucket)
+            {
+                const auto cell = density.getBucket (level, noteNumber, bucket);
+                counts[(size_t) x] += cell.count;
+                velocities[(size_t) x] = juce::jmax (velocities[(size_t) x], cell.maxVelocity);
+            }
+        }
+
+        maxCount = juce::jmax (maxCount, counts[(size_t) x]);
+    }
+
+    // Barras con altura proporcional a la raíz de la densidad (las partes tranquilas siguen visibles)
+    for (int x = 0; x < width; ++x)
+    {
+        if (counts[(size_t) x] == 0)
+            continue;
+
+        const float amount = std::sqrt ((float) counts[(size_t) x] / (float) maxCount);
+        const float barHeight = juce::jmax (1.0f, amount * (float) height);
+        const float velocity = (float) velocities[(size_t) x] / 127.0f;
+
+        g.setColour (juce::Colour::fromHSV (0.6f, 0.9f, 0.4f + velocity * 0.6f, 1.0f));
+        g.fillRect ((float) x, (float) height - barHeight, 1.0f, barHeight);
+    }
+
+    return image;
+}
+
+//==============================================================================
+void MinimapComponent::mouseDown (const juce::MouseEvent& event)
+{
+    if (song != nullptr && onSeek != nullptr)
+        onSeek (xToTime (event.position.x));
+}
+
+void MinimapComponent::mouseDrag (const juce::MouseEvent& event)
+{
+    mouseDown (event);
+}
+
+double MinimapComponent::xToTime (float x) const
+{
+    if (song == nullptr || getWidth() <= 0)
+        return 0.0;
+
+    const double proportion = juce::jlimit (0.0, 1.0, (double) x / getWidth());
+    return proportion * song->getSummary().lengthSeconds;
+}
+
+float MinimapComponent::timeToX (double seconds) const
+{
+    if (song == nullptr || song->getSummary().lengthSeconds <= 0.0)
+        return 0.0f;
+
+    return (float) (seconds / song->getSummary().lengthSeconds * getWidth());
+}
+
+juce::Rectangle<int> MinimapComponent::getPlayheadBounds (double seconds) const
+{
+    return { juce::roundToInt (timeToX (seconds)) - 2, 0, 4, getHeight() };
+}
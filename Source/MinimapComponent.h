@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    MinimapComponent.h
+    Vista general de la canción sobre el piano roll, con búsqueda por clic.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreparedSong.h"
+
+//==============================================================================
+/**
+    Franja con la densidad de golpes de toda la canción. La imagen se genera una
+    sola vez por canción y tamaño a partir de la pirámide de densidad; cada
+    repintado solo dibuja la imagen cacheada y el cursor. Hacer clic o arrastrar
+    llama a onSeek con el tiempo correspondiente.
+*/
+class MinimapComponent : public juce::Component
+{
+public:
+    MinimapComponent();
+    ~MinimapComponent() override;
+
+    // Si se pasa una imagen ya generada del tamaño del componente, se usa sin volver a dibujarla
+    void setSong (PreparedSong::Ptr newSong, juce::Image prerenderedOverview = {});
+    void setPlayheadTime (double seconds);
+
+    // Se llama al hacer clic o arrastrar con el tiempo de destino en segundos
+    std::function<void (double)> onSeek;
+
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown (const juce::MouseEvent& event) override;
+    void mouseDrag (const juce::MouseEvent& event) override;
+
+    // Dibuja la vista general en una imagen de software; se puede llamar desde cualquier hilo
+    static juce::Image renderOverview (const PreparedSong* song, int width, int height);
+
+private:
+    double xToTime (float x) const;
+    float timeToX (double seconds) const;
+    juce::Rectangle<int> getPlayheadBounds (double seconds) const;
+
+    PreparedSong::Ptr song;
+    juce::Image cachedImage;
+    double playheadTime = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MinimapComponent)
+};
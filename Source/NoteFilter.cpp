@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    NoteFilter.cpp
+    Máscaras de visibilidad por pista, canal MIDI y nota.
+
+  ==============================================================================
+*/
+
+#include "NoteFilter.h"
+
+//==============================================================================
+bool NoteFilter::isTrackVisible (int track) const
+{
+    return !juce::isPositiveAndBelow (track, maximumTracks) || !hiddenTracks[(size_t) track];
+}
+
+bool NoteFilter::isChannelVisible (int channel) const
+{
+    return !juce::isPositiveAndBelow (channel - 1, 16) || (hiddenChannels & (1u << (channel - 1))) == 0;
+}
+
+bool NoteFilter::isNoteVisible (int noteNumber) const
+{
+    return !juce::isPositiveAndBelow (noteNumber, 128) || !hiddenNotes[(size_t) noteNumber];
+}
+
+void NoteFilter::setTrackVisible (int track, bool shouldBeVisible)
+{
+    if (juce::isPositiveAndBelow (track, maximumTracks))
+        hiddenTracks.set ((size_t) track, !shouldBeVisible);
+}
+
+void NoteFilter::setChannelVisible (int channel, bool shouldBeVisible)
+{
+    if (!juce::isPositiveAndBelow (channel - 1, 16))
+        return;
+
+    const auto bit = (juce::uint16) (1u << (channel - 1));
+    hiddenChannels = (juce::uint16) (shouldBeVisible ? (hiddenChannels & ~bit) : (hiddenChannels | bit));
+}
+
+void NoteFilter::setNoteVisible (int noteNumber, bool shouldBeVisible)
+{
+    if (juce::isPositiveAndBelow (noteNumber, 128))
+        hiddenNotes.set ((size_t) noteNumber, !shouldBeVisible);
+}
+
+bool NoteFilter::isControllerVisible (int controller) const
+{
+    return juce::isPositiveAndBelow (controller, 128) && visibleControllers[(size_t) controller];
+}
+
+void NoteFilter::setControllerVisible (int controller, bool shouldBeVisible)
+{
+    if (juce::isPositiveAndBelow (controller, 128))
+        visibleControllers.set ((size_t) controller, shouldBeVisible);
+}
+
+void NoteFilter::showOnlyNotes (const juce::Array<int>& noteNumbers)
+{
+    hiddenNotes.set();
+
+    for (auto noteNumber : noteNumbers)
+        setNoteVisible (noteNumber, true);
+}
+
+void NoteFilter::showAll()
+{
+    hiddenNotes.reset();
+    hiddenTracks.reset();
+    hiddenChannels = 0;
+}
+
+bool NoteFilter::isEmpty() const
+{
+    return hiddenNotes.none() && hiddenTracks.none() && hiddenChannels == 0;
+}
+
+//==============================================================================
+juce::String NoteFilter::toString() const
+{
+    // "t:1,5;c:10;n:49,51;cc:4" con los elementos ocultos y los controladores visibles
+    const auto listIndices = [] (const auto& isListed, int count)
+    {
+        juce::StringArray items;
+        for (int i = 0; i < count; ++i)
+            if (isListed (i))
+                items.add (juce::String (i));
+
+        return items.joinIntoString (",");
+    };
+
+    return "t:" + listIndices ([this] (int i) { return hiddenTracks[(size_t) i]; }, maximumTracks)
+         + ";c:" + listIndices ([this] (int i) { return !isChannelVisible (i); }, 17)
+         + ";n:" + listIndices ([this] (int i) { return hiddenNotes[(size_t) i]; }, 128)
+         + ";cc:" + listIndices ([this] (int i) { return visibleControllers[(size_t) i]; }, 128);
+}
+
+NoteFilter NoteFilter::fromString (const juce::String& text)
+{
+    NoteFilter filter;
+
+    for (const auto& section : juce::StringArray::fromTokens (text, ";", {}))
+    {
+        const auto kind = section.upToFirstOccurrenceOf (":", false, false).trim();
+        const auto values = juce::StringArray::fromTokens (section.fromFirstOccurrenceOf (":", false, false), ",", {});
+
+        // Estados guardados antes de los carriles se quedan con los controladores por defecto
+        if (kind == "cc")
+            filter.visibleControllers.reset();
+
+        for (const auto& value : values)
+        {
+            if (value.trim().isEmpty())
+                continue;
+
+            const int index = value.getIntValue();
+
+            if (kind == "t")        filter.setTrackVisible (index, false);
+            else if (kind == "c")   filter.setChannelVisible (index, false);
+            else if (kind == "n")   filter.setNoteVisible (index, false);
+            else if (kind == "cc")  filter.setControllerVisible (index, true);
+        }
+    }
+
+    return filter;
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    NoteFilter.h
+    Máscaras de visibilidad por pista, canal MIDI y nota, y carriles de
+    controladores visibles.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <bitset>
+#include "SongNote.h"
+
+//==============================================================================
+/**
+    Qué pistas, canales y notas se ocultan en el piano roll. Cada SongNote ya
+    lleva su pista, canal y nota, así que decidir si se dibuja son tres
+    consultas de bits dentro del bucle de culling: cambiar el filtro no
+    reconstruye nada de la canción.
+
+    Por defecto no oculta nada. Las pistas a partir de maximumTracks siempre
+    se muestran.
+
+    Los carriles de controladores (CC) funcionan al revés: solo se dibujan los
+    elegidos, y por defecto el CC4 (pedal del charles).
+*/
+class NoteFilter
+{
+public:
+    static constexpr int maximumTracks = 256;
+
+    bool isVisible (const SongNote& note) const noexcept
+    {
+        return isVisible (note.track, note.channel, note.noteNumber);
+    }
+
+    // Lo mismo para un carril de la densidad (pista, canal 1..16 y nota)
+    bool isVisible (int track, int channel, int noteNumber) const noexcept
+    {
+        return !hiddenNotes[(size_t) (noteNumber & 127)]
+            && (hiddenChannels & (1u << ((channel - 1) & 15))) == 0
+            && (track >= maximumTracks || !hiddenTracks[(size_t) track]);
+    }
+
+    bool isTrackVisible (int track) const;
+    bool isChannelVisible (int channel) const;      // 1..16
+    bool isNoteVisible (int noteNumber) const;
+
+    void setTrackVisible (int track, bool shouldBeVisible);
+    void setChannelVisible (int channel, bool shouldBeVisible);
+    void setNoteVisible (int noteNumber, bool shouldBeVisible);
+
+    bool isControllerVisible (int controller) const;
+    void setControllerVisible (int controller, bool shouldBeVisible);
+
+    // Oculta todas las notas salvo las indicadas (p. ej. solo bombo y caja)
+    void showOnlyNotes (const juce::Array<int>& noteNumbers);
+    void showAll();
+
+    // true si no oculta nada (los carriles de controladores no cuentan)
+    bool isEmpty() const;
+
+    // Texto compacto para guardar en el estado del plugin
+    juce::String toString() const;
+    static NoteFilter fromString (const juce::String& text);
+
+private:
+    std::bitset<128> hiddenNotes;
+    std::bitset<maximumTracks> hiddenTracks;
+    juce::uint16 hiddenChannels = 0;
+    std::bitset<128> visibleControllers { 1u << 4 };
+
+    JUCE_LEAK_DETECTOR (NoteFilter)
+};
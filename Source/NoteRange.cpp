@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    NoteRange.cpp
+    Vista perezosa y sin copias de las notas de una canción.
+
+  ==============================================================================
+*/
+
+#include "NoteRange.h"
+
+//==============================================================================
+NoteRange::NoteRange (PreparedSong::Ptr songToUse, double startSeconds, double endSecondsToUse, const NoteFilter& filterToUse)
+    : song (std::move (songToUse)), endSeconds (endSecondsToUse), filter (filterToUse)
+{
+    if (song == nullptr || endSeconds < startSeconds)
+        return;
+
+    endIndex = song->getNotes().size();
+    firstIndex = song->findFirstNoteAtOrAfter (startSeconds);
+}
+
+NoteRange::Iterator NoteRange::begin() const
+{
+    return Iterator (*this, firstIndex);
+}
+
+NoteRange::Iterator NoteRange::end() const
+{
+    Iterator iterator;
+    iterator.range = this;
+    iterator.index = endIndex;
+    return iterator;
+}
+
+//==============================================================================
+NoteRange::Iterator::Iterator (const NoteRange& owner, size_t startIndex)
+    : range (&owner), index (startIndex)
+{
+    settle();
+}
+
+void NoteRange::Iterator::settle()
+{
+    const NoteStore* notes = range->song != nullptr ? &range->song->getNotes() : nullptr;
+
+    while (notes != nullptr && index < range->endIndex)
+    {
+        // Cambiar de bloque solo al cruzar su límite
+        if (chunk == nullptr || index % NoteStore::notesPerChunk == 0)
+        {
+            chunk = notes->getChunk (index / NoteStore::notesPerChunk);
+            if (chunk == nullptr)
+                break;
+        }
+
+        const auto& note = (*chunk)[index % NoteStore::notesPerChunk];
+
+        // Notas ordenadas por tiempo: la primera fuera del rango termina el recorrido
+        if (note.time > range->endSeconds)
+            break;
+
+        if (range->filter.isVisible (note))
+            return;
+
+        ++index;
+    }
+
+    index = range->endIndex;
+    chunk = nullptr;
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    NoteRange.h
+    Vista perezosa y sin copias de las notas de una canción.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreparedSong.h"
+#include "NoteFilter.h"
+
+//==============================================================================
+/**
+    Rango de las notas de una canción entre dos tiempos y que pasan un filtro
+    de pistas/canales/notas. No copia ni reserva nada: los iteradores recorren
+    los bloques del NoteStore en su sitio y el inicio se busca con búsqueda
+    binaria. La vista mantiene viva la canción mientras exista.
+
+    Se usa con range-for y con los algoritmos de <algorithm> (iteradores forward):
+
+        for (const auto& note : processor.getNotes (10.0, 20.0))
+            ...
+
+        auto numKicks = std::count_if (range.begin(), range.end(), ...);
+*/
+class NoteRange
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SongNote;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const SongNote*;
+        using reference = const SongNote&;
+
+        Iterator() = default;
+
+        reference operator*() const                         { return (*chunk)[index % NoteStore::notesPerChunk]; }
+        pointer operator->() const                          { return &**this; }
+
+        Iterator& operator++()                              { ++index; settle(); return *this; }
+        Iterator operator++ (int)                           { auto old = *this; ++*this; return old; }
+
+        bool operator== (const Iterator& other) const       { return index == other.index; }
+        bool operator!= (const Iterator& other) const       { return index != other.index; }
+
+    private:
+        friend class NoteRange;
+
+        Iterator (const NoteRange& owner, size_t startIndex);
+
+        // Avanza hasta la siguiente nota visible; al pasar del final queda en el índice de end()
+        void settle();
+
+        const NoteRange* range = nullptr;
+        size_t index = 0;
+        NoteStore::Chunk chunk;     // Bloque de la nota actual (no se copia el contenido)
+    };
+
+    // Rango vacío
+    NoteRange() = default;
+
+    // Notas con startSeconds <= time <= endSeconds que pasan el filtro
+    NoteRange (PreparedSong::Ptr song, double startSeconds, double endSeconds, const NoteFilter& filter = {});
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    bool empty() const      { return begin() == end(); }
+
+private:
+    PreparedSong::Ptr song;
+    double endSeconds = 0.0;
+    NoteFilter filter;
+    size_t firstIndex = 0;
+    size_t endIndex = 0;    // Índice del iterador end(): el número de notas de la canción
+};
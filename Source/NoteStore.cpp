@@ -0,0 +1,363 @@
+/*
+  ==============================================================================
+
+    NoteStore.cpp
+    Notas de una canción en bloques ordenados por tiempo, residentes o paginados.
+
+  ==============================================================================
+*/
+
+#include "NoteStore.h"
+#include "RealtimeAudit.h"
+
+//==============================================================================
+// Un único hilo de lectura para todas las canciones paginadas del proceso. prefetch()
+// lo despierta con notify() (también desde el hilo de audio); si no, repasa cada poco.
+struct NoteStore::PagingThread : public juce::Thread
+{
+    PagingThread()
+        : juce::Thread ("Note paging")
+    {
+        startThread (juce::Thread::Priority::low);
+    }
+
+    ~PagingThread() override
+    {
+        stopThread (5000);
+    }
+
+    void addStore (NoteStore* store)
+    {
+        const juce::ScopedLock sl (storesLock);
+        stores.addIfNotAlreadyThere (store);
+    }
+
+    // Espera a que el hilo termine con esta canción si la está leyendo
+    void removeStore (NoteStore* store)
+    {
+        const juce::ScopedLock sl (storesLock);
+        stores.removeFirstMatchingValue (store);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            {
+                const juce::ScopedLock sl (storesLock);
+
+                for (auto* store : stores)
+                    while (store->readAhead() && !threadShouldExit())
+                        ;
+            }
+
+            wait (pollIntervalMs);
+        }
+    }
+
+    static constexpr int pollIntervalMs = 100;
+
+    juce::CriticalSection storesLock;
+    juce::Array<NoteStore*> stores;
+};
+
+//==============================================================================
+NoteStore::ResidentChunk::ResidentChunk (ResidentChunk&& other) noexcept
+    : pin (std::exchange (other.pin, nullptr)),
+      notes (std::exchange (other.notes, nullptr))
+{
+}
+
+NoteStore::ResidentChunk::~ResidentChunk()
+{
+    if (pin != nullptr)
+        pin->fetch_sub (1);
+}
+
+//==============================================================================
+NoteStore::NoteStore()
+{
+}
+
+NoteStore::~NoteStore()
+{
+    if (pagingThread != nullptr)
+        (*pagingThread)->removeStore (this);
+}
+
+void NoteStore::setNotes (std::vector<SongNote> newNotes)
+{
+    numNotes = newNotes.size();
+    chunks.clear();
+    chunkStartTimes.clear();
+
+    for (size_t start = 0; start < numNotes; start += notesPerChunk)
+    {
+        const auto end = juce::jmin (numNotes, start + notesPerChunk);
+        chunkStartTimes.push_back (newNotes[start].time);
+        chunks.push_back (std::make_shared<const std::vector<SongNote>> (newNotes.begin() + (std::ptrdiff_t) start,
+                                                                          newNotes.begin() + (std::ptrdiff_t) end));
+    }
+
+    lastUsed.assign (chunks.size(), 0);
+    initialiseAudioAccess();
+}
+
+bool NoteStore::openPaged (const juce::File& file, juce::int64 offset, size_t count, const void* mappedNotes)
+{
+    auto stream = std::make_unique<juce::FileInputStream> (file);
+    if (!stream->openedOk() || stream->getTotalLength() < offset + (juce::int64) (count * sizeof (SongNote)))
+        return false;
+
+    numNotes = count;
+    pagedStream = std::move (stream);
+    pagedOffset = offset;
+
+    // El índice solo toca la primera nota de cada bloque (una página del archivo mapeado)
+    chunkStartTimes.clear();
+    const auto* bytes = static_cast<const char*> (mappedNotes);
+
+    for (size_t start = 0; start < count; start += notesPerChunk)
+    {
+        SongNote first;
+        std::memcpy (&first, bytes + start * sizeof (SongNote), sizeof (SongNote));
+        chunkStartTimes.push_back (first.time);
+    }
+
+    chunks.assign (chunkStartTimes.size(), nullptr);
+    lastUsed.assign (chunkStartTimes.size(), 0);
+    initialiseAudioAccess();
+
+    pagingThread = std::make_unique<juce::SharedResourcePointer<PagingThread>>();
+    (*pagingThread)->addStore (this);
+    return true;
+}
+
+void NoteStore::initialiseAudioAccess()
+{
+    residentNotes.reset (new std::atomic<const std::vector<SongNote>*>[chunks.size()]);
+    audioPins.reset (new std::atomic<int>[chunks.size()]);
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        residentNotes[i] = chunks[i].get();
+        audioPins[i] = 0;
+    }
+}
+
+//==============================================================================
+NoteStore::Chunk NoteStore::getChunk (size_t chunkIndex) const
+{
+    {
+        REALTIME_AUDIT_LOCK ("NoteStore::lock");
+        const juce::ScopedLock sl (lock);
+        if (chunkIndex >= chunks.size())
+            return {};
+
+        if (auto chunk = chunks[chunkIndex])
+        {
+            lastUsed[chunkIndex] = ++useCounter;
+            return chunk;
+        }
+    }
+
+    // Bloque no residente que el hilo no llegó a precargar: leerlo aquí
+    auto chunk = readChunk (chunkIndex);
+    if (chunk != nullptr)
+        storeChunk (chunkIndex, chunk);
+
+    return chunk;
+}
+
+NoteStore::ResidentChunk NoteStore::tryGetResidentChunk (size_t chunkIndex) const
+{
+    ResidentChunk chunk;
+
+    if (chunkIndex >= getNumChunks())
+        return chunk;
+
+    // Primero se fija y después se lee el puntero; storeChunk hace lo contrario al descartar
+    // (quita el puntero y después mira si hay lectores), así nunca libera uno en uso
+    auto& pin = audioPins[chunkIndex];
+    pin.fetch_add (1);
+
+    if (auto* notes = residentNotes[chunkIndex].load())
+    {
+        chunk.pin = &pin;
+        chunk.notes = notes;
+    }
+    else
+    {
+        pin.fetch_sub (1);
+    }
+
+    return chunk;
+}
+
+bool NoteStore::findFirstResidentAtOrAfter (double seconds, size_t& index) const
+{
+    const auto next = getChunkForTime (seconds);
+    if (next == 0)
+    {
+        index = 0;
+        return true;
+    }
+
+    const auto chunk = tryGetResidentChunk (next - 1);
+    if (!chunk)
+        return false;
+
+    auto found = std::lower_bound (chunk->begin(), chunk->end(), seconds,
+                                   [] (const SongNote& note, double time) { return note.time < time; });
+    index = (next - 1) * notesPerChunk + (size_t) std::distance (chunk->begin(), found);
+    return true;
+}
+
+size_t NoteStore::findFirstAtOrAfter (double seconds) const
+{
+    // Primer bloque que empieza en o después de seconds: la respuesta está al final del bloque
+    // anterior o es la primera nota de este
+    const auto next = getChunkForTime (seconds);
+    if (next == 0)
+        return 0;
+
+    const auto chunk = getChunk (next - 1);
+    if (chunk == nullptr)
+        return (next - 1) * notesPerChunk;
+
+    auto found = std::lower_bound (chunk->begin(), chunk->end(), seconds,
+                                   [] (const SongNote& note, double time) { return note.time < time; });
+    return (next - 1) * notesPerChunk + (size_t) std::distance (chunk->begin(), found);
+}
+
+void NoteStore::prefetch (double seconds) const
+{
+    if (!isPaged())
+        return;
+
+    const auto next = getChunkForTime (seconds);
+    const auto chunkIndex = next > 0 ? next - 1 : 0;
+
+    // Solo se despierta al hilo cuando cambia el bloque (una vez cada notesPerChunk notas)
+    if (requestedChunk.exchange (chunkIndex) != chunkIndex)
+        (*pagingThread)->notify();
+}
+
+size_t NoteStore::getMemoryBytes() const
+{
+    const juce::ScopedLock sl (lock);
+
+    size_t total = chunkStartTimes.capacity() * sizeof (double)
+                 + chunks.capacity() * sizeof (Chunk)
+                 + lastUsed.capacity() * sizeof (juce::uint32);
+
+    for (const auto& chunk : chunks)
+        if (chunk != nullptr)
+            total += chunk->capacity() * sizeof (SongNote);
+
+    return total;
+}
+
+//==============================================================================
+bool NoteStore::readAhead()
+{
+    const auto first = requestedChunk.load();
+
+    for (auto chunkIndex = first; chunkIndex < juce::jmin (getNumChunks(), first + 1 + prefetchChunks); ++chunkIndex)
+    {
+        {
+            // Los bloques de la ventana que ya están cuentan como recién usados: el hilo de audio
+            // no puede marcarlos y si no serían los primeros en descartarse
+            const juce::ScopedLock sl (lock);
+            if (chunks[chunkIndex] != nullptr)
+            {
+                lastUsed[chunkIndex] = ++useCounter;
+                continue;
+            }
+        }
+
+        if (auto chunk = readChunk (chunkIndex))
+            storeChunk (chunkIndex, std::move (chunk));
+
+        // Si la posición cambió mientras se leía, empezar de nuevo por la nueva
+        if (requestedChunk.load() != first)
+            return true;
+    }
+
+    return false;
+}
+
+NoteStore::Chunk NoteStore::readChunk (size_t chunkIndex) const
+{
+    if (!isPaged() || chunkIndex >= getNumChunks())
+        return {};
+
+    const auto start = chunkIndex * notesPerChunk;
+    const auto count = juce::jmin (notesPerChunk, numNotes - start);
+    auto notes = std::make_shared<std::vector<SongNote>> (count);
+    const auto numBytes = (int) (count * sizeof (SongNote));
+
+    const juce::ScopedLock sl (streamLock);
+
+    if (!pagedStream->setPosition (pagedOffset + (juce::int64) (start * sizeof (SongNote)))
+        || pagedStream->read (notes->data(), numBytes) != numBytes)
+    {
+        juce::Logger::writeToLog ("Error: No se pudo leer el bloque de notas " + juce::String ((int) chunkIndex));
+        return {};
+    }
+
+    return notes;
+}
+
+void NoteStore::storeChunk (size_t chunkIndex, Chunk chunk) const
+{
+    const juce::ScopedLock sl (lock);
+
+    if (chunks[chunkIndex] == nullptr)
+    {
+        chunks[chunkIndex] = std::move (chunk);
+        residentNotes[chunkIndex] = chunks[chunkIndex].get();
+    }
+
+    lastUsed[chunkIndex] = ++useCounter;
+
+    // Descartar los bloques usados hace más tiempo; quien tenga uno en uso conserva su copia
+    for (;;)
+    {
+        size_t numResident = 0;
+        auto oldest = chunks.size();
+
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            if (chunks[i] == nullptr)
+                continue;
+
+            ++numResident;
+
+            if (i != chunkIndex && (oldest == chunks.size() || lastUsed[i] < lastUsed[oldest]))
+                oldest = i;
+        }
+
+        if (numResident <= maximumResidentChunks || oldest == chunks.size())
+            return;
+
+        // Si el hilo de audio lo tiene fijado se deja como estaba (la memoria supera el límite
+        // un momento; el siguiente bloque que se guarde vuelve a intentarlo)
+        residentNotes[oldest] = nullptr;
+
+        if (audioPins[oldest].load() > 0)
+        {
+            residentNotes[oldest] = chunks[oldest].get();
+            return;
+        }
+
+        chunks[oldest] = nullptr;
+    }
+}
+
+size_t NoteStore::getChunkForTime (double seconds) const
+{
+    // Primer bloque cuya primera nota tiene time >= seconds
+    return (size_t) std::distance (chunkStartTimes.begin(),
+                                   std::lower_bound (chunkStartTimes.begin(), chunkStartTimes.end(), seconds));
+}
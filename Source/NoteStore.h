@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    NoteStore.h
+    Notas de una canción en bloques ordenados por tiempo, residentes o paginados.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SongNote.h"
+
+//==============================================================================
+/**
+    Guarda las notas ordenadas por tiempo en bloques de tamaño fijo, con un
+    índice residente del tiempo de la primera nota de cada bloque.
+
+    En canciones normales todos los bloques están en memoria. En archivos muy
+    largos (millones de notas) la canción abierta desde la caché en disco queda
+    paginada: solo se mantienen unos pocos bloques alrededor de la reproducción
+    y el resto se lee del archivo de caché cuando hace falta. Un hilo compartido
+    precarga los bloques que siguen a la posición pedida con prefetch(), así que
+    la memoria no crece con la duración del archivo.
+
+    El hilo de audio no usa getChunk() (lock, lectura del disco y reservas):
+    recorre las notas con visitResident(), que solo ve los bloques residentes.
+    Cada bloque lleva una copia atómica de su puntero y un contador de lectores
+    de audio; un bloque fijado por el audio no se descarta hasta que lo suelta.
+*/
+class NoteStore
+{
+public:
+    using Chunk = std::shared_ptr<const std::vector<SongNote>>;
+
+    // Bloque residente fijado para el hilo de audio; mientras exista no se descarta.
+    // Vacío si el bloque estaba en disco.
+    class ResidentChunk
+    {
+    public:
+        ResidentChunk() = default;
+        ResidentChunk (ResidentChunk&& other) noexcept;
+        ~ResidentChunk();
+
+        const std::vector<SongNote>* get() const        { return notes; }
+        const std::vector<SongNote>* operator->() const { return notes; }
+        const std::vector<SongNote>& operator*() const  { return *notes; }
+        explicit operator bool() const                  { return notes != nullptr; }
+
+    private:
+        friend class NoteStore;
+
+        std::atomic<int>* pin = nullptr;
+        const std::vector<SongNote>* notes = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE (ResidentChunk)
+    };
+
+    NoteStore();
+    ~NoteStore();
+
+    // Todas las notas en memoria (ya ordenadas por tiempo)
+    void setNotes (std::vector<SongNote> newNotes);
+
+    // Notas leídas bajo demanda: `count` SongNote consecutivas desde `offset` en el archivo.
+    // `mappedNotes` apunta a esas mismas notas ya mapeadas (sin alinear) y solo se usa para crear el índice.
+    bool openPaged (const juce::File& file, juce::int64 offset, size_t count, const void* mappedNotes);
+
+    size_t size() const             { return numNotes; }
+    bool empty() const              { return numNotes == 0; }
+    bool isPaged() const            { return pagedStream != nullptr; }
+
+    size_t getNumChunks() const     { return chunkStartTimes.size(); }
+
+    // Bloque completo (lo lee del archivo si está paginado y no residente). nullptr si falla la lectura.
+    Chunk getChunk (size_t chunkIndex) const;
+
+    // Bloque para el hilo de audio: sin locks, sin leer del disco y sin reservas
+    ResidentChunk tryGetResidentChunk (size_t chunkIndex) const;
+
+    // Índice de la primera nota con time >= seconds (búsqueda binaria sobre el índice y un bloque)
+    size_t findFirstAtOrAfter (double seconds) const;
+
+    // Como findFirstAtOrAfter para el hilo de audio; false si el bloque no está residente
+    bool findFirstResidentAtOrAfter (double seconds, size_t& index) const;
+
+    // Recorre las notas desde firstIndex, bloque a bloque, mientras callback devuelva true
+    template <typename Callback>
+    void visit (size_t firstIndex, Callback&& callback) const
+    {
+        for (auto chunkIndex = firstIndex / notesPerChunk; chunkIndex < getNumChunks(); ++chunkIndex)
+        {
+            const auto chunk = getChunk (chunkIndex);
+            if (chunk == nullptr)
+                return;
+
+            const auto start = chunkIndex == firstIndex / notesPerChunk ? firstIndex % notesPerChunk : 0;
+
+            for (auto i = start; i < chunk->size(); ++i)
+                if (!callback ((*chunk)[i]))
+                    return;
+        }
+    }
+
+    // Como visit, para el hilo de audio: se detiene y devuelve false al llegar a un bloque
+    // que no está residente (quien llama lo cuenta como corte; nunca espera al disco)
+    template <typename Callback>
+    bool visitResident (size_t firstIndex, Callback&& callback) const
+    {
+        for (auto chunkIndex = firstIndex / notesPerChunk; chunkIndex < getNumChunks(); ++chunkIndex)
+        {
+            const auto chunk = tryGetResidentChunk (chunkIndex);
+            if (!chunk)
+                return false;
+
+            const auto start = chunkIndex == firstIndex / notesPerChunk ? firstIndex % notesPerChunk : 0;
+
+            for (auto i = start; i < chunk->size(); ++i)
+                if (!callback ((*chunk)[i]))
+                    return true;
+        }
+
+        return true;
+    }
+
+    // Programa la lectura en segundo plano del bloque de ese tiempo y los siguientes.
+    // Se puede llamar desde el hilo de audio: solo publica el bloque y despierta al hilo.
+    void prefetch (double seconds) const;
+
+    // Memoria de los bloques residentes y del índice
+    size_t getMemoryBytes() const;
+
+    static constexpr size_t notesPerChunk = 16384;          // 256 KB por bloque
+    static constexpr size_t pagingThreshold = 1 << 20;      // Canciones con más notas se paginan
+    static constexpr size_t maximumResidentChunks = 8;      // Bloques paginados en memoria a la vez
+    static constexpr size_t prefetchChunks = 2;             // Bloques por delante de la posición pedida
+
+private:
+    struct PagingThread;
+
+    // Turno del hilo de lectura: true si la posición pedida cambió mientras leía
+    bool readAhead();
+    void initialiseAudioAccess();
+
+    Chunk readChunk (size_t chunkIndex) const;
+    void storeChunk (size_t chunkIndex, Chunk chunk) const;
+    size_t getChunkForTime (double seconds) const;
+
+    size_t numNotes = 0;
+    std::vector<double> chunkStartTimes;    // Tiempo de la primera nota de cada bloque
+
+    // Bloques residentes (nulos los que están en disco) y su último uso
+    mutable std::vector<Chunk> chunks;
+    mutable std::vector<juce::uint32> lastUsed;
+    mutable juce::uint32 useCounter = 0;
+    mutable juce::CriticalSection lock;
+
+    // Para el hilo de audio: copia de los punteros de chunks (se escribe bajo lock) y
+    // cuántos lectores de audio tiene fijado cada bloque
+    std::unique_ptr<std::atomic<const std::vector<SongNote>*>[]> residentNotes;
+    std::unique_ptr<std::atomic<int>[]> audioPins;
+
+    // Solo en modo paginado. El archivo se mantiene abierto para que una caché reescrita
+    // no cambie los datos de una canción que ya está en uso.
+    std::unique_ptr<juce::FileInputStream> pagedStream;
+    juce::int64 pagedOffset = 0;
+    mutable juce::CriticalSection streamLock;
+    mutable std::atomic<size_t> requestedChunk { 0 };
+    std::unique_ptr<juce::SharedResourcePointer<PagingThread>> pagingThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteStore)
+};
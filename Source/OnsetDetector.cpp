@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    OnsetDetector.cpp
+    Detección de golpes de batería acústica en la entrada de audio.
+
+  ==============================================================================
+*/
+
+#include "OnsetDetector.h"
+
+//==============================================================================
+OnsetDetector::OnsetDetector()
+{
+    frame.setSize (numBands + 1, frameSize);
+    prepare (44100.0);
+}
+
+void OnsetDetector::prepare (double sampleRate)
+{
+    // Pasobandas de una octava (Q = 1.41); las bandas por encima de Nyquist se quedan en silencio
+    for (int band = 0; band < numBands; ++band)
+    {
+        const double centre = juce::jmin (lowestBandHz * std::pow (2.0, band), sampleRate * 0.45);
+        const auto coefficients = juce::IIRCoefficients::makeBandPass (sampleRate, centre, 1.41);
+
+        for (auto& filter : filters[(size_t) band])
+            filter.setCoefficients (coefficients);
+    }
+
+    refractoryFrames = juce::jmax (1, juce::roundToInt (refractorySeconds * sampleRate / frameSize));
+    reset();
+}
+
+void OnsetDetector::reset()
+{
+    for (auto& band : filters)
+        for (auto& filter : band)
+            filter.reset();
+
+    previousDb = -100.0f;
+    averageDb = -100.0f;
+    framesSinceOnset = refractoryFrames;
+    framePosition = 0;
+    numOnsets = 0;
+}
+
+//==============================================================================
+int OnsetDetector::process (const juce::AudioBuffer<float>& input, int numChannels, int numSamples)
+{
+    numOnsets = 0;
+    numChannels = juce::jmin (numChannels, input.getNumChannels());
+
+    if (numChannels <= 0)
+        return 0;
+
+    const float gain = 1.0f / (float) numChannels;
+    int consumed = 0;
+
+    // Las tramas son de tamaño fijo: se completan con lo que traiga cada bloque
+    while (consumed < numSamples)
+    {
+        const int count = juce::jmin (frameSize - framePosition, numSamples - consumed);
+        auto* mix = frame.getWritePointer (numBands, framePosition);
+
+        juce::FloatVectorOperations::copyWithMultiply (mix, input.getReadPointer (0, consumed), gain, count);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply (mix, input.getReadPointer (channel, consumed), gain, count);
+
+        framePosition += count;
+        consumed += count;
+
+        if (framePosition == frameSize)
+        {
+            analyseFrame (consumed - frameSize);
+            framePosition = 0;
+        }
+    }
+
+    return numOnsets;
+}
+
+void OnsetDetector::analyseFrame (int frameStart)
+{
+    constexpr float averageSmoothing = 0.1f;   // Media de unas diez tramas
+    const auto* mix = frame.getReadPointer (numBands);
+
+    // Los filtros se aplican en todas las tramas para que su estado siga a la señal
+    Features bandDb;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto* samples = frame.getWritePointer (band);
+        juce::FloatVectorOperations::copy (samples, mix, frameSize);
+
+        for (auto& filter : filters[(size_t) band])
+            filter.process (samples, frameSize);
+
+        bandDb[(size_t) band] = juce::Decibels::gainToDecibels (frame.getRMSLevel (band, 0, frameSize), -100.0f);
+    }
+
+    const float levelDb = juce::Decibels::gainToDecibels (frame.getRMSLevel (numBands, 0, frameSize), -100.0f);
+
+    const bool isOnset = levelDb > silenceDb
+                      && levelDb - previousDb >= riseDb
+                      && levelDb - averageDb >= riseDb
+                      && framesSinceOnset >= refractoryFrames;
+
+    if (isOnset && numOnsets < maximumOnsets)
+    {
+        // Afinar dentro de la trama: primera muestra por encima de la mitad del pico
+        const auto range = juce::FloatVectorOperations::findMinAndMax (mix, frameSize);
+        const float halfPeak = 0.5f * juce::jmax (-range.getStart(), range.getEnd());
+        int attack = 0;
+
+        while (attack < frameSize - 1 && std::abs (mix[attack]) < halfPeak)
+            ++attack;
+
+        auto& onset = onsets[(size_t) numOnsets++];
+        onset.offset = frameStart + attack;
+        onset.strength = juce::jlimit (0.0f, 1.0f, (levelDb - silenceDb) / -silenceDb);
+
+        // Forma del espectro independiente del volumen del golpe
+        const float loudestDb = *std::max_element (bandDb.begin(), bandDb.end());
+
+        for (int band = 0; band < numBands; ++band)
+            onset.features[(size_t) band] = juce::jmax (featureFloorDb, bandDb[(size_t) band] - loudestDb);
+    }
+
+    framesSinceOnset = isOnset ? 0 : juce::jmin (framesSinceOnset + 1, refractoryFrames);
+    previousDb = levelDb;
+    averageDb += (levelDb - averageDb) * averageSmoothing;
+}
+
+//==============================================================================
+void OnsetDetector::Biquad::setCoefficients (const juce::IIRCoefficients& newCoefficients)
+{
+    std::copy (std::begin (newCoefficients.coefficients), std::end (newCoefficients.coefficients), coefficients.begin());
+}
+
+void OnsetDetector::Biquad::process (float* samples, int numSamples)
+{
+    // Forma directa II transpuesta, como juce::IIRFilter
+    const auto [b0, b1, b2, a1, a2] = coefficients;
+    auto s1 = v1, s2 = v2;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float in = samples[i];
+        const float out = b0 * in + s1;
+        s1 = b1 * in - a1 * out + s2;
+        s2 = b2 * in - a2 * out;
+        samples[i] = out;
+    }
+
+    v1 = s1;
+    v2 = s2;
+}
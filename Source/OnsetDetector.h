@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    OnsetDetector.h
+    Detección de golpes de batería acústica en la entrada de audio.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Detector de ataques para los micrófonos de ambiente o overheads de una
+    batería acústica. La entrada se mezcla a mono y se analiza en tramas fijas
+    de frameSize muestras (aunque crucen bloques del host). Hay golpe cuando
+    la energía de la trama sube de golpe respecto a la trama anterior y a su
+    media reciente, con un tiempo muerto para no contar dos veces el mismo
+    golpe.
+
+    Cada trama pasa además por un banco de numBands filtros de octava (de 60 Hz
+    a 7.7 kHz). Las energías de las bandas en la trama del golpe, en dB
+    respecto a la banda más fuerte, son las features con las que
+    HitClassifier decide qué pieza de la batería sonó.
+
+    La posición del golpe se afina dentro de la trama con la primera muestra
+    que supera la mitad del pico. El coste por bloque es fijo (filtros y sumas
+    sobre las muestras del bloque) y process() no reserva memoria ni bloquea.
+*/
+class OnsetDetector
+{
+public:
+    static constexpr int numBands = 8;
+    using Features = std::array<float, numBands>;
+
+    struct Onset
+    {
+        int offset = 0;             // Muestra del bloque (negativa si la trama empezó en el bloque anterior)
+        float strength = 0.0f;      // 0..1 según el nivel de la trama
+        Features features {};       // dB de cada banda respecto a la más fuerte (<= 0)
+    };
+
+    OnsetDetector();
+
+    // Banco de filtros para la frecuencia del host (fuera del hilo de audio)
+    void prepare (double sampleRate);
+
+    // Olvida la trama a medias y el historial de energía (al buscar)
+    void reset();
+
+    // Analiza numSamples muestras de los numChannels primeros canales; devuelve los golpes del bloque
+    int process (const juce::AudioBuffer<float>& input, int numChannels, int numSamples);
+    const Onset& getOnset (int index) const     { return onsets[(size_t) index]; }
+
+    static constexpr int frameSize = 256;
+    static constexpr int maximumOnsets = 64;            // Por bloque; los que sobren se descartan
+    static constexpr float silenceDb = -50.0f;          // Por debajo no se buscan golpes
+    static constexpr float riseDb = 6.0f;               // Subida mínima sobre la trama anterior y la media
+    static constexpr float featureFloorDb = -60.0f;
+    static constexpr double refractorySeconds = 0.05;
+    static constexpr double lowestBandHz = 60.0;        // Centro de la primera banda; cada una, una octava más
+
+private:
+    // Biquad sin locks: juce::IIRFilter toma un SpinLock en cada processSamples
+    struct Biquad
+    {
+        void setCoefficients (const juce::IIRCoefficients& newCoefficients);
+        void reset()                        { v1 = v2 = 0.0f; }
+        void process (float* samples, int numSamples);
+
+        std::array<float, 5> coefficients {};   // b0, b1, b2, a1, a2 (a0 = 1)
+        float v1 = 0.0f, v2 = 0.0f;
+    };
+
+    void analyseFrame (int frameStart);
+
+    std::array<std::array<Biquad, 2>, numBands> filters;    // Dos por banda, en cascada
+    juce::AudioBuffer<float> frame;         // Canal numBands: mezcla mono; el resto, una banda cada uno
+    int framePosition = 0;
+
+    float previousDb = -100.0f;
+    float averageDb = -100.0f;
+    int framesSinceOnset = 0;
+    int refractoryFrames = 1;
+
+    std::array<Onset, maximumOnsets> onsets;
+    int numOnsets = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OnsetDetector)
+};
@@ -0,0 +1,760 @@
+/*
+  ==============================================================================
+
+    PianoRollRenderer.cpp
+    Dibujo del piano roll estilo Synthesia como función pura del tiempo.
+
+  ==============================================================================
+*/
+
+#include "PianoRollRenderer.h"
+
+//==============================================================================
+PianoRollRenderer::PianoRollRenderer (const DrumVisualizerAudioProcessor& processor)
+    : audioProcessor (processor)
+{
+}
+
+double PianoRollRenderer::getScrollSpeed (int bpm, float speed)
+{
+    // La velocidad base se basa en el BPM
+    // A 120 BPM, queremos una velocidad de scroll de 1.0 (tiempo real)
+    // El speed multiplica esta velocidad base
+    double baseBeatRate = bpm / 120.0; // Normalizar contra 120 BPM
+    return baseBeatRate * speed;
+}
+
+//==============================================================================
+void PianoRollRenderer::render (juce::Graphics& g, const juce::Rectangle<int>& area, const ViewState& state) const
+{
+    auto song = audioProcessor.getPreparedSong();
+    if (song == nullptr)
+        return;
+
+    // Obtener el rango de notas del MIDI
+    int lowestNote = song->getSummary().lowestNote;
+    int highestNote = song->getSummary().highestNote;
+
+    // Asegurar un rango mínimo visible
+    if (highestNote - lowestNote < 24) // Menos de 2 octavas
+    {
+        int center = (lowestNote + highestNote) / 2;
+        lowestNote = center - 12;
+        highestNote = center + 12;
+    }
+
+    // Clamp to MIDI range
+    lowestNote = std::max(0, lowestNote - 2);
+    highestNote = std::min(127, highestNote + 2);
+
+    // Dividir el área: teclas del piano a la izquierda, notas a la derecha
+    const int keyWidth = 80;
+    auto workingArea = area; // Copia mutable del área
+
+    // Carril opcional de la forma de onda de la entrada, debajo de todo
+    juce::Rectangle<int> waveformArea;
+    if (state.inputWaveform != nullptr)
+        waveformArea = workingArea.removeFromBottom(inputWaveformHeight);
+
+    // Encima, un carril por cada controlador elegido en el filtro que aparezca en la canción
+    std::array<const ControllerLanes::Lane*, maximumControllerLanes> controllerLanes {};
+    std::array<juce::Rectangle<int>, maximumControllerLanes> controllerLaneAreas;
+    int numControllerLanes = 0;
+
+    for (const auto& lane : song->getControllers().getLanes())
+    {
+        if (numControllerLanes == maximumControllerLanes)
+            break;
+
+        if (state.filter.isControllerVisible(lane.getController()))
+        {
+            controllerLanes[(size_t)numControllerLanes] = &lane;
+            controllerLaneAreas[(size_t)numControllerLanes] = workingArea.removeFromBottom(controllerLaneHeight);
+            ++numControllerLanes;
+        }
+    }
+
+    auto keyArea = workingArea.removeFromLeft(keyWidth);
+    auto noteArea = workingArea;
+
+    // Calcular posición de la línea objetivo
+    const Frame frame { state, *song, keyArea.getRight() + static_cast<int>(noteArea.getWidth() * 0.25f), song };
+
+    // Dibujar las teclas del piano (desde la imagen en caché)
+    drawCachedPianoKeys(g, keyArea, lowestNote, highestNote);
+
+    // Dibujar fondo del área de notas
+    g.setColour(juce::Colour(0xff1a1a1a));
+    g.fillRect(noteArea);
+
+    // Dibujar escala de tiempo
+    drawTimeScale(g, frame, noteArea);
+
+    // Dibujar las notas MIDI animadas
+    drawAnimatedMidiNotes(g, frame, noteArea, lowestNote, highestNote);
+
+    // Golpes tocados en la batería acústica (detectados en la entrada de audio)
+    drawInputHits(g, frame, noteArea, lowestNote, highestNote);
+
+    // Dibujar línea objetivo (donde "caen" las notas)
+    drawTargetLine(g, frame, noteArea);
+
+    for (int i = 0; i < numControllerLanes; ++i)
+    {
+        auto laneArea = controllerLaneAreas[(size_t)i];
+        const auto labelArea = laneArea.removeFromLeft(keyWidth);
+        drawControllerLane(g, frame, *controllerLanes[(size_t)i], labelArea, laneArea, i);
+        drawTargetLine(g, frame, laneArea);
+    }
+
+    if (!waveformArea.isEmpty())
+    {
+        // Misma escala de tiempo que las notas: el carril tiene el ancho del área de notas
+        auto labelArea = waveformArea.removeFromLeft(keyWidth);
+        drawCachedLabel(g, inputWaveformLabelCache, labelArea, 0, drawInputWaveformLabel);
+
+        drawInputWaveform(g, frame, waveformArea);
+        drawTargetLine(g, frame, waveformArea);
+    }
+}
+
+void PianoRollRenderer::drawCachedLabel(juce::Graphics& g, LabelCache& cache, const juce::Rectangle<int>& area, int key, LabelDrawer drawLabel) const
+{
+    // Como el teclado: la fuente y el texto solo se construyen al regenerar la imagen
+    const juce::SpinLock::ScopedTryLockType lock(labelCacheLock);
+    if (!lock.isLocked())
+    {
+        drawLabel(g, area, key);
+        return;
+    }
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (cache.image.isNull() || cache.area != area || cache.key != key || cache.scale != scale)
+    {
+        cache.image = juce::Image(juce::Image::ARGB,
+                                  std::max(1, juce::roundToInt((float)area.getWidth() * scale)),
+                                  std::max(1, juce::roundToInt((float)area.getHeight() * scale)),
+                                  true);
+
+        juce::Graphics imageGraphics(cache.image);
+        imageGraphics.addTransform(juce::AffineTransform::scale(scale));
+        drawLabel(imageGraphics, area.withZeroOrigin(), key);
+
+        cache.area = area;
+        cache.key = key;
+        cache.scale = scale;
+    }
+
+    g.drawImage(cache.image, area.toFloat());
+}
+
+void PianoRollRenderer::drawInputWaveformLabel(juce::Graphics& g, const juce::Rectangle<int>& area, int)
+{
+    g.setColour(juce::Colour(0xff2a2a2a));
+    g.fillRect(area);
+    g.setColour(juce::Colours::lightgrey);
+    g.setFont(juce::Font(juce::FontOptions(12.0f)));
+    g.drawText("Entrada", area, juce::Justification::centred);
+}
+
+void PianoRollRenderer::drawControllerLabel(juce::Graphics& g, const juce::Rectangle<int>& area, int controller)
+{
+    const auto* name = juce::MidiMessage::getControllerName(controller);
+
+    g.setColour(juce::Colour(0xff2a2a2a));
+    g.fillRect(area);
+    g.setColour(juce::Colours::lightgrey);
+    g.setFont(juce::Font(juce::FontOptions(11.0f)));
+    g.drawFittedText("CC" + juce::String(controller) + (name != nullptr ? "\n" + juce::String(name) : juce::String()),
+                     area.reduced(4, 2), juce::Justification::centred, 2);
+}
+
+void PianoRollRenderer::drawCachedPianoKeys(juce::Graphics& g, const juce::Rectangle<int>& keyArea, int lowestNote, int highestNote) const
+{
+    // Los nombres de nota y las fuentes solo se construyen al regenerar la imagen,
+    // no en cada frame; si otro hilo tiene la caché, dibujar directamente
+    const juce::SpinLock::ScopedTryLockType lock(keyboardCacheLock);
+    if (!lock.isLocked())
+    {
+        drawPianoKeys(g, keyArea, lowestNote, highestNote);
+        return;
+    }
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    auto& cache = keyboardCache;
+
+    if (cache.image.isNull() || cache.area != keyArea || cache.lowestNote != lowestNote
+        || cache.highestNote != highestNote || cache.scale != scale)
+    {
+        cache.image = juce::Image(juce::Image::ARGB,
+                                  std::max(1, juce::roundToInt((float)keyArea.getWidth() * scale)),
+                                  std::max(1, juce::roundToInt((float)keyArea.getHeight() * scale)),
+                                  true);
+
+        juce::Graphics imageGraphics(cache.image);
+        imageGraphics.addTransform(juce::AffineTransform::scale(scale));
+        drawPianoKeys(imageGraphics, keyArea.withZeroOrigin(), lowestNote, highestNote);
+
+        cache.area = keyArea;
+        cache.lowestNote = lowestNote;
+        cache.highestNote = highestNote;
+        cache.scale = scale;
+    }
+
+    g.drawImage(cache.image, keyArea.toFloat());
+}
+
+void PianoRollRenderer::drawPianoKeys(juce::Graphics& g, const juce::Rectangle<int>& keyArea, int lowestNote, int highestNote) const
+{
+    const int numNotes = highestNote - lowestNote + 1;
+    const float keyHeight = (float)keyArea.getHeight() / (float)numNotes;
+
+    for (int i = 0; i < numNotes; ++i)
+    {
+        int noteNumber = highestNote - i; // Dibujar desde arriba hacia abajo
+        float y = (float)keyArea.getY() + (float)i * keyHeight;
+        juce::Rectangle<float> keyRect((float)keyArea.getX(), y, (float)keyArea.getWidth(), keyHeight);
+
+        // Determinar si es tecla blanca o negra
+        int noteInOctave = noteNumber % 12;
+        bool isBlackKey = (noteInOctave == 1 || noteInOctave == 3 || noteInOctave == 6 ||
+                          noteInOctave == 8 || noteInOctave == 10);
+
+        // Color de la tecla
+        if (isBlackKey)
+        {
+            g.setColour(juce::Colour(0xff1a1a1a));
+        }
+        else
+        {
+            g.setColour(juce::Colours::white);
+        }
+
+        g.fillRect(keyRect);
+
+        // Borde de la tecla
+        g.setColour(juce::Colours::grey);
+        g.drawRect(keyRect, 1.0f);
+
+        // Dibujar nombre de la nota para teclas blancas o notas C
+        if (!isBlackKey || noteInOctave == 0)
+        {
+            g.setColour(isBlackKey ? juce::Colours::white : juce::Colours::black);
+            g.setFont(juce::Font(juce::FontOptions(10.0f)));
+            g.drawText(getNoteNameFromNumber(noteNumber),
+                      keyRect.reduced(2),
+                      juce::Justification::centredLeft,
+                      true);
+        }
+    }
+}
+
+void PianoRollRenderer::drawAnimatedMidiNotes(juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote) const
+{
+    const double currentTime = frame.state.currentTime;
+    const int targetLineX = frame.targetLineX;
+
+    // Ampliar significativamente la ventana de tiempo visible
+    double windowStart = currentTime - 1.0; // Mostrar notas 1s antes del tiempo actual
+    double windowEnd = currentTime + 12.0; // Ventana de scroll mucho más amplia (12 segundos adelante)
+
+    // Si no estamos reproduciendo, mostrar solo las notas a partir de currentTime (no mostrar notas a la izquierda de la línea de reproducción)
+    if (!frame.state.isPlaying)
+    {
+        // Evitar mostrar notas anteriores a la posición actual: en pausa la vista se congela en currentTime
+        windowStart = currentTime;
+        // Mostrar al menos 12 segundos hacia delante o hasta el final del clip
+        double remainingLength = std::max(12.0, std::max(0.0, frame.song.getSummary().lengthSeconds - currentTime));
+        windowEnd = currentTime + remainingLength;
+    }
+
+    // Si varias notas caen en la misma columna de píxeles, dibujar la densidad agregada
+    const double secondsPerPixel = (windowEnd - currentTime) / std::max(1, noteArea.getWidth());
+    if (secondsPerPixel >= frame.song.getDensity().getBucketSeconds(0))
+    {
+        drawAggregatedNotes(g, frame, noteArea, lowestNote, highestNote, windowStart, windowEnd);
+        return;
+    }
+
+    // Las notas están ordenadas por tiempo: recorrer solo las de la ventana visible
+    // (bloque a bloque, así una canción paginada solo lee los bloques que se ven)
+    frame.song.getNotes().visit(frame.song.findFirstNoteAtOrAfter(windowStart), [&](const SongNote& note)
+    {
+        if (note.time > windowEnd)
+            return false;
+
+        // Filtro de pistas/canales/notas: solo unas consultas de bits por nota
+        if (!frame.state.filter.isVisible(note))
+            return true;
+
+        int noteNumber = note.noteNumber;
+        double noteTime = note.time;
+
+        if (noteNumber >= lowestNote && noteNumber <= highestNote)
+        {
+            float velocity = (float)note.velocity / 127.0f;
+
+            // Calcular posición X animada
+            float x = (float)timeToAnimatedX(frame, noteTime, noteArea, windowEnd - currentTime);
+            float y = (float)noteToY(noteNumber, lowestNote, highestNote, noteArea);
+
+            // Asegurar que no se muestre ninguna nota a la izquierda de la línea objetivo
+            if (x < targetLineX)
+                return true;
+
+            // Las siguientes notas quedan aún más a la derecha: no seguir leyendo
+            if (x > noteArea.getRight() + 25)
+                return false;
+
+            // Solo dibujar si la nota está dentro del área visible
+            if (x >= noteArea.getX() - 25)
+            {
+                // Tamaño de la nota
+                float noteWidth = 20.0f; // Más ancho para mejor visibilidad
+                float height = (float)noteArea.getHeight() / (float)(highestNote - lowestNote + 1) * 0.8f;
+
+                // Color basado en la velocidad con efecto de brillo
+                juce::Colour baseColor = juce::Colour::fromHSV(0.6f, 0.9f, 0.4f + velocity * 0.6f, 1.0f);
+
+                // Efecto de resplandor para notas que están cerca de la línea objetivo
+                float distanceToTarget = std::abs(x - targetLineX);
+                float maxGlowDistance = 50.0f;
+                if (distanceToTarget < maxGlowDistance)
+                {
+                    float glowIntensity = 1.0f - (distanceToTarget / maxGlowDistance);
+                    baseColor = baseColor.brighter(glowIntensity * 0.3f);
+                }
+
+                // Dibujar nota con efecto de resplandor
+                g.setColour(baseColor.withAlpha(0.3f));
+                g.fillRoundedRectangle(x - 2, y - 2, noteWidth + 4, height + 4, 4.0f);
+
+                g.setColour(baseColor);
+                g.fillRoundedRectangle(x, y, noteWidth, height, 3.0f);
+
+                // Borde brillante
+                g.setColour(baseColor.brighter(0.4f));
+                g.drawRoundedRectangle(x, y, noteWidth, height, 3.0f, 2.0f);
+            }
+        }
+
+        return true;
+    });
+}
+
+void PianoRollRenderer::drawAggregatedNotes(juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote,
+                                            double windowStart, double windowEnd) const
+{
+    const auto& density = frame.song.getDensity();
+    const double windowWidth = windowEnd - frame.state.currentTime;
+
+    // Nivel de la pirámide con como mucho un intervalo por columna de píxeles
+    const int level = density.getLevelForResolution(windowWidth / std::max(1, noteArea.getWidth()));
+    const double bucketSeconds = density.getBucketSeconds(level);
+    const int firstBucket = std::max(0, (int)(windowStart / bucketSeconds));
+    const int lastBucket = std::min(density.getNumBuckets(level) - 1, (int)(windowEnd / bucketSeconds));
+    const float height = (float)noteArea.getHeight() / (float)(highestNote - lowestNote + 1) * 0.8f;
+
+    const auto& filter = frame.state.filter;
+
+    for (int noteNumber = lowestNote; noteNumber <= highestNote; ++noteNumber)
+    {
+        if (!density.hasLane(noteNumber) || !filter.isNoteVisible(noteNumber))
+            continue;
+
+        // Un carril por pista y canal: con pistas o canales ocultos solo se suman los visibles
+        const int firstLane = density.getFirstLane(noteNumber);
+        const int endLane = density.getFirstLane(noteNumber + 1);
+        int numVisibleLanes = 0;
+
+        for (int lane = firstLane; lane < endLane; ++lane)
+        {
+            const auto& key = density.getLane(lane);
+            if (filter.isVisible(key.track, key.channel, key.noteNumber))
+                ++numVisibleLanes;
+        }
+
+        if (numVisibleLanes == 0)
+            continue;
+
+        const float y = (float)noteToY(noteNumber, lowestNote, highestNote, noteArea);
+
+        for (int bucket = firstBucket; bucket <= lastBucket; ++bucket)
+        {
+            DensityPyramid::Bucket cell;
+
+            if (numVisibleLanes == endLane - firstLane)
+            {
+                cell = density.getBucket(level, noteNumber, bucket);
+            }
+            else
+            {
+                for (int lane = firstLane; lane < endLane; ++lane)
+                {
+                    const auto& key = density.getLane(lane);
+                    if (!filter.isVisible(key.track, key.channel, key.noteNumber))
+                        continue;
+
+                    const auto laneCell = density.getLaneBucket(level, lane, bucket);
+                    cell.count += laneCell.count;
+                    cell.maxVelocity = std::max(cell.maxVelocity, laneCell.maxVelocity);
+                }
+            }
+
+            if (cell.count == 0)
+                continue;
+
+            float x = (float)timeToAnimatedX(frame, bucket * bucketSeconds, noteArea, windowWidth);
+            const float right = (float)timeToAnimatedX(frame, (bucket + 1) * bucketSeconds, noteArea, windowWidth);
+
+            // Recortar en la línea objetivo como con las notas individuales
+            x = std::max(x, (float)frame.targetLineX);
+            if (right <= x || x > noteArea.getRight())
+                continue;
+
+            // Brillo por velocidad máxima y opacidad por número de golpes en el intervalo
+            const float velocity = (float)cell.maxVelocity / 127.0f;
+            const float opacity = juce::jlimit(0.35f, 1.0f, 0.35f + 0.1f * (float)cell.count);
+            g.setColour(juce::Colour::fromHSV(0.6f, 0.9f, 0.4f + velocity * 0.6f, opacity));
+            g.fillRect(x, y, std::max(1.0f, right - x), height);
+        }
+    }
+}
+
+void PianoRollRenderer::drawInputHits(juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote) const
+{
+    if (!frame.state.isPlaying || frame.state.inputHits == nullptr)
+        return;
+
+    const float height = (float)noteArea.getHeight() / (float)(highestNote - lowestNote + 1) * 0.8f;
+
+    for (const auto& hit : *frame.state.inputHits)
+    {
+        if (hit.noteNumber < lowestNote || hit.noteNumber > highestNote)
+            continue;
+
+        // Ya sonaron: quedan a la izquierda de la línea objetivo, a la distancia de su tiempo
+        float x = (float)timeToAnimatedX(frame, hit.time, noteArea, noteScrollWidth);
+        float y = (float)noteToY(hit.noteNumber, lowestNote, highestNote, noteArea);
+
+        if (x < noteArea.getX())
+            continue;
+
+        // Verde si coincide con una nota del mismo carril en la partitura, naranja si no
+        const float alpha = 0.4f + hit.strength * 0.6f;
+
+        if (hit.matched)
+        {
+            g.setColour(juce::Colour::fromHSV(0.33f, 0.8f, 1.0f, alpha));
+            g.fillRoundedRectangle(x - 6.0f, y, 12.0f, height, 3.0f);
+        }
+        else
+        {
+            g.setColour(juce::Colour::fromHSV(0.08f, 0.9f, 1.0f, alpha));
+            g.drawRoundedRectangle(x - 6.0f, y, 12.0f, height, 3.0f, 2.0f);
+        }
+    }
+}
+
+void PianoRollRenderer::drawControllerLane(juce::Graphics& g, const Frame& frame, const ControllerLanes::Lane& lane,
+                                           const juce::Rectangle<int>& labelArea, const juce::Rectangle<int>& laneArea, int laneIndex) const
+{
+    // Etiqueta en la columna del teclado (imagen por controlador, no texto en cada frame)
+    if (juce::isPositiveAndBelow(laneIndex, maximumControllerLanes))
+        drawCachedLabel(g, controllerLabelCaches[(size_t)laneIndex], labelArea, lane.getController(), drawControllerLabel);
+    else
+        drawControllerLabel(g, labelArea, lane.getController());
+
+    g.setColour(juce::Colour(0xff161616));
+    g.fillRect(laneArea);
+    g.setColour(juce::Colours::white.withAlpha(0.1f));
+    g.drawHorizontalLine(laneArea.getY(), (float)laneArea.getX(), (float)laneArea.getRight());
+
+    // Misma escala de tiempo que las notas
+    const double secondsPerPixel = getWindowWidth(frame) / std::max(1, laneArea.getWidth());
+    const double leftSeconds = frame.state.currentTime + (laneArea.getX() - frame.targetLineX) * secondsPerPixel;
+
+    const auto firstColumn = (juce::int64)std::floor(leftSeconds / secondsPerPixel);
+    const int numColumns = laneArea.getWidth() + 1;
+
+    // Desplazamiento (menos de un píxel) entre la rejilla de columnas y el borde del carril
+    const auto transform = juce::AffineTransform::translation((float)(laneArea.getX() + (double)firstColumn - leftSeconds / secondsPerPixel),
+                                                              (float)laneArea.getY());
+
+    g.saveState();
+    g.reduceClipRegion(laneArea);
+    g.setColour(juce::Colour::fromHSV(0.12f, 0.7f, 1.0f, 0.9f));
+
+    const juce::SpinLock::ScopedTryLockType lock(controllerLaneCacheLock);
+
+    if (lock.isLocked() && juce::isPositiveAndBelow(laneIndex, maximumControllerLanes))
+    {
+        auto& cache = controllerLaneCaches[(size_t)laneIndex];
+
+        if (cache.song.lock() != frame.songHandle.lock()
+            || cache.controller != lane.getController()
+            || cache.secondsPerPixel != secondsPerPixel
+            || cache.firstColumn != firstColumn
+            || cache.numColumns != numColumns
+            || cache.height != laneArea.getHeight())
+        {
+            buildControllerPath(lane, firstColumn, numColumns, secondsPerPixel, (float)laneArea.getHeight(), cache.path);
+            cache.song = frame.songHandle;
+            cache.controller = lane.getController();
+            cache.secondsPerPixel = secondsPerPixel;
+            cache.firstColumn = firstColumn;
+            cache.numColumns = numColumns;
+            cache.height = laneArea.getHeight();
+        }
+
+        g.strokePath(cache.path, juce::PathStrokeType(1.5f), transform);
+    }
+    else
+    {
+        // Otro hilo (exportación) está usando la caché: trazo propio
+        juce::Path path;
+        buildControllerPath(lane, firstColumn, numColumns, secondsPerPixel, (float)laneArea.getHeight(), path);
+        g.strokePath(path, juce::PathStrokeType(1.5f), transform);
+    }
+
+    g.restoreState();
+}
+
+void PianoRollRenderer::buildControllerPath(const ControllerLanes::Lane& lane, juce::int64 firstColumn, int numColumns,
+                                            double secondsPerPixel, float height, juce::Path& path)
+{
+    path.clear();
+
+    const auto toY = [height](juce::uint8 value) { return height - 2.0f - (float)value / 127.0f * (height - 4.0f); };
+
+    // Cada columna con eventos aporta su mínimo, su máximo y el valor final; entre columnas
+    // el valor se mantiene, así que el coste depende de las columnas y no de los eventos
+    juce::uint8 held = 0;
+    bool hasValue = lane.getValueBefore((double)firstColumn * secondsPerPixel, held);
+
+    if (hasValue)
+        path.startNewSubPath(0.0f, toY(held));
+
+    size_t cursor = 0;
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const double start = (double)(firstColumn + column) * secondsPerPixel;
+        const auto summary = lane.getColumn(start, start + secondsPerPixel, cursor);
+
+        if (!summary.hasEvents)
+            continue;
+
+        const auto x = (float)column;
+
+        if (hasValue)
+            path.lineTo(x, toY(held));
+        else
+            path.startNewSubPath(x, toY(summary.minimum));
+
+        path.lineTo(x, toY(summary.minimum));
+        path.lineTo(x, toY(summary.maximum));
+        path.lineTo(x, toY(summary.last));
+
+        held = summary.last;
+        hasValue = true;
+    }
+
+    if (hasValue)
+        path.lineTo((float)numColumns, toY(held));
+}
+
+void PianoRollRenderer::drawInputWaveform(juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& laneArea) const
+{
+    g.setColour(juce::Colour(0xff121212));
+    g.fillRect(laneArea);
+
+    const float centreY = (float)laneArea.getCentreY();
+    const float halfHeight = (float)laneArea.getHeight() * 0.5f - 2.0f;
+
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    g.drawHorizontalLine(laneArea.getCentreY(), (float)laneArea.getX(), (float)laneArea.getRight());
+
+    // Una columna por píxel: el mipmap elige la resolución, así que el coste no depende de la duración.
+    // Misma escala de tiempo que las notas (en pausa, toda la canción).
+    const double secondsPerPixel = getWindowWidth(frame) / std::max(1, laneArea.getWidth());
+    const double startSeconds = frame.state.currentTime + (laneArea.getX() - frame.targetLineX) * secondsPerPixel;
+
+    g.setColour(juce::Colour::fromHSV(0.55f, 0.6f, 0.95f, 0.9f));
+
+    frame.state.inputWaveform->visitColumns(startSeconds, secondsPerPixel, laneArea.getWidth(), [&](int column, float minimum, float maximum)
+    {
+        const float top = centreY - juce::jlimit(-1.0f, 1.0f, maximum) * halfHeight;
+        const float bottom = centreY - juce::jlimit(-1.0f, 1.0f, minimum) * halfHeight;
+        g.drawVerticalLine(laneArea.getX() + column, top, juce::jmax(bottom, top + 1.0f));
+    });
+}
+
+double PianoRollRenderer::getWindowWidth(const Frame& frame) const
+{
+    return frame.state.isPlaying
+        ? noteScrollWidth
+        : std::max(noteScrollWidth, frame.song.getSummary().lengthSeconds - frame.state.currentTime);
+}
+
+void PianoRollRenderer::drawTargetLine(juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& area) const
+{
+    // Dibujar línea objetivo vertical brillante
+    int lineX = frame.targetLineX;
+
+    // Efecto de resplandor
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.fillRect(lineX - 3, area.getY(), 7, area.getHeight());
+
+    g.setColour(juce::Colours::white.withAlpha(0.6f));
+    g.fillRect(lineX - 2, area.getY(), 5, area.getHeight());
+
+    // Línea principal
+    g.setColour(juce::Colours::white);
+    g.fillRect(lineX - 1, area.getY(), 3, area.getHeight());
+}
+
+void PianoRollRenderer::drawTimeScale(juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& area) const
+{
+    // Misma escala que las notas y los carriles (en pausa, hasta el final de la canción); forma parte de la clave de la caché
+    const double windowWidth = getWindowWidth(frame);
+    const int division = BeatGrid::getDivisionForTimeFigure(frame.state.timeFigure);
+
+    // Reutilizar las líneas de la vista anterior si nada ha cambiado (p. ej. en pausa);
+    // si otro hilo tiene la caché, calcularlas aparte sin esperar
+    std::vector<GridLineX> uncachedLines;
+    const std::vector<GridLineX>* lines = &uncachedLines;
+
+    const juce::SpinLock::ScopedTryLockType lock(gridCacheLock);
+
+    if (lock.isLocked())
+    {
+        if (!gridCache.matches(frame, area, windowWidth, division))
+        {
+            findVisibleGridLines(frame, area, windowWidth, division, gridCache.lines);
+            gridCache.song = frame.songHandle;
+            gridCache.currentTime = frame.state.currentTime;
+            gridCache.isPlaying = frame.state.isPlaying;
+            gridCache.windowWidth = windowWidth;
+            gridCache.division = division;
+            gridCache.targetLineX = frame.targetLineX;
+            gridCache.area = area;
+        }
+
+        lines = &gridCache.lines;
+    }
+    else
+    {
+        findVisibleGridLines(frame, area, windowWidth, division, uncachedLines);
+    }
+
+    // Dibujar líneas de compás, tiempo y subdivisión que se acercan
+    for (const auto& line : *lines)
+    {
+        switch (line.type)
+        {
+            case BeatGrid::LineType::bar:   g.setColour(juce::Colour(0xff4d4d4d)); break;
+            case BeatGrid::LineType::beat:  g.setColour(juce::Colour(0xff333333)); break;
+            default:                        g.setColour(juce::Colour(0xff262626)); break;
+        }
+
+        g.drawVerticalLine((int)line.x, (float)area.getY(), (float)area.getBottom());
+    }
+}
+
+void PianoRollRenderer::findVisibleGridLines(const Frame& frame, const juce::Rectangle<int>& area, double windowWidth,
+                                             int division, std::vector<GridLineX>& result) const
+{
+    result.clear();
+
+    const auto& grid = frame.song.getBeatGrid();
+    const auto& gridLines = grid.getLines();
+    const double currentTime = frame.state.currentTime;
+
+    // Solo líneas futuras (desde la línea objetivo hasta el borde derecho)
+    const double pixelsPerSecond = (double)area.getWidth() / windowWidth;
+    const double endTime = currentTime + (area.getRight() - frame.targetLineX) / pixelsPerSecond;
+    const auto range = grid.findLines(currentTime, endTime);
+
+    for (size_t i = range.first; i < range.second; ++i)
+    {
+        const auto& line = gridLines[i];
+        if (!BeatGrid::isVisible(line, division))
+            continue;
+
+        const float x = (float)timeToAnimatedX(frame, line.time, area, windowWidth);
+        if (x < area.getX() || x > area.getRight())
+            continue;
+
+        // En vistas alejadas, si dos líneas quedan demasiado juntas se conserva la más fuerte
+        // (compás antes que tiempo, tiempo antes que subdivisión); así nunca hay más líneas que píxeles
+        if (!result.empty() && x - result.back().x < minimumBeatLineSpacing)
+        {
+            if (line.type < result.back().type)
+                result.back() = { x, line.type };
+
+            continue;
+        }
+
+        result.push_back({ x, line.type });
+    }
+}
+
+bool PianoRollRenderer::GridCache::matches(const Frame& frame, const juce::Rectangle<int>& newArea, double newWindowWidth, int newDivision) const
+{
+    return song.lock().get() == &frame.song
+        && currentTime == frame.state.currentTime
+        && isPlaying == frame.state.isPlaying
+        && windowWidth == newWindowWidth
+        && division == newDivision
+        && targetLineX == frame.targetLineX
+        && area == newArea;
+}
+
+//==============================================================================
+// Funciones de conversión para animación
+
+double PianoRollRenderer::timeToAnimatedX(const Frame& frame, double noteTime, const juce::Rectangle<int>& area, double windowWidth) const
+{
+    const double currentTime = frame.state.currentTime;
+
+    if (!frame.state.isPlaying)
+    {
+        // Vista en STOP: usar la misma lógica de animación pero centrada en currentTime
+        // Esto permite alinear la primera nota con la línea objetivo cuando currentTime fue ajustado
+        double timeUntilNote = noteTime - currentTime;
+        // Proteger división por cero
+        double effectiveWindow = (windowWidth <= 0.0) ? noteScrollWidth : windowWidth;
+        double scrollPixelsPerSecond = (double)area.getWidth() / effectiveWindow;
+        return frame.targetLineX + (timeUntilNote * scrollPixelsPerSecond);
+    }
+    else
+    {
+        // Vista animada: las notas se mueven de derecha a izquierda
+        // La línea objetivo está a targetLineX
+        // Las notas futuras aparecen desde la derecha
+
+        double timeUntilNote = noteTime - currentTime;
+        double scrollPixelsPerSecond = (double)area.getWidth() / windowWidth;
+
+        // Posición X: línea objetivo + (tiempo hasta nota * pixels por segundo)
+        return frame.targetLineX + (timeUntilNote * scrollPixelsPerSecond);
+    }
+}
+
+int PianoRollRenderer::noteToY(int noteNumber, int lowestNote, int highestNote, const juce::Rectangle<int>& area) const
+{
+    int numNotes = highestNote - lowestNote + 1;
+    int noteIndex = highestNote - noteNumber; // Invertir para que las notas altas estén arriba
+    float noteHeightLocal = (float)area.getHeight() / (float)numNotes;  // Renombrar para evitar conflicto
+    return area.getY() + (int)(noteIndex * noteHeightLocal + noteHeightLocal * 0.1f); // Pequeño offset para centrar
+}
+
+juce::String PianoRollRenderer::getNoteNameFromNumber(int noteNumber) const
+{
+    const char* noteNames[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+    int octave = (noteNumber / 12) - 1;
+    int noteIndex = noteNumber % 12;
+    return juce::String(noteNames[noteIndex]) + juce::String(octave);
+}
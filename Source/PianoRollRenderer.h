@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    PianoRollRenderer.h
+    Dibujo del piano roll estilo Synthesia como función pura del tiempo.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "NoteFilter.h"
+#include "WaveformMipmap.h"
+
+//==============================================================================
+/**
+    Dibuja el piano roll (teclas, escala de tiempo, notas animadas y línea
+    objetivo) a partir de un ViewState. El resultado depende solo del ViewState,
+    así que se puede usar desde el editor o desde varios hilos a la vez
+    (exportación). Las cachés internas (líneas de la rejilla e imagen del
+    teclado) están protegidas y se omiten si otro hilo las está usando.
+*/
+class PianoRollRenderer
+{
+public:
+    // Estado de la vista necesario para dibujar un frame
+    struct ViewState
+    {
+        double currentTime = 0.0;   // Tiempo actual de reproducción
+        bool isPlaying = false;
+        int bpm = 120;
+        float speed = 1.0f;
+        juce::String timeFigure = "1/4";
+        NoteFilter filter;          // Pistas, canales y notas ocultas
+
+        // Golpes detectados en la entrada de audio (solo el editor; nullptr al exportar)
+        const std::vector<DrumVisualizerAudioProcessor::InputHit>* inputHits = nullptr;
+
+        // Picos de la entrada; si no es nullptr se dibujan en un carril bajo el piano roll
+        const WaveformMipmap* inputWaveform = nullptr;
+    };
+
+    explicit PianoRollRenderer (const DrumVisualizerAudioProcessor& processor);
+
+    // Dibuja el piano roll completo dentro del área
+    void render (juce::Graphics& g, const juce::Rectangle<int>& area, const ViewState& state) const;
+
+    // Velocidad de scroll relativa al tiempo real para un BPM y velocidad dados
+    static double getScrollSpeed (int bpm, float speed);
+
+private:
+    // Contexto de un frame: estado de la vista, canción y posición de la línea objetivo
+    struct Frame
+    {
+        const ViewState& state;
+        const PreparedSong& song;
+        int targetLineX;
+        std::weak_ptr<const PreparedSong> songHandle;   // Para validar cachés
+    };
+
+    // Línea de la rejilla ya colocada en pantalla
+    struct GridLineX
+    {
+        float x;
+        BeatGrid::LineType type;
+    };
+
+    // Líneas visibles de la última vista dibujada; se reutilizan mientras la vista no cambie
+    struct GridCache
+    {
+        std::weak_ptr<const PreparedSong> song;
+        double currentTime = 0.0;
+        bool isPlaying = false;
+        double windowWidth = 0.0;
+        int division = 0;
+        int targetLineX = 0;
+        juce::Rectangle<int> area;
+        std::vector<GridLineX> lines;
+
+        bool matches (const Frame& frame, const juce::Rectangle<int>& newArea, double newWindowWidth, int newDivision) const;
+    };
+
+    // Teclado ya dibujado para un área y rango de notas (no cambia de un frame a otro)
+    struct KeyboardCache
+    {
+        juce::Image image;
+        juce::Rectangle<int> area;
+        int lowestNote = -1, highestNote = -1;
+        float scale = 0.0f;
+    };
+
+    // Carriles de controladores (CC): una columna por píxel en una rejilla absoluta de tiempo, así que
+    // el trazo de la vista anterior sirve mientras el tramo visible no avance una columna entera
+    struct ControllerLaneCache
+    {
+        std::weak_ptr<const PreparedSong> song;
+        int controller = -1;
+        double secondsPerPixel = 0.0;
+        juce::int64 firstColumn = 0;
+        int numColumns = 0;
+        int height = 0;
+        juce::Path path;                // En coordenadas de columna (x) y del carril (y)
+    };
+
+    // Etiqueta de un carril (en la columna del teclado) ya dibujada; key distingue su contenido
+    struct LabelCache
+    {
+        juce::Image image;
+        juce::Rectangle<int> area;
+        int key = -1;
+        float scale = 0.0f;
+    };
+
+    using LabelDrawer = void (*) (juce::Graphics& g, const juce::Rectangle<int>& area, int key);
+
+    void drawCachedLabel (juce::Graphics& g, LabelCache& cache, const juce::Rectangle<int>& area, int key, LabelDrawer drawLabel) const;
+    static void drawInputWaveformLabel (juce::Graphics& g, const juce::Rectangle<int>& area, int key);
+    static void drawControllerLabel (juce::Graphics& g, const juce::Rectangle<int>& area, int controller);
+    void drawCachedPianoKeys (juce::Graphics& g, const juce::Rectangle<int>& keyArea, int lowestNote, int highestNote) const;
+    void drawPianoKeys (juce::Graphics& g, const juce::Rectangle<int>& keyArea, int lowestNote, int highestNote) const;
+    void drawAnimatedMidiNotes (juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote) const;
+    void drawAggregatedNotes (juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote,
+                              double windowStart, double windowEnd) const;
+    void drawInputHits (juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote) const;
+    void drawControllerLane (juce::Graphics& g, const Frame& frame, const ControllerLanes::Lane& lane,
+                             const juce::Rectangle<int>& labelArea, const juce::Rectangle<int>& laneArea, int laneIndex) const;
+    static void buildControllerPath (const ControllerLanes::Lane& lane, juce::int64 firstColumn, int numColumns,
+                                     double secondsPerPixel, float height, juce::Path& path);
+    void drawInputWaveform (juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& laneArea) const;
+
+    // Segundos visibles entre la línea objetivo y el borde derecho: en pausa, hasta el final de la canción
+    double getWindowWidth (const Frame& frame) const;
+
+    void drawTargetLine (juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& area) const;
+    void drawTimeScale (juce::Graphics& g, const Frame& frame, const juce::Rectangle<int>& area) const;
+    void findVisibleGridLines (const Frame& frame, const juce::Rectangle<int>& area, double windowWidth,
+                               int division, std::vector<GridLineX>& result) const;
+
+    // Funciones de conversión para animación
+    double timeToAnimatedX (const Frame& frame, double noteTime, const juce::Rectangle<int>& area, double windowWidth) const;
+    int noteToY (int noteNumber, int lowestNote, int highestNote, const juce::Rectangle<int>& area) const;
+    juce::String getNoteNameFromNumber (int noteNumber) const;
+
+    const DrumVisualizerAudioProcessor& audioProcessor;
+    const double noteScrollWidth = 12.0; // Ancho en segundos de la ventana de scroll
+    const double minimumBeatLineSpacing = 4.0; // Píxeles mínimos entre líneas de beat
+    const int inputWaveformHeight = 56; // Alto del carril de la forma de onda de la entrada
+    const int controllerLaneHeight = 40; // Alto de cada carril de controlador
+    static constexpr int maximumControllerLanes = 4;
+
+    mutable GridCache gridCache;
+    mutable juce::SpinLock gridCacheLock;
+    mutable KeyboardCache keyboardCache;
+    mutable juce::SpinLock keyboardCacheLock;
+    mutable LabelCache inputWaveformLabelCache;
+    mutable std::array<LabelCache, maximumControllerLanes> controllerLabelCaches;
+    mutable juce::SpinLock labelCacheLock;
+    mutable std::array<ControllerLaneCache, maximumControllerLanes> controllerLaneCaches;
+    mutable juce::SpinLock controllerLaneCacheLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PianoRollRenderer)
+};
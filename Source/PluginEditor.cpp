@@ -8,10 +8,11 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AudioAligner.h"
 
 //==============================================================================
 DrumVisualizerAudioProcessorEditor::DrumVisualizerAudioProcessorEditor (DrumVisualizerAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), pianoRollRenderer (p)
 {
     // Set the editor's size to the specified dimensions
     setSize (1200, 800);
@@ -32,6 +33,11 @@ DrumVisualizerAudioProcessorEditor::DrumVisualizerAudioProcessorEditor (DrumVisu
     exploreButton.setButtonText("Explorar");
     exploreButton.onClick = [this] { openFileChooser(); };
 
+    // Botón para buscar en la biblioteca o escanear una carpeta
+    addAndMakeVisible(libraryButton);
+    libraryButton.setButtonText("Biblioteca");
+    libraryButton.onClick = [this] { showLibrary(); };
+
     // Botón para cargar archivos MIDI
     addAndMakeVisible(loadMidiButton);
     loadMidiButton.setButtonText("Cargar MIDI");
@@ -40,6 +46,16 @@ DrumVisualizerAudioProcessorEditor::DrumVisualizerAudioProcessorEditor (DrumVisu
     // Inicialmente deshabilitar el botón si el texto está vacío o es el placeholder
     loadMidiButton.setEnabled(false);
 
+    // Botón para elegir qué pistas, canales y notas se muestran
+    addAndMakeVisible(filterButton);
+    filterButton.setButtonText("Filtros");
+    filterButton.onClick = [this] { showFilterMenu(); };
+
+    // Botón de sonido: metrónomo (compás, tiempo y subdivisión de TIME FIGURE) y batería
+    addAndMakeVisible(soundButton);
+    soundButton.setButtonText("Sonido");
+    soundButton.onClick = [this] { showSoundMenu(); };
+
     // Configurar y añadir los widgets al segundo marco (middleFrame)
 
     // Label para BPM
@@ -84,6 +100,13 @@ DrumVisualizerAudioProcessorEditor::DrumVisualizerAudioProcessorEditor (DrumVisu
     addAndMakeVisible(stopButton);
     stopButton.onClick = [this] { stopPlayback(); };
 
+    // Botones del setlist (habilitados solo con un setlist cargado)
+    addAndMakeVisible(previousSongButton);
+    previousSongButton.onClick = [this] { selectSetlistSong(audioProcessor.getSetlist().getCurrentIndex() - 1); };
+    addAndMakeVisible(nextSongButton);
+    nextSongButton.onClick = [this] { selectSetlistSong(audioProcessor.getSetlist().getCurrentIndex() + 1); };
+    updateSetlistButtons();
+
     // Label para Time Figure
     addAndMakeVisible(timeFigLabel);
     timeFigLabel.setText("TIME FIGURE", juce::dontSendNotification);
@@ -98,24 +121,35 @@ DrumVisualizerAudioProcessorEditor::DrumVisualizerAudioProcessorEditor (DrumVisu
     timeFigComboBox.setSelectedId(1); // Selecciona "1/4" por defecto
     timeFigComboBox.addListener(this); // Registrar listener para cambios
 
-    // Inicializar valores
-    updateBpmValue();
-    updateSpeedValue();
-    updateTimeFigValue();
+    // Minimap: se muestra al cargar un MIDI
+    addChildComponent(minimap);
+    minimap.onSeek = [this](double seconds) { seekTo(seconds); };
+
+    // Capacidad fija: collectInputHits no reserva memoria durante la reproducción
+    inputHits.reserve(maximumInputHits);
+
+    // Inicializar valores con los del procesador (pueden venir de la sesión guardada)
+    applyViewSettings(audioProcessor.getViewSettings());
 
     // Inicializar directorio por defecto para explorar archivos
     lastBrowsedDirectory = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getFullPathName();
-    
-    // Configurar la línea objetivo al 25% del ancho (las notas vendrán de la derecha)
-    targetLineX = static_cast<int>(getWidth() * 0.25f);
+
+    // Si ya hay una canción (editor reabierto) mostrarla; si la sesión aún se está
+    // restaurando, el procesador avisa al terminar
+    showProcessorSong();
+    audioProcessor.addChangeListener(this);
 }
 
 DrumVisualizerAudioProcessorEditor::~DrumVisualizerAudioProcessorEditor()
 {
     // Parar el timer si está corriendo
     stopTimer();
+
+    // La reproducción la controla el editor: sin él, el metrónomo se calla
+    audioProcessor.setTransportPlaying(false);
     
     // Desregistrar listeners
+    audioProcessor.removeChangeListener(this);
     textEditor.removeListener(this);
     bpmEditor.removeListener(this);
     speedComboBox.removeListener(this);
@@ -125,6 +159,9 @@ DrumVisualizerAudioProcessorEditor::~DrumVisualizerAudioProcessorEditor()
 //==============================================================================
 void DrumVisualizerAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    // Cada frame debe dibujarse sin reservar memoria (se comprueba con DRUMVISUALIZER_REALTIME_AUDIT)
+    RealtimeAudit::Scope auditScope("paint", audioProcessor.getLogger());
+
     // Establece el color de fondo de la ventana
     g.fillAll (juce::Colour::fromString("#404040"));
 
@@ -167,7 +204,8 @@ void DrumVisualizerAudioProcessorEditor::paint (juce::Graphics& g)
     {
         // Área del piano roll con padding de 10 píxeles en todos los bordes
         pianoRollArea = bottomFrame.reduced(10);
-        drawSynthesiaPianoRoll(g, pianoRollArea);
+        pianoRollArea.removeFromTop(minimapHeight + verticalPadding); // Espacio del minimap
+        pianoRollRenderer.render(g, pianoRollArea, getViewState());
     }
     else
     {
@@ -193,8 +231,8 @@ void DrumVisualizerAudioProcessorEditor::resized()
     auto topFrame = bounds.removeFromTop(50);
 
     // Configuración del input de texto
-    auto textEditorWidth = static_cast<int>(topFrame.getWidth() * 0.75f); // 75% del ancho del contenedor
-    auto buttonWidth = (topFrame.getWidth() - textEditorWidth - horizontalSpacing * 2) / 2; // Espacio restante dividido entre los botones
+    auto textEditorWidth = static_cast<int>(topFrame.getWidth() * 0.6f); // 60% del ancho del contenedor
+    auto buttonWidth = (topFrame.getWidth() - textEditorWidth - horizontalSpacing * 5) / 5; // Espacio restante dividido entre los botones
 
     textEditor.setBounds(topFrame.removeFromLeft(textEditorWidth).reduced(0, verticalSpacing));
     textEditor.setJustification(juce::Justification::centred); // Centrar texto verticalmente
@@ -205,16 +243,28 @@ void DrumVisualizerAudioProcessorEditor::resized()
 
     topFrame.removeFromLeft(horizontalSpacing); // Espaciado horizontal entre los botones
 
+    libraryButton.setBounds(topFrame.removeFromLeft(buttonWidth).reduced(0, verticalSpacing));
+
+    topFrame.removeFromLeft(horizontalSpacing);
+
     loadMidiButton.setBounds(topFrame.removeFromLeft(buttonWidth).reduced(0, verticalSpacing));
 
+    topFrame.removeFromLeft(horizontalSpacing);
+
+    filterButton.setBounds(topFrame.removeFromLeft(buttonWidth).reduced(0, verticalSpacing));
+
+    topFrame.removeFromLeft(horizontalSpacing);
+
+    soundButton.setBounds(topFrame.removeFromLeft(buttonWidth).reduced(0, verticalSpacing));
+
     // Espaciado vertical entre contenedores
     bounds.removeFromTop(verticalSpacing);
 
     // Layout del segundo marco (middleFrame)
     auto middleFrame = bounds.removeFromTop(50);
 
-    // Calcular ancho de cada widget en el segundo contenedor (5 widgets en total)
-    auto widgetWidth = (middleFrame.getWidth() - horizontalSpacing * 4) / 5; // 4 espacios entre 5 widgets
+    // Calcular ancho de cada widget en el segundo contenedor (7 widgets en total)
+    auto widgetWidth = (middleFrame.getWidth() - horizontalSpacing * 6) / 7; // 6 espacios entre 7 widgets
 
     // Contenedor BPM (dividido en Label + Input)
     auto bpmContainer = middleFrame.removeFromLeft(widgetWidth).reduced(0, verticalSpacing);
@@ -244,12 +294,29 @@ void DrumVisualizerAudioProcessorEditor::resized()
 
     middleFrame.removeFromLeft(horizontalSpacing); // Espaciado horizontal
 
+    // Botones del setlist
+    previousSongButton.setBounds(middleFrame.removeFromLeft(widgetWidth).reduced(0, verticalSpacing));
+
+    middleFrame.removeFromLeft(horizontalSpacing); // Espaciado horizontal
+
+    nextSongButton.setBounds(middleFrame.removeFromLeft(widgetWidth).reduced(0, verticalSpacing));
+
+    middleFrame.removeFromLeft(horizontalSpacing); // Espaciado horizontal
+
     // Contenedor Time Figure (dividido en Label + ComboBox)
     auto timeFigContainer = middleFrame.removeFromLeft(widgetWidth).reduced(0, verticalSpacing);
     auto timeFigLabelWidth = timeFigContainer.getWidth() / 2; // 50% para el label
     
     timeFigLabel.setBounds(timeFigContainer.removeFromLeft(timeFigLabelWidth));
     timeFigComboBox.setBounds(timeFigContainer); // El resto para el combobox
+
+    // Minimap en la parte superior del tercer marco (mismos márgenes que paint)
+    auto rollBounds = getLocalBounds().reduced(20, 10);
+    rollBounds.removeFromTop(50 + verticalSpacing + 50 + verticalSpacing);
+    minimap.setBounds(rollBounds.reduced(10).removeFromTop(minimapHeight));
+
+    // Las vistas generales precargadas por el setlist se dibujan ya a este tamaño
+    audioProcessor.getSetlist().setOverviewSize(minimap.getWidth(), minimap.getHeight());
 }
 
 //==============================================================================
@@ -266,9 +333,25 @@ void DrumVisualizerAudioProcessorEditor::timerCallback()
         double deltaTime = (currentSystemTime - lastUpdateTime) / 1000.0; // Convertir a segundos
         lastUpdateTime = currentSystemTime;
         
-        // Actualizar tiempo actual basado en BPM y velocidad
-        double scrollSpeed = getScrollSpeed();
-        currentTime += deltaTime * scrollSpeed;
+        if (audioProcessor.isTransportRunning())
+        {
+            // Con audio, el reloj lo lleva processBlock: la vista sigue al metrónomo
+            currentTime = audioProcessor.getTransportSeconds();
+            audioProcessor.followTransport(currentTime);
+        }
+        else
+        {
+            // Sin audio, actualizar tiempo actual basado en BPM y velocidad
+            double scrollSpeed = getScrollSpeed();
+            currentTime += deltaTime * scrollSpeed;
+
+            // Mantener sincronizados el cursor del procesador (y su reloj) con la vista
+            audioProcessor.seekTo(currentTime);
+        }
+
+        minimap.setPlayheadTime(currentTime);
+        collectInputHits();
+        collectInputWaveform();
         
         // Verificar si hemos llegado al final del MIDI
         double totalLength = audioProcessor.getLengthInSeconds();
@@ -312,6 +395,13 @@ void DrumVisualizerAudioProcessorEditor::comboBoxChanged(juce::ComboBox* comboBo
     }
 }
 
+void DrumVisualizerAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    // El procesador terminó de restaurar la canción de la sesión
+    if (source == &audioProcessor)
+        showProcessorSong();
+}
+
 // Métodos privados para actualizar valores
 void DrumVisualizerAudioProcessorEditor::updateBpmValue()
 {
@@ -322,6 +412,7 @@ void DrumVisualizerAudioProcessorEditor::updateBpmValue()
         if (newBpm > 0 && newBpm <= 300) // Validar rango razonable
         {
             bpmVALUE = newBpm;
+            storeViewSettings();
             juce::Logger::writeToLog("BPM actualizado: " + juce::String(bpmVALUE));
             
             // Si está reproduciendo, la velocidad de scroll se actualizará automáticamente
@@ -347,6 +438,7 @@ void DrumVisualizerAudioProcessorEditor::updateSpeedValue()
         if (newSpeed > 0 && newSpeed <= 5.0) // Validar rango razonable
         {
             speedVALUE = newSpeed;
+            storeViewSettings();
             juce::Logger::writeToLog("Speed actualizado: " + juce::String(speedVALUE));
             
             // Si está reproduciendo, la velocidad de scroll se actualizará automáticamente
@@ -361,9 +453,63 @@ void DrumVisualizerAudioProcessorEditor::updateSpeedValue()
 void DrumVisualizerAudioProcessorEditor::updateTimeFigValue()
 {
     timefigVALUE = timeFigComboBox.getText();
+    storeViewSettings();
     juce::Logger::writeToLog("Time Figure actualizado: " + timefigVALUE);
 }
 
+void DrumVisualizerAudioProcessorEditor::applyViewSettings(const DrumVisualizerAudioProcessor::ViewSettings& settings)
+{
+    bpmEditor.setText(juce::String(settings.bpm), false);
+
+    // Seleccionar las opciones de las listas por su texto; si no existen se quedan las actuales
+    for (int i = 0; i < speedComboBox.getNumItems(); ++i)
+        if (juce::approximatelyEqual(speedComboBox.getItemText(i).getFloatValue(), settings.speed))
+            speedComboBox.setSelectedItemIndex(i, juce::dontSendNotification);
+
+    for (int i = 0; i < timeFigComboBox.getNumItems(); ++i)
+        if (timeFigComboBox.getItemText(i) == settings.timeFigure)
+            timeFigComboBox.setSelectedItemIndex(i, juce::dontSendNotification);
+
+    metronomeVALUE = settings.metronome;
+    drumsVALUE = settings.drums;
+    inputHitsVALUE = settings.inputHits;
+    inputWaveformVALUE = settings.inputWaveform;
+
+    updateBpmValue();
+    updateSpeedValue();
+    updateTimeFigValue();
+}
+
+void DrumVisualizerAudioProcessorEditor::storeViewSettings()
+{
+    DrumVisualizerAudioProcessor::ViewSettings settings;
+    settings.bpm = bpmVALUE;
+    settings.speed = speedVALUE;
+    settings.timeFigure = timefigVALUE;
+    settings.metronome = metronomeVALUE;
+    settings.drums = drumsVALUE;
+    settings.inputHits = inputHitsVALUE;
+    settings.inputWaveform = inputWaveformVALUE;
+    audioProcessor.setViewSettings(settings);
+}
+
+void DrumVisualizerAudioProcessorEditor::showProcessorSong()
+{
+    auto song = audioProcessor.getPreparedSong();
+    if (song == nullptr)
+        return;
+
+    // A diferencia de una carga nueva, se conservan el BPM guardado y la posición
+    textEditor.setText(audioProcessor.getLoadedFile().getFullPathName(), false);
+    loadMidiButton.setEnabled(true);
+    applyViewSettings(audioProcessor.getViewSettings());
+
+    minimap.setSong(song);
+    minimap.setVisible(true);
+    seekTo(audioProcessor.getPlaybackPosition().seconds);
+    updateSetlistButtons();
+}
+
 //==============================================================================
 // Métodos para manejo de archivos MIDI
 
@@ -420,6 +566,13 @@ void DrumVisualizerAudioProcessorEditor::loadMidiFile()
         return;
     }
     
+    // Un setlist (lista de rutas) en lugar de un MIDI
+    if (Setlist::isSetlistFile(midiFile))
+    {
+        loadSetlist(midiFile);
+        return;
+    }
+
     // Validar extensión
     juce::String extension = midiFile.getFileExtension().toLowerCase();
     if (extension != ".mid" && extension != ".midi")
@@ -442,6 +595,424 @@ void DrumVisualizerAudioProcessorEditor::loadMidiFile()
     }
 }
 
+void DrumVisualizerAudioProcessorEditor::showLibrary()
+{
+    const juce::String text = textEditor.getText().trim();
+
+    // Una carpeta en el cuadro de texto: añadirla (o actualizarla) en la biblioteca
+    if (juce::File::isAbsolutePath(text) && juce::File(text).isDirectory())
+    {
+        scanLibraryFolder(juce::File(text));
+        return;
+    }
+
+    if (midiLibrary->getNumEntries() == 0)
+    {
+        showMessage("Biblioteca vacía", "Escribe la ruta de una carpeta con archivos MIDI y pulsa 'Biblioteca' para escanearla.");
+        return;
+    }
+
+    // Buscar en el índice con las palabras escritas (la ruta por defecto no filtra)
+    MidiLibrary::Query query;
+    query.text = juce::File::isAbsolutePath(text) || text.startsWith("Ingrese") ? juce::String() : text;
+    query.maxResults = 40;
+
+    const auto results = midiLibrary->search(query);
+    if (results.empty())
+    {
+        showMessage("Biblioteca", "No hay archivos que coincidan con: " + query.text);
+        return;
+    }
+
+    juce::PopupMenu menu;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& entry = results[i];
+        menu.addItem((int)i + 1, juce::File(entry.path).getFileNameWithoutExtension()
+                                   + "  (" + juce::String(entry.lengthSeconds / 60.0, 1) + " min, "
+                                   + juce::String(juce::roundToInt(entry.minBpm)) + " BPM)");
+    }
+
+    juce::Array<juce::String> paths;
+    for (const auto& entry : results)
+        paths.add(entry.path);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&libraryButton),
+                       [safeThis = juce::Component::SafePointer<DrumVisualizerAudioProcessorEditor>(this), paths](int result)
+    {
+        if (safeThis == nullptr || result <= 0)
+            return;
+
+        safeThis->textEditor.setText(paths[result - 1]);
+        safeThis->loadMidiButton.setEnabled(true);
+        safeThis->loadMidiFile();
+    });
+}
+
+void DrumVisualizerAudioProcessorEditor::scanLibraryFolder(const juce::File& folder)
+{
+    libraryButton.setEnabled(false);
+    libraryButton.setButtonText("Escaneando...");
+
+    // El escaneo bloquea, así que corre en el pool del procesador, que lo cancela al destruirse;
+    // la biblioteca es compartida y la copia del puntero la mantiene viva aunque se cierre el editor
+    juce::SharedResourcePointer<MidiLibrary> library;
+    audioProcessor.getBackgroundPool().addJob([library, folder, safeThis = juce::Component::SafePointer<DrumVisualizerAudioProcessorEditor>(this)]
+    {
+        const auto result = library->scan({ folder }, 0,
+                                          [job = juce::ThreadPoolJob::getCurrentThreadPoolJob()] { return job != nullptr && job->shouldExit(); });
+        if (result.cancelled)
+            return;
+
+        juce::MessageManager::callAsync([safeThis, result, numEntries = library->getNumEntries()]
+        {
+            if (safeThis == nullptr)
+                return;
+
+            safeThis->libraryButton.setEnabled(true);
+            safeThis->libraryButton.setButtonText("Biblioteca");
+            safeThis->showMessage("Biblioteca actualizada",
+                                  juce::String(result.numFiles) + " archivos MIDI en la carpeta ("
+                                  + juce::String(result.numRead) + " leídos, " + juce::String(result.numFailed) + " no válidos) en "
+                                  + juce::String(result.seconds, 2) + " s.\n"
+                                  + juce::String(numEntries) + " archivos en la biblioteca. Escribe un nombre y pulsa 'Biblioteca' para buscar.");
+        });
+    });
+}
+
+void DrumVisualizerAudioProcessorEditor::loadSetlist(const juce::File& setlistFile)
+{
+    const auto files = Setlist::readSetlistFile(setlistFile);
+    if (files.isEmpty())
+    {
+        showMessage("Error", "El setlist no contiene rutas de archivos existentes:\n" + setlistFile.getFullPathName());
+        return;
+    }
+
+    audioProcessor.getSetlist().setFiles(files);
+    selectSetlistSong(0);
+}
+
+void DrumVisualizerAudioProcessorEditor::selectSetlistSong(int index)
+{
+    auto& setlist = audioProcessor.getSetlist();
+    if (!juce::isPositiveAndBelow(index, setlist.getNumSongs()))
+        return;
+
+    if (isPlaying)
+        stopPlayback();
+
+    // Si estaba precargada, esto es solo un cambio de puntero (sin leer ni dibujar nada)
+    auto entry = setlist.select(index);
+    if (entry == nullptr)
+    {
+        showMessage("Error", "No fue posible cargar el MIDI:\n" + setlist.getFile(index).getFullPathName());
+        updateSetlistButtons();
+        return;
+    }
+
+    audioProcessor.setSong(entry->file, entry->contentHash, entry->song);
+    textEditor.setText(entry->file.getFullPathName(), false);
+    updateUIAfterMidiLoad(entry->overview);
+    updateSetlistButtons();
+
+    juce::Logger::writeToLog("Setlist: " + juce::String(index + 1) + "/" + juce::String(setlist.getNumSongs())
+                             + " - " + entry->file.getFileName());
+}
+
+void DrumVisualizerAudioProcessorEditor::updateSetlistButtons()
+{
+    const auto& setlist = audioProcessor.getSetlist();
+    previousSongButton.setEnabled(setlist.getCurrentIndex() > 0);
+    nextSongButton.setEnabled(setlist.getCurrentIndex() >= 0 && setlist.getCurrentIndex() < setlist.getNumSongs() - 1);
+}
+
+void DrumVisualizerAudioProcessorEditor::showFilterMenu()
+{
+    auto song = audioProcessor.getPreparedSong();
+    if (song == nullptr)
+    {
+        showMessage("Filtros", "Carga un MIDI para elegir qué pistas, canales y notas se muestran.");
+        return;
+    }
+
+    // Ids del menú: 1-2 acciones, 1000+ pistas, 2000+ canales, 3000+ notas, 4000+ controladores
+    enum { showAllId = 1, kickAndSnareId = 2, trackBaseId = 1000, channelBaseId = 2000, noteBaseId = 3000, controllerBaseId = 4000 };
+
+    const auto filter = audioProcessor.getNoteFilter();
+
+    // Las pistas, canales y notas usados vienen del resumen de pistas hecho en la carga
+    juce::uint16 usedChannels = 0;
+    std::bitset<128> usedNotes;
+    juce::PopupMenu tracksMenu, channelsMenu, notesMenu;
+
+    const auto& tracks = song->getTracks();
+    for (int track = 0; track < (int)tracks.size() && track < NoteFilter::maximumTracks; ++track)
+    {
+        const auto& info = tracks[(size_t)track];
+        usedChannels |= info.channels;
+        usedNotes |= info.notes;
+
+        if (info.numNotes > 0)
+            tracksMenu.addItem(trackBaseId + track,
+                               juce::String(track + 1) + ": " + (info.name.isNotEmpty() ? info.name : "Pista " + juce::String(track + 1))
+                                   + " (" + juce::String(info.numNotes) + " notas)",
+                               true, filter.isTrackVisible(track));
+    }
+
+    for (int channel = 1; channel <= 16; ++channel)
+        if ((usedChannels & (1u << (channel - 1))) != 0)
+            channelsMenu.addItem(channelBaseId + channel, "Canal " + juce::String(channel), true, filter.isChannelVisible(channel));
+
+    for (int noteNumber = 0; noteNumber < 128; ++noteNumber)
+        if (usedNotes[(size_t)noteNumber])
+            notesMenu.addItem(noteBaseId + noteNumber,
+                              juce::String(noteNumber) + " " + juce::MidiMessage::getRhythmInstrumentName(noteNumber),
+                              true, filter.isNoteVisible(noteNumber));
+
+    // Carriles de controladores: uno por cada controlador con mensajes en la canción
+    juce::PopupMenu controllersMenu;
+    for (const auto& lane : song->getControllers().getLanes())
+    {
+        const auto* name = juce::MidiMessage::getControllerName(lane.getController());
+        controllersMenu.addItem(controllerBaseId + lane.getController(),
+                                "CC" + juce::String(lane.getController()) + (name != nullptr ? " " + juce::String(name) : juce::String())
+                                    + " (" + juce::String((juce::int64)lane.size()) + " eventos)",
+                                true, filter.isControllerVisible(lane.getController()));
+    }
+
+    juce::PopupMenu menu;
+    menu.addItem(showAllId, "Mostrar todo", !filter.isEmpty());
+    menu.addItem(kickAndSnareId, "Solo bombo y caja");
+    menu.addSeparator();
+    menu.addSubMenu("Pistas", tracksMenu);
+    menu.addSubMenu("Canales", channelsMenu);
+    menu.addSubMenu("Notas", notesMenu);
+    menu.addSubMenu("Controladores", controllersMenu, !song->getControllers().getLanes().empty());
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&filterButton),
+                       [safeThis = juce::Component::SafePointer<DrumVisualizerAudioProcessorEditor>(this)](int result)
+    {
+        if (safeThis == nullptr || result <= 0)
+            return;
+
+        // Solo cambia la máscara: la canción y sus índices no se tocan
+        auto newFilter = safeThis->audioProcessor.getNoteFilter();
+
+        if (result == showAllId)
+            newFilter.showAll();
+        else if (result == kickAndSnareId)
+            newFilter.showOnlyNotes({ 35, 36, 37, 38, 40 }); // Bombos, rimshot y cajas (GM)
+        else if (result >= controllerBaseId)
+            newFilter.setControllerVisible(result - controllerBaseId, !newFilter.isControllerVisible(result - controllerBaseId));
+        else if (result >= noteBaseId)
+            newFilter.setNoteVisible(result - noteBaseId, !newFilter.isNoteVisible(result - noteBaseId));
+        else if (result >= channelBaseId)
+            newFilter.setChannelVisible(result - channelBaseId, !newFilter.isChannelVisible(result - channelBaseId));
+        else if (result >= trackBaseId)
+            newFilter.setTrackVisible(result - trackBaseId, !newFilter.isTrackVisible(result - trackBaseId));
+
+        safeThis->audioProcessor.setNoteFilter(newFilter);
+        safeThis->repaint();
+    });
+}
+
+void DrumVisualizerAudioProcessorEditor::showSoundMenu()
+{
+    enum { metronomeId = 1, drumsId, inputHitsId, inputWaveformId, builtInKitId, folderKitId, alignId, recordId, calibrationId };
+
+    const auto kitFolder = audioProcessor.getDrumKitFolder();
+
+    juce::PopupMenu menu;
+    menu.addItem(metronomeId, "Metrónomo", true, metronomeVALUE);
+    menu.addItem(drumsId, "Batería", true, drumsVALUE);
+    menu.addItem(inputHitsId, "Golpes de la entrada (micros)", true, inputHitsVALUE);
+    menu.addItem(inputWaveformId, "Forma de onda de la entrada", true, inputWaveformVALUE);
+    addCalibrationMenu(menu, calibrationId);
+    menu.addSeparator();
+    menu.addItem(builtInKitId, "Kit integrado", true, kitFolder == juce::File());
+    menu.addItem(folderKitId, kitFolder == juce::File() ? juce::String("Cargar kit de muestras...")
+                                                        : "Kit: " + kitFolder.getFileName() + "...",
+                 true, kitFolder != juce::File());
+    menu.addSeparator();
+    menu.addItem(alignId, "Alinear con una grabación...", audioProcessor.hasMidiLoaded() && !aligningToRecording);
+    menu.addItem(recordId, "Grabar lo que toco (MIDI)", true, audioProcessor.isRecordingMidi());
+
+    // Solo informativo: estado de la lectura desde disco del kit de muestras
+    if (kitFolder != juce::File())
+    {
+        const auto statistics = audioProcessor.getDrumStreamingStatistics();
+        menu.addItem(-1, "Disco: " + juce::String(statistics.activeStreams) + " voces, "
+                             + juce::String((juce::int64) statistics.underruns) + " cortes", false, false);
+    }
+
+    // Canciones paginadas: bloques en los que las notas aún no se habían leído del disco
+    if (const int noteUnderruns = audioProcessor.getNoteUnderruns(); noteUnderruns > 0)
+        menu.addItem(-1, "Notas en disco: " + juce::String(noteUnderruns) + " cortes", false, false);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&soundButton),
+                       [safeThis = juce::Component::SafePointer<DrumVisualizerAudioProcessorEditor>(this)](int result)
+    {
+        if (safeThis == nullptr || result <= 0)
+            return;
+
+        if (result == metronomeId)
+            safeThis->metronomeVALUE = !safeThis->metronomeVALUE;
+        else if (result == drumsId)
+            safeThis->drumsVALUE = !safeThis->drumsVALUE;
+        else if (result == inputHitsId)
+            safeThis->inputHitsVALUE = !safeThis->inputHitsVALUE;
+        else if (result == inputWaveformId)
+        {
+            safeThis->inputWaveformVALUE = !safeThis->inputWaveformVALUE;
+            safeThis->inputWaveform.clear();
+        }
+        else if (result == builtInKitId)
+        {
+            juce::String error;
+            safeThis->audioProcessor.loadDrumKit({}, error);
+        }
+        else if (result == folderKitId)
+        {
+            safeThis->chooseDrumKitFolder();
+        }
+        else if (result == alignId)
+        {
+            safeThis->chooseRecordingToAlign();
+        }
+        else if (result == recordId)
+        {
+            safeThis->toggleMidiRecording();
+        }
+        else if (result >= calibrationId)
+        {
+            safeThis->handleCalibrationMenu(result - calibrationId);
+        }
+
+        safeThis->storeViewSettings();
+    });
+}
+
+void DrumVisualizerAudioProcessorEditor::chooseDrumKitFolder()
+{
+    // Carpeta con muestras "<nota>[_v<capa>][_rr<n>].wav" (p. ej. 38_v2_rr1.wav)
+    fileChooser = std::make_unique<juce::FileChooser>("Seleccionar carpeta del kit de batería",
+                                                      juce::File(lastBrowsedDirectory));
+
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+                             [this](const juce::FileChooser& chooser)
+    {
+        const auto folder = chooser.getResult();
+        if (!folder.isDirectory())
+            return;
+
+        juce::String error;
+        if (audioProcessor.loadDrumKit(folder, error))
+        {
+            // Cargar un kit implica querer oírlo
+            drumsVALUE = true;
+            storeViewSettings();
+        }
+        else
+        {
+            showMessage("Kit de batería", error);
+        }
+    });
+}
+
+void DrumVisualizerAudioProcessorEditor::chooseRecordingToAlign()
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    fileChooser = std::make_unique<juce::FileChooser>("Seleccionar la grabación de la canción",
+                                                      juce::File(lastBrowsedDirectory),
+                                                      formatManager.getWildcardForAllFormats());
+
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                             [this](const juce::FileChooser& chooser)
+    {
+        const auto recording = chooser.getResult();
+        const auto midiFile = audioProcessor.getLoadedFile();
+        const auto contentHash = audioProcessor.getLoadedContentHash();
+        if (!recording.existsAsFile() || !midiFile.existsAsFile())
+            return;
+
+        aligningToRecording = true;
+        juce::Logger::writeToLog("Alineando " + midiFile.getFileName() + " con " + recording.getFileName());
+
+        // La alineación tarda unos segundos: se hace en el pool del procesador (que la cancela al
+        // destruirse) y la canción ajustada se publica desde el hilo de mensajes, igual que al cargar un MIDI
+        audioProcessor.getBackgroundPool().addJob([midiFile, contentHash, recording, safeThis = juce::Component::SafePointer<DrumVisualizerAudioProcessorEditor>(this)]
+        {
+            AudioAligner::Options options;
+            options.shouldExit = [job = juce::ThreadPoolJob::getCurrentThreadPoolJob()] { return job != nullptr && job->shouldExit(); };
+
+            juce::String error;
+            AudioAligner::Result result;
+            auto song = AudioAligner(options).alignMidiFile(midiFile, recording, error, &result);
+
+            juce::MessageManager::callAsync([safeThis, midiFile, contentHash, recording, song, error, result]
+            {
+                if (safeThis == nullptr)
+                    return;
+
+                safeThis->aligningToRecording = false;
+
+                // Si mientras tanto se cargó otra canción, el resultado ya no sirve
+                if (safeThis->audioProcessor.getLoadedFile() != midiFile)
+                    return;
+
+                if (song == nullptr)
+                {
+                    safeThis->showMessage("Alineación", "No fue posible alinear la canción con la grabación:\n" + error);
+                    return;
+                }
+
+                if (safeThis->isPlaying)
+                    safeThis->stopPlayback();
+
+                safeThis->audioProcessor.setSong(midiFile, contentHash, song, { recording, result.warp });
+                safeThis->updateUIAfterMidiLoad();
+                safeThis->showMessage("Alineación",
+                                      "La carta sigue ahora a " + recording.getFileName() + " ("
+                                      + juce::String((int) result.warp.getPoints().size()) + " puntos, "
+                                      + juce::String(result.seconds, 2) + " s).");
+            });
+        });
+    });
+}
+
+void DrumVisualizerAudioProcessorEditor::toggleMidiRecording()
+{
+    if (audioProcessor.isRecordingMidi())
+    {
+        const auto take = audioProcessor.stopMidiRecording();
+        const auto statistics = audioProcessor.getMidiRecordingStatistics();
+
+        // La ruta queda en el campo de texto: "Cargar MIDI" abre la toma como cualquier otro archivo
+        textEditor.setText(take.getFullPathName());
+        showMessage("Grabación",
+                    "Toma guardada en:\n" + take.getFullPathName() + "\n\n"
+                    + juce::String(statistics.recordedEvents) + " eventos"
+                    + (statistics.droppedEvents > 0 ? ", " + juce::String(statistics.droppedEvents) + " descartados" : juce::String())
+                    + ".\nPulsa \"Cargar MIDI\" para verla en el piano roll.");
+        return;
+    }
+
+    // Documentos/drumVisualizer/Tomas/<canción> <fecha y hora>.mid
+    const auto name = audioProcessor.hasMidiLoaded() ? audioProcessor.getLoadedFile().getFileNameWithoutExtension()
+                                                     : juce::String("Toma");
+    const auto take = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                          .getChildFile("drumVisualizer")
+                          .getChildFile("Tomas")
+                          .getChildFile(juce::File::createLegalFileName(name + " " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S")) + ".mid");
+
+    juce::String error;
+    if (!audioProcessor.startMidiRecording(take, error))
+        showMessage("Grabación", error);
+}
+
 bool DrumVisualizerAudioProcessorEditor::validateFilePath(const juce::String& path)
 {
     // Verificar que no esté vacío y no sea el texto placeholder
@@ -450,7 +1021,7 @@ bool DrumVisualizerAudioProcessorEditor::validateFilePath(const juce::String& pa
         
     // Verificar que tenga una extensión válida
     juce::String lowerPath = path.toLowerCase();
-    return lowerPath.endsWith(".mid") || lowerPath.endsWith(".midi");
+    return lowerPath.endsWith(".mid") || lowerPath.endsWith(".midi") || Setlist::isSetlistFile(juce::File::createFileWithoutCheckingPath(path));
 }
 
 void DrumVisualizerAudioProcessorEditor::showMessage(const juce::String& title, const juce::String& message)
@@ -463,7 +1034,7 @@ void DrumVisualizerAudioProcessorEditor::showMessage(const juce::String& title,
     );
 }
 
-void DrumVisualizerAudioProcessorEditor::updateUIAfterMidiLoad()
+void DrumVisualizerAudioProcessorEditor::updateUIAfterMidiLoad(const juce::Image& prerenderedOverview)
 {
     // Si el archivo MIDI tiene información de tempo, actualizar el BPM
     if (audioProcessor.hasMidiLoaded())
@@ -482,29 +1053,14 @@ void DrumVisualizerAudioProcessorEditor::updateUIAfterMidiLoad()
         
         // Alinear la primera nota a la línea de reproducción en modo STOP
         // y preparar la vista para mostrar desde la primera nota
-        auto midiFile = audioProcessor.getMidiFile();
-        double firstNoteTime = std::numeric_limits<double>::infinity();
-        for (int track = 0; track < midiFile.getNumTracks(); ++track)
-        {
-            const auto* trackPtr = midiFile.getTrack(track);
-            if (trackPtr != nullptr)
-            {
-                for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-                {
-                    const auto& event = trackPtr->getEventPointer(i)->message;
-                    if (event.isNoteOn() && event.getVelocity() > 0)
-                    {
-                        firstNoteTime = std::min(firstNoteTime, event.getTimeStamp());
-                    }
-                }
-            }
-        }
+        double firstNoteTime = audioProcessor.getFirstNoteTime();
 
-        if (firstNoteTime == std::numeric_limits<double>::infinity())
-            firstNoteTime = 0.0;
+        // Mostrar la vista general de la nueva canción
+        minimap.setSong(audioProcessor.getPreparedSong(), prerenderedOverview);
+        minimap.setVisible(true);
 
         // Colocar la posición actual en la primera nota (para que en STOP quede alineada con la línea objetivo)
-        currentTime = firstNoteTime;
+        seekTo(firstNoteTime);
         lastUpdateTime = 0;
         isPlaying = false;
 
@@ -527,6 +1083,7 @@ void DrumVisualizerAudioProcessorEditor::startPlayback()
     // Inicializar variables de tiempo
     lastUpdateTime = juce::Time::getMillisecondCounter();
     playbackStartTime = currentTime;
+    audioProcessor.setTransportPlaying(true);
     
     // Iniciar el timer con 60 FPS para animación fluida
     startTimer(16); // ~60 FPS (1000ms / 60 = 16.67ms)
@@ -539,6 +1096,13 @@ void DrumVisualizerAudioProcessorEditor::pausePlayback()
     isPlaying = false;
     playPauseButton.setButtonText("PLAY");
     stopTimer();
+
+    // Quedarse donde está el reloj de audio (puede ir hasta un frame por delante de la vista)
+    const bool followedAudio = audioProcessor.isTransportRunning();
+    audioProcessor.setTransportPlaying(false);
+
+    if (followedAudio)
+        seekTo(audioProcessor.getTransportSeconds());
     
     juce::Logger::writeToLog("Reproducción pausada en tiempo: " + juce::String(currentTime, 2) + "s");
 }
@@ -548,335 +1112,166 @@ void DrumVisualizerAudioProcessorEditor::stopPlayback()
     isPlaying = false;
     playPauseButton.setButtonText("PLAY");
     stopTimer();
+    audioProcessor.setTransportPlaying(false);
 
     // En lugar de reiniciar a 0, alinear la primera nota del clip con la línea de reproducción
     if (audioProcessor.hasMidiLoaded())
     {
-        const auto& midiFile = audioProcessor.getMidiFile();
-        double firstNoteTime = std::numeric_limits<double>::infinity();
-        for (int track = 0; track < midiFile.getNumTracks(); ++track)
-        {
-            const auto* trackPtr = midiFile.getTrack(track);
-            if (trackPtr != nullptr)
-            {
-                for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-                {
-                    const auto& event = trackPtr->getEventPointer(i)->message;
-                    if (event.isNoteOn() && event.getVelocity() > 0)
-                    {
-                        firstNoteTime = std::min(firstNoteTime, event.getTimeStamp());
-                    }
-                }
-            }
-        }
-
-        if (firstNoteTime == std::numeric_limits<double>::infinity())
-            firstNoteTime = 0.0;
-
-        currentTime = firstNoteTime;
+        seekTo(audioProcessor.getFirstNoteTime());
     }
     else
     {
-        currentTime = 0.0;
+        seekTo(0.0);
     }
 
     lastUpdateTime = 0;
-    repaint();
     
     juce::Logger::writeToLog("Reproducción detenida y posicionada al inicio del clip");
 }
 
 void DrumVisualizerAudioProcessorEditor::resetToBeginning()
 {
-    currentTime = 0.0;
+    seekTo(0.0);
     lastUpdateTime = 0;
-    repaint();
 }
 
-//==============================================================================
-// Cálculo de velocidad de scroll
-
-double DrumVisualizerAudioProcessorEditor::getScrollSpeed() const
+void DrumVisualizerAudioProcessorEditor::seekTo(double seconds)
 {
-    // La velocidad base se basa en el BPM
-    // A 120 BPM, queremos una velocidad de scroll de 1.0 (tiempo real)
-    // El speedComboBox multiplica esta velocidad base
-    double baseBeatRate = bpmVALUE / 120.0; // Normalizar contra 120 BPM
-    return baseBeatRate * speedVALUE;
+    // El procesador localiza la siguiente nota con búsqueda binaria; la vista toma
+    // el mismo tiempo en el mismo paso, así que nunca quedan desalineados
+    auto position = audioProcessor.seekTo(seconds);
+    currentTime = position.seconds;
+    minimap.setPlayheadTime(currentTime);
+    inputHits.clear();
+    inputWaveform.clear();
+    repaint();
 }
 
-//==============================================================================
-// Métodos para el piano roll estilo Synthesia
-
-void DrumVisualizerAudioProcessorEditor::drawSynthesiaPianoRoll(juce::Graphics& g, const juce::Rectangle<int>& area)
+void DrumVisualizerAudioProcessorEditor::collectInputHits()
 {
-    if (!audioProcessor.hasMidiLoaded())
-        return;
+    std::array<DrumVisualizerAudioProcessor::InputHit, 64> received;
+    int numReceived = 0;
 
-    // Obtener el rango de notas del MIDI
-    int lowestNote = audioProcessor.getLowestNote();
-    int highestNote = audioProcessor.getHighestNote();
-    
-    // Asegurar un rango mínimo visible
-    if (highestNote - lowestNote < 24) // Menos de 2 octavas
+    while ((numReceived = audioProcessor.popInputHits(received.data(), (int) received.size())) > 0)
     {
-        int center = (lowestNote + highestNote) / 2;
-        lowestNote = center - 12;
-        highestNote = center + 12;
-    }
-    
-    // Clamp to MIDI range
-    lowestNote = std::max(0, lowestNote - 2);
-    highestNote = std::min(127, highestNote + 2);
+        for (int i = 0; i < numReceived; ++i)
+        {
+            auto& hit = received[(size_t) i];
+
+            // Calibrando: el golpe es de la pieza que se está tocando, sea cual sea la clasificación
+            if (trainingLane >= 0)
+            {
+                hitTrainer.add(trainingLane, hit.features);
+                hit.lane = trainingLane;
+                hit.noteNumber = HitClassifier::getNoteNumber(trainingLane);
+            }
+            else
+            {
+                matchInputHit(hit);
+            }
 
-    // Dividir el área: teclas del piano a la izquierda, notas a la derecha
-    const int keyWidth = 80;
-    auto workingArea = area; // Copia mutable del área
-    auto keyArea = workingArea.removeFromLeft(keyWidth);
-    auto noteArea = workingArea;
+            if ((int) inputHits.size() == maximumInputHits)
+                inputHits.erase(inputHits.begin());
 
-    // Calcular posición de la línea objetivo
-    targetLineX = keyArea.getRight() + static_cast<int>(noteArea.getWidth() * 0.25f);
+            inputHits.push_back(hit);
+        }
+    }
 
-    // Dibujar las teclas del piano
-    drawPianoKeys(g, keyArea, lowestNote, highestNote);
-    
-    // Dibujar fondo del área de notas
-    g.setColour(juce::Colour(0xff1a1a1a));
-    g.fillRect(noteArea);
-    
-    // Dibujar escala de tiempo
-    drawTimeScale(g, noteArea);
-    
-    // Dibujar las notas MIDI animadas
-    drawAnimatedMidiNotes(g, noteArea, lowestNote, highestNote);
-    
-    // Dibujar línea objetivo (donde "caen" las notas)
-    drawTargetLine(g, noteArea);
+    // Solo se dibujan durante inputHitSeconds tras la línea objetivo
+    inputHits.erase(std::remove_if(inputHits.begin(), inputHits.end(), [this](const auto& hit)
+    {
+        return hit.time < currentTime - inputHitSeconds;
+    }), inputHits.end());
 }
 
-void DrumVisualizerAudioProcessorEditor::drawPianoKeys(juce::Graphics& g, const juce::Rectangle<int>& keyArea, int lowestNote, int highestNote)
+void DrumVisualizerAudioProcessorEditor::collectInputWaveform()
 {
-    const int numNotes = highestNote - lowestNote + 1;
-    const float keyHeight = (float)keyArea.getHeight() / (float)numNotes;
-    
-    for (int i = 0; i < numNotes; ++i)
-    {
-        int noteNumber = highestNote - i; // Dibujar desde arriba hacia abajo
-        float y = (float)keyArea.getY() + (float)i * keyHeight;
-        juce::Rectangle<float> keyRect((float)keyArea.getX(), y, (float)keyArea.getWidth(), keyHeight);
-        
-        // Determinar si es tecla blanca o negra
-        int noteInOctave = noteNumber % 12;
-        bool isBlackKey = (noteInOctave == 1 || noteInOctave == 3 || noteInOctave == 6 || 
-                          noteInOctave == 8 || noteInOctave == 10);
-        
-        // Color de la tecla
-        if (isBlackKey)
-        {
-            g.setColour(juce::Colour(0xff1a1a1a));
-        }
-        else
-        {
-            g.setColour(juce::Colours::white);
-        }
-        
-        g.fillRect(keyRect);
-        
-        // Borde de la tecla
-        g.setColour(juce::Colours::grey);
-        g.drawRect(keyRect, 1.0f);
-        
-        // Dibujar nombre de la nota para teclas blancas o notas C
-        if (!isBlackKey || noteInOctave == 0)
-        {
-            g.setColour(isBlackKey ? juce::Colours::white : juce::Colours::black);
-            g.setFont(juce::Font(juce::FontOptions(10.0f)));
-            g.drawText(getNoteNameFromNumber(noteNumber), 
-                      keyRect.reduced(2), 
-                      juce::Justification::centredLeft, 
-                      true);
-        }
-    }
+    std::array<InputWaveform::Peak, 512> received;
+    int numReceived = 0;
+
+    while ((numReceived = audioProcessor.popInputWaveform(received.data(), (int) received.size())) > 0)
+        for (int i = 0; i < numReceived; ++i)
+            inputWaveform.add(received[(size_t) i]);
 }
 
-void DrumVisualizerAudioProcessorEditor::drawAnimatedMidiNotes(juce::Graphics& g, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote)
+void DrumVisualizerAudioProcessorEditor::matchInputHit(DrumVisualizerAudioProcessor::InputHit& hit) const
 {
-    if (!audioProcessor.hasMidiLoaded())
-        return;
+    // La nota más cercana del mismo carril (p. ej. el ride de la partitura para un golpe de platos)
+    double bestDistance = inputHitMatchSeconds;
 
-    const auto& midiFile = audioProcessor.getMidiFile();
-    
-    // Ampliar significativamente la ventana de tiempo visible
-    double windowStart = currentTime - 1.0; // Mostrar notas 1s antes del tiempo actual
-    double windowEnd = currentTime + 12.0; // Ventana de scroll mucho más amplia (12 segundos adelante)
-    
-    // Si no estamos reproduciendo, mostrar solo las notas a partir de currentTime (no mostrar notas a la izquierda de la línea de reproducción)
-    if (!isPlaying)
+    for (const auto& note : audioProcessor.getNotes(hit.time - inputHitMatchSeconds, hit.time + inputHitMatchSeconds,
+                                                    audioProcessor.getNoteFilter()))
     {
-        // Evitar mostrar notas anteriores a la posición actual: en pausa la vista se congela en currentTime
-        windowStart = currentTime;
-        // Mostrar al menos 12 segundos hacia delante o hasta el final del clip
-        double remainingLength = std::max(12.0, std::max(0.0, audioProcessor.getLengthInSeconds() - currentTime));
-        windowEnd = currentTime + remainingLength;
-    }
+        const double distance = std::abs(note.time - hit.time);
 
-    // Iterar sobre todas las pistas
-    for (int track = 0; track < midiFile.getNumTracks(); ++track)
-    {
-        const auto* trackPtr = midiFile.getTrack(track);
-        if (trackPtr != nullptr)
+        if (HitClassifier::getLane(note.noteNumber) == hit.lane && distance <= bestDistance)
         {
-            // Iterar sobre todos los eventos de la pista
-            for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-            {
-                const auto& eventHolder = *trackPtr->getEventPointer(i);
-                const auto& event = eventHolder.message;
-                
-                // Solo dibujar eventos Note On con velocidad > 0
-                if (event.isNoteOn() && event.getVelocity() > 0)
-                {
-                    int noteNumber = event.getNoteNumber();
-                    double noteTime = event.getTimeStamp();
-                    
-                    // Solo dibujar notas que están en la ventana de tiempo visible
-                    if (noteTime >= windowStart && noteTime <= windowEnd &&
-                        noteNumber >= lowestNote && noteNumber <= highestNote)
-                    {
-                        float velocity = (float)event.getVelocity() / 127.0f;
-                        
-                        // Calcular posición X animada
-                        float x = (float)timeToAnimatedX(noteTime, noteArea, windowEnd - currentTime);
-                        float y = (float)noteToY(noteNumber, lowestNote, highestNote, noteArea);
-                        
-                        // Asegurar que no se muestre ninguna nota a la izquierda de la línea objetivo
-                        if (x < targetLineX)
-                            continue;
-                        
-                        // Solo dibujar si la nota está dentro del área visible
-                        if (x >= noteArea.getX() - 25 && x <= noteArea.getRight() + 25)
-                        {
-                            // Tamaño de la nota
-                            float noteWidth = 20.0f; // Más ancho para mejor visibilidad
-                            float height = (float)noteArea.getHeight() / (float)(highestNote - lowestNote + 1) * 0.8f;
-                            
-                            // Color basado en la velocidad con efecto de brillo
-                            juce::Colour baseColor = juce::Colour::fromHSV(0.6f, 0.9f, 0.4f + velocity * 0.6f, 1.0f);
-                            
-                            // Efecto de resplandor para notas que están cerca de la línea objetivo
-                            float distanceToTarget = std::abs(x - targetLineX);
-                            float maxGlowDistance = 50.0f;
-                            if (distanceToTarget < maxGlowDistance)
-                            {
-                                float glowIntensity = 1.0f - (distanceToTarget / maxGlowDistance);
-                                baseColor = baseColor.brighter(glowIntensity * 0.3f);
-                            }
-                            
-                            // Dibujar nota con efecto de resplandor
-                            g.setColour(baseColor.withAlpha(0.3f));
-                            g.fillRoundedRectangle(x - 2, y - 2, noteWidth + 4, height + 4, 4.0f);
-                            
-                            g.setColour(baseColor);
-                            g.fillRoundedRectangle(x, y, noteWidth, height, 3.0f);
-                            
-                            // Borde brillante
-                            g.setColour(baseColor.brighter(0.4f));
-                            g.drawRoundedRectangle(x, y, noteWidth, height, 3.0f, 2.0f);
-                        }
-                    }
-                }
-            }
+            bestDistance = distance;
+            hit.noteNumber = note.noteNumber;
+            hit.matched = true;
         }
     }
 }
 
-void DrumVisualizerAudioProcessorEditor::drawTargetLine(juce::Graphics& g, const juce::Rectangle<int>& area)
+void DrumVisualizerAudioProcessorEditor::addCalibrationMenu(juce::PopupMenu& menu, int firstId)
 {
-    // Dibujar línea objetivo vertical brillante
-    int lineX = targetLineX;
-    
-    // Efecto de resplandor
-    g.setColour(juce::Colours::white.withAlpha(0.3f));
-    g.fillRect(lineX - 3, area.getY(), 7, area.getHeight());
-    
-    g.setColour(juce::Colours::white.withAlpha(0.6f));
-    g.fillRect(lineX - 2, area.getY(), 5, area.getHeight());
-    
-    // Línea principal
-    g.setColour(juce::Colours::white);
-    g.fillRect(lineX - 1, area.getY(), 3, area.getHeight());
-}
+    juce::PopupMenu calibration;
 
-void DrumVisualizerAudioProcessorEditor::drawTimeScale(juce::Graphics& g, const juce::Rectangle<int>& area)
-{
-    // Dibujar líneas de tiempo futuras que se acercan
-    g.setColour(juce::Colour(0xff333333));
-    
-    double scrollSpeed = getScrollSpeed();
-    double beatsPerSecond = (bpmVALUE / 60.0) * scrollSpeed;
-    double beatInterval = 1.0 / beatsPerSecond; // Segundos por beat
-    
-    // Usar ventana ampliada para mostrar más beats
-    double windowWidth = isPlaying ? 12.0 : std::max(12.0, audioProcessor.getLengthInSeconds());
-    
-    // Dibujar líneas de compás que se mueven
-    for (double futureTime = currentTime; futureTime <= currentTime + windowWidth; futureTime += beatInterval)
-    {
-        float x = (float)timeToAnimatedX(futureTime, area, windowWidth);
-        if (x >= area.getX() && x <= area.getRight())
-        {
-            g.drawVerticalLine((int)x, (float)area.getY(), (float)area.getBottom());
-        }
-    }
-}
+    for (int lane = 0; lane < HitClassifier::numLanes; ++lane)
+        calibration.addItem(firstId + lane, "Tocar " + HitClassifier::getLaneName(lane).toLowerCase()
+                                                + " (" + juce::String(hitTrainer.getNumExamples(lane)) + " golpes)",
+                            true, trainingLane == lane);
 
-//==============================================================================
-// Funciones de conversión para animación
+    calibration.addSeparator();
+    calibration.addItem(firstId + HitClassifier::numLanes, "Guardar calibración", trainingLane >= 0);
+    calibration.addItem(firstId + HitClassifier::numLanes + 1, "Calibración por defecto");
 
-double DrumVisualizerAudioProcessorEditor::timeToAnimatedX(double noteTime, const juce::Rectangle<int>& area) const
-{
-    // Versión original para compatibility
-    return timeToAnimatedX(noteTime, area, noteScrollWidth);
+    menu.addSubMenu("Calibrar golpes", calibration);
 }
 
-double DrumVisualizerAudioProcessorEditor::timeToAnimatedX(double noteTime, const juce::Rectangle<int>& area, double windowWidth) const
+void DrumVisualizerAudioProcessorEditor::handleCalibrationMenu(int itemIndex)
 {
-    if (!isPlaying)
+    if (itemIndex < HitClassifier::numLanes)
     {
-        // Vista en STOP: usar la misma lógica de animación pero centrada en currentTime
-        // Esto permite alinear la primera nota con la línea objetivo cuando currentTime fue ajustado
-        double timeUntilNote = noteTime - currentTime;
-        // Proteger división por cero
-        double effectiveWindow = (windowWidth <= 0.0) ? noteScrollWidth : windowWidth;
-        double scrollPixelsPerSecond = (double)area.getWidth() / effectiveWindow;
-        return targetLineX + (timeUntilNote * scrollPixelsPerSecond);
+        // Hace falta la detección para recibir los golpes de ejemplo
+        trainingLane = itemIndex;
+        inputHitsVALUE = true;
+        return;
+    }
+
+    if (itemIndex == HitClassifier::numLanes)
+    {
+        audioProcessor.setHitClassifier(hitTrainer.build(*audioProcessor.getHitClassifier()));
+        juce::Logger::writeToLog("Calibración de golpes guardada");
     }
     else
     {
-        // Vista animada: las notas se mueven de derecha a izquierda
-        // La línea objetivo está a targetLineX
-        // Las notas futuras aparecen desde la derecha
-        
-        double timeUntilNote = noteTime - currentTime;
-        double scrollPixelsPerSecond = (double)area.getWidth() / windowWidth;
-        
-        // Posición X: línea objetivo + (tiempo hasta nota * pixels por segundo)
-        return targetLineX + (timeUntilNote * scrollPixelsPerSecond);
+        audioProcessor.setHitClassifier(HitClassifier::createDefault());
     }
+
+    hitTrainer = {};
+    trainingLane = -1;
 }
 
-int DrumVisualizerAudioProcessorEditor::noteToY(int noteNumber, int lowestNote, int highestNote, const juce::Rectangle<int>& area) const
+//==============================================================================
+// Cálculo de velocidad de scroll
+
+double DrumVisualizerAudioProcessorEditor::getScrollSpeed() const
 {
-    int numNotes = highestNote - lowestNote + 1;
-    int noteIndex = highestNote - noteNumber; // Invertir para que las notas altas estén arriba
-    float noteHeightLocal = (float)area.getHeight() / (float)numNotes;  // Renombrar para evitar conflicto
-    return area.getY() + (int)(noteIndex * noteHeightLocal + noteHeightLocal * 0.1f); // Pequeño offset para centrar
+    // A 120 BPM la velocidad es 1.0 (tiempo real); el speedComboBox la multiplica
+    return PianoRollRenderer::getScrollSpeed(bpmVALUE, speedVALUE);
 }
 
-juce::String DrumVisualizerAudioProcessorEditor::getNoteNameFromNumber(int noteNumber) const
+PianoRollRenderer::ViewState DrumVisualizerAudioProcessorEditor::getViewState() const
 {
-    const char* noteNames[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
-    int octave = (noteNumber / 12) - 1;
-    int noteIndex = noteNumber % 12;
-    return juce::String(noteNames[noteIndex]) + juce::String(octave);
+    PianoRollRenderer::ViewState state;
+    state.currentTime = currentTime;
+    state.isPlaying = isPlaying;
+    state.bpm = bpmVALUE;
+    state.speed = speedVALUE;
+    state.timeFigure = timefigVALUE;
+    state.filter = audioProcessor.getNoteFilter();
+    state.inputHits = &inputHits;
+    state.inputWaveform = inputWaveformVALUE ? &inputWaveform : nullptr;
+    return state;
 }
@@ -10,6 +10,9 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "PianoRollRenderer.h"
+#include "MinimapComponent.h"
+#include "MidiLibrary.h"
 
 //==============================================================================
 /**
@@ -17,6 +20,7 @@
 class DrumVisualizerAudioProcessorEditor : public juce::AudioProcessorEditor, 
                                             public juce::TextEditor::Listener,
                                             public juce::ComboBox::Listener,
+                                            public juce::ChangeListener,
                                             public juce::Timer
 {
 public:
@@ -30,17 +34,25 @@ public:
     // Listener overrides para el patrón observer
     void textEditorTextChanged (juce::TextEditor& editor) override;
     void comboBoxChanged (juce::ComboBox* comboBoxThatHasChanged) override;
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
 
     // Variables públicas para acceso desde otras clases
     int bpmVALUE = 120;
     float speedVALUE = 1.0f;
     juce::String timefigVALUE = "1/4";
+    bool metronomeVALUE = false;
+    bool drumsVALUE = false;
+    bool inputHitsVALUE = false;
+    bool inputWaveformVALUE = false;
 
 private:
     // Widgets del primer contenedor (topFrame)
     juce::TextEditor textEditor; // Entrada de texto
     juce::TextButton exploreButton { "Explorar" }; // Botón "Explorar"
+    juce::TextButton libraryButton { "Biblioteca" }; // Botón "Biblioteca" (buscar o escanear carpeta)
     juce::TextButton loadMidiButton { "Cargar MIDI" }; // Botón "Cargar MIDI"
+    juce::TextButton filterButton { "Filtros" }; // Pistas, canales y notas visibles
+    juce::TextButton soundButton { "Sonido" }; // Metrónomo, batería y kit (suenan en la salida del plugin)
 
     // Widgets del segundo contenedor (middleFrame)
     juce::Label bpmLabel; // Label para "BPM SET"
@@ -49,16 +61,20 @@ private:
     juce::ComboBox speedComboBox; // Lista desplegable para Speed
     juce::TextButton playPauseButton { "PLAY/PAUSE" }; // Botón Play/Pause
     juce::TextButton stopButton { "STOP" }; // Botón Stop
+    juce::TextButton previousSongButton { "<< ANTERIOR" }; // Canción anterior del setlist
+    juce::TextButton nextSongButton { "SIGUIENTE >>" }; // Canción siguiente del setlist
     juce::Label timeFigLabel; // Label para "TIME FIGURE"
     juce::ComboBox timeFigComboBox; // Lista desplegable para Time Fig
 
+    // Vista general de la canción sobre el piano roll (clic/arrastre para buscar)
+    MinimapComponent minimap;
+    static constexpr int minimapHeight = 40;
+
     // Variables para el piano roll animado (estilo Synthesia)
     juce::Rectangle<int> pianoRollArea;
     double currentTime = 0.0; // Tiempo actual de reproducción
     bool isPlaying = false;
     double pixelsPerSecond = 200.0; // Velocidad de scroll base
-    int targetLineX = 0; // Posición X de la línea objetivo (donde "caen" las notas)
-    double noteScrollWidth = 12.0; // Ancho en segundos de la ventana de scroll (ampliado para ver más notas)
     
     // Variables de control de tiempo
     juce::int64 lastUpdateTime = 0;
@@ -69,31 +85,69 @@ private:
     void updateSpeedValue();
     void updateTimeFigValue();
 
+    // Ajustes guardados en el procesador (sesión restaurada o editor reabierto)
+    void applyViewSettings(const DrumVisualizerAudioProcessor::ViewSettings& settings);
+    void storeViewSettings();
+    void showProcessorSong();
+
     // Métodos para manejo de archivos MIDI
     void openFileChooser();
     void loadMidiFile();
     bool validateFilePath(const juce::String& path);
     void showMessage(const juce::String& title, const juce::String& message);
-    void updateUIAfterMidiLoad();
-
-    // Métodos para el piano roll estilo Synthesia
-    void drawSynthesiaPianoRoll(juce::Graphics& g, const juce::Rectangle<int>& area);
-    void drawPianoKeys(juce::Graphics& g, const juce::Rectangle<int>& keyArea, int lowestNote, int highestNote);
-    void drawAnimatedMidiNotes(juce::Graphics& g, const juce::Rectangle<int>& noteArea, int lowestNote, int highestNote);
-    void drawTargetLine(juce::Graphics& g, const juce::Rectangle<int>& area);
-    void drawTimeScale(juce::Graphics& g, const juce::Rectangle<int>& area);
-    
-    // Funciones de conversión para animación
-    double timeToAnimatedX(double noteTime, const juce::Rectangle<int>& area) const;
-    double timeToAnimatedX(double noteTime, const juce::Rectangle<int>& area, double windowWidth) const;
-    int noteToY(int noteNumber, int lowestNote, int highestNote, const juce::Rectangle<int>& area) const;
-    juce::String getNoteNameFromNumber(int noteNumber) const;
+    void updateUIAfterMidiLoad(const juce::Image& prerenderedOverview = {});
+
+    // Setlist: cargar una lista y moverse por ella (las vecinas se precargan en segundo plano)
+    void loadSetlist(const juce::File& setlistFile);
+    void selectSetlistSong(int index);
+    void updateSetlistButtons();
+
+    // Biblioteca: si el texto es una carpeta la escanea, si no busca en el índice
+    void showLibrary();
+    void scanLibraryFolder(const juce::File& folder);
+    juce::SharedResourcePointer<MidiLibrary> midiLibrary;
+
+    // Menú de filtros: ocultar pistas, canales o notas sin recargar la canción
+    void showFilterMenu();
+
+    // Menú de sonido: activar metrónomo y batería, elegir el kit de muestras
+    void showSoundMenu();
+    void chooseDrumKitFolder();
+
+    // Ajustar la carta cargada al tempo de una grabación (en segundo plano)
+    void chooseRecordingToAlign();
+    bool aligningToRecording = false;
+
+    // Grabar lo que se toca en un .mid (en Documentos) y dejar su ruta lista para cargarla
+    void toggleMidiRecording();
+
+    // Golpes de la entrada de audio: se recogen en cada frame y se ven tras la línea objetivo
+    void collectInputHits();
+    void matchInputHit(DrumVisualizerAudioProcessor::InputHit& hit) const;
+    std::vector<DrumVisualizerAudioProcessor::InputHit> inputHits;
+    static constexpr int maximumInputHits = 256;
+    static constexpr double inputHitSeconds = 1.0;
+    static constexpr double inputHitMatchSeconds = 0.1;    // Distancia máxima a la nota de la partitura
+
+    // Carril de forma de onda: los picos de la entrada se recogen en cada frame
+    void collectInputWaveform();
+    WaveformMipmap inputWaveform;
+
+    // Calibración del clasificador: los golpes recibidos cuentan como ejemplos de trainingLane
+    void addCalibrationMenu(juce::PopupMenu& menu, int firstId);
+    void handleCalibrationMenu(int itemIndex);
+    HitClassifier::Trainer hitTrainer;
+    int trainingLane = -1;
+
+    // Estado de la vista que se pasa al renderer del piano roll
+    PianoRollRenderer::ViewState getViewState() const;
     
     // Control de reproducción
     void startPlayback();
     void pausePlayback();
     void stopPlayback();
     void resetToBeginning();
+    void seekTo(double seconds);
     
     // Cálculo de velocidad de scroll
     double getScrollSpeed() const;
@@ -106,5 +160,8 @@ private:
     // access the processor object that created it.
     DrumVisualizerAudioProcessor& audioProcessor;
 
+    // Dibuja el piano roll a partir del estado de la vista
+    PianoRollRenderer pianoRollRenderer;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumVisualizerAudioProcessorEditor)
 };
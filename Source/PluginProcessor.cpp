@@ -8,6 +8,9 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "CommandLineTools.h"
+#include "SongCacheFile.h"
+#include "PianoRollRenderer.h"
 
 //==============================================================================
 DrumVisualizerAudioProcessor::DrumVisualizerAudioProcessor()
@@ -22,10 +25,19 @@ DrumVisualizerAudioProcessor::DrumVisualizerAudioProcessor()
                        )
 #endif
 {
+   #if JucePlugin_Build_Standalone
+    // La app Standalone acepta modos sin interfaz (p. ej. --benchmark)
+    if (wrapperType == wrapperType_Standalone)
+        CommandLineTools::launchIfRequested();
+   #endif
 }
 
 DrumVisualizerAudioProcessor::~DrumVisualizerAudioProcessor()
 {
+    // Cancelar los trabajos del editor (el destructor del pool les pide salir y los espera)
+    // y esperar a la restauración en curso antes de destruir lo que usan
+    backgroundPool.reset();
+    restorePool.reset();
 }
 
 //==============================================================================
@@ -95,6 +107,24 @@ void DrumVisualizerAudioProcessor::prepareToPlay (double sampleRate, int samples
 {
     // Guardamos el sample rate para uso en funciones MIDI
     this->sampleRate = sampleRate;
+
+    // Los clics se calculan aquí para la frecuencia de muestreo del host
+    metronome.prepare(sampleRate, samplesPerBlock);
+    drumSampler.prepare(sampleRate);
+    onsetDetector.prepare(sampleRate);
+    inputWaveform.prepare(sampleRate);
+
+    // El kit se crea (o se vuelve a convertir) para la frecuencia del host
+    auto kit = drumKit.get();
+    if (kit == nullptr || kit->getSampleRate() != sampleRate)
+    {
+        juce::String error;
+        if (!loadDrumKit(getDrumKitFolder(), error))
+        {
+            juce::Logger::writeToLog("Error: " + error + " - se usa el kit integrado");
+            loadDrumKit({}, error);
+        }
+    }
 }
 
 void DrumVisualizerAudioProcessor::releaseResources()
@@ -131,6 +161,8 @@ bool DrumVisualizerAudioProcessor::isBusesLayoutSupported (const BusesLayout& la
 
 void DrumVisualizerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    RealtimeAudit::Scope auditScope("processBlock", *logger);
+    const RealtimeReleasePool::AudioBlock audioBlock(releasePool);
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -144,18 +176,210 @@ void DrumVisualizerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffe
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    lastBlockTimeMs.store(juce::Time::getMillisecondCounter());
+
+    // Una búsqueda desde el editor o el minimap reinicia el reloj en la nueva posición
+    const int seeks = seekRequests.load(std::memory_order_acquire);
+    if (seeks != seekRequestsSeen)
+    {
+        seekRequestsSeen = seeks;
+        timeline.anchorSeconds = requestedSeekSeconds.load();
+        timeline.firstSample = 0;
+        metronome.reset();
+        drumSampler.reset();
+        onsetDetector.reset();
+        inputWaveform.reset();
+        drumCursorValid = false;
+    }
+
+    // También en pausa: así el grabador recibe el último bloque al parar
+    midiRecorder.beginBlock();
+
+    // Las voces apuntan a las muestras del kit: al cambiarlo se apagan
+    const int kitGeneration = drumKitGeneration.load();
+    if (kitGeneration != drumKitGenerationSeen)
+    {
+        drumKitGenerationSeen = kitGeneration;
+        drumSampler.setKitGeneration(kitGeneration);
+    }
+
+    // Punteros válidos hasta el final del bloque: lo sustituido se libera después, en el hilo de mensajes
+    const auto* kit = drumsEnabled.load() ? drumKit.getForAudio() : nullptr;
+
+    if (!transportPlaying.load())
+    {
+        // En pausa solo terminan de sonar los golpes que ya empezaron
+        drumSampler.render(buffer, 0, buffer.getNumSamples());
+        return;
+    }
+
+    const int numSamples = buffer.getNumSamples();
+    const double secondsPerSample = transportRate.load() / sampleRate;
+
+    // Cambio de BPM o velocidad: nueva ancla en la posición actual
+    if (secondsPerSample != timeline.secondsPerSample)
     {
-        auto* channelData = buffer.getWritePointer (channel);
+        timeline.anchorSeconds += (double) timeline.firstSample * timeline.secondsPerSample;
+        timeline.firstSample = 0;
+        timeline.secondsPerSample = secondsPerSample;
+    }
+
+    // Solo se graba con la canción en marcha: los tiempos son los de la canción
+    if (midiRecorder.isRecording())
+        recordMidiInput(midiMessages);
+
+    // La entrada aún no lleva el metrónomo ni la batería mezclados
+    if (inputHitsEnabled.load())
+        detectInputHits(buffer, totalNumInputChannels);
+
+    if (inputWaveformEnabled.load())
+        inputWaveform.process(buffer, totalNumInputChannels, numSamples, timeline);
 
-        // ..do something to the data...
+    const bool metronomeOn = metronomeEnabled.load();
+    const int generation = songGeneration.load(std::memory_order_acquire);
+    const auto* song = metronomeOn || kit != nullptr ? preparedSong.getForAudio() : nullptr;
+
+    if (song != nullptr && metronomeOn)
+        metronome.render(buffer, 0, numSamples, song->getBeatGrid(), timeline, metronomeDivision.load());
+
+    if (song != nullptr && kit != nullptr)
+    {
+        renderDrums(buffer, *song, generation, *kit);
+    }
+    else
+    {
+        // Al volver a activar la batería el cursor se recoloca (no suenan de golpe las notas saltadas)
+        drumSampler.render(buffer, 0, numSamples);
+        drumCursorValid = false;
     }
+
+    timeline.firstSample += numSamples;
+    transportSeconds.store(timeline.getSeconds(timeline.firstSample));
+}
+
+void DrumVisualizerAudioProcessor::renderDrums(juce::AudioBuffer<float>& buffer, const PreparedSong& song, int generation, const DrumKit& kit)
+{
+    const int numSamples = buffer.getNumSamples();
+    const double startSeconds = timeline.getSeconds(timeline.firstSample);
+    const double endSeconds = timeline.getSeconds(timeline.firstSample + numSamples);
+
+    const auto& notes = song.getNotes();
+
+    // En canciones paginadas el hilo de lectura va por delante aunque el editor esté cerrado
+    notes.prefetch(startSeconds);
+
+    // Tras buscar o cambiar de canción, el cursor se recoloca con búsqueda binaria.
+    // Solo con bloques ya en memoria: si el de esta posición sigue en disco, el bloque
+    // suena sin los golpes de la canción y se cuenta como corte. La generación se lee antes
+    // que la canción, así que también se compara la dirección (una canción nueva con la
+    // generación anterior); la generación cubre una canción nueva en la dirección de otra ya liberada.
+    if (!drumCursorValid || drumSongGeneration != generation || drumSong != &song)
+    {
+        if (!notes.findFirstResidentAtOrAfter(startSeconds, drumNoteIndex))
+        {
+            noteUnderruns.fetch_add(1, std::memory_order_relaxed);
+            drumSampler.render(buffer, 0, numSamples);
+            return;
+        }
+
+        drumSong = &song;
+        drumSongGeneration = generation;
+        drumCursorValid = true;
+    }
+
+    // Mezclar hasta cada golpe, empezarlo y seguir desde ahí
+    int rendered = 0;
+
+    const bool resident = notes.visitResident(drumNoteIndex, [&](const SongNote& note)
+    {
+        if (note.time >= endSeconds)
+            return false;
+
+        const int offset = juce::jmax(rendered, timeline.getOffsetInBlock(note.time, numSamples));
+        drumSampler.render(buffer, rendered, offset - rendered);
+        drumSampler.noteOn(kit, note.noteNumber, note.velocity);
+
+        rendered = offset;
+        ++drumNoteIndex;
+        return true;
+    });
+
+    // Los golpes del bloque que faltaba se saltan: el cursor se recoloca en el siguiente
+    if (!resident)
+    {
+        noteUnderruns.fetch_add(1, std::memory_order_relaxed);
+        drumCursorValid = false;
+    }
+
+    drumSampler.render(buffer, rendered, numSamples - rendered);
+}
+
+void DrumVisualizerAudioProcessor::detectInputHits(const juce::AudioBuffer<float>& buffer, int numInputChannels)
+{
+    const int numOnsets = onsetDetector.process(buffer, numInputChannels, buffer.getNumSamples());
+    if (numOnsets == 0)
+        return;
+
+    // Si el editor no vacía la cola (cerrado), los golpes que no caben se descartan
+    const auto* classifier = hitClassifier.getForAudio();
+    int index = 0;
+
+    inputHitFifo.write(numOnsets).forEach([&](int slot)
+    {
+        const auto& onset = onsetDetector.getOnset(index++);
+
+        auto& hit = inputHitQueue[(size_t) slot];
+        hit.time = timeline.getSeconds(timeline.firstSample + onset.offset);
+        hit.lane = classifier->classify(onset.features);
+        hit.noteNumber = HitClassifier::getNoteNumber(hit.lane);
+        hit.strength = onset.strength;
+        hit.features = onset.features;
+    });
+
+    // En la toma entran todos, aunque la cola del editor esté llena
+    if (midiRecorder.isRecording())
+    {
+        for (int i = 0; i < numOnsets; ++i)
+        {
+            const auto& onset = onsetDetector.getOnset(i);
+            midiRecorder.addHit(timeline.getSeconds(timeline.firstSample + onset.offset),
+                                HitClassifier::getNoteNumber(classifier->classify(onset.features)),
+                                onset.strength);
+        }
+    }
+}
+
+void DrumVisualizerAudioProcessor::recordMidiInput(const juce::MidiBuffer& midiMessages)
+{
+    for (const auto metadata : midiMessages)
+        midiRecorder.add(timeline.getSeconds(timeline.firstSample + metadata.samplePosition),
+                         metadata.data, metadata.numBytes);
+}
+
+int DrumVisualizerAudioProcessor::popInputHits(InputHit* destination, int maximum)
+{
+    int numHits = 0;
+
+    inputHitFifo.read(maximum).forEach([&](int slot)
+    {
+        destination[numHits++] = inputHitQueue[(size_t) slot];
+    });
+
+    return numHits;
+}
+
+HitClassifier::Ptr DrumVisualizerAudioProcessor::getHitClassifier() const
+{
+    return hitClassifier.get();
+}
+
+void DrumVisualizerAudioProcessor::setHitClassifier(HitClassifier::Ptr newClassifier)
+{
+    if (newClassifier == nullptr)
+        return;
+
+    // El anterior se libera en el hilo de mensajes cuando ningún bloque de audio lo usa
+    releasePool.retire(hitClassifier.exchange(std::move(newClassifier)));
 }
 
 //==============================================================================
@@ -172,15 +396,273 @@ juce::AudioProcessorEditor* DrumVisualizerAudioProcessor::createEditor()
 //==============================================================================
 void DrumVisualizerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Si la sesión anterior aún se está restaurando, devolverla tal cual para no perderla
+    {
+        const juce::ScopedLock sl(stateLock);
+        if (!restoringState.isEmpty())
+        {
+            destData = restoringState;
+            return;
+        }
+    }
+
+    const auto settings = getViewSettings();
+
+    juce::ValueTree state("DrumVisualizerState");
+    state.setProperty("version", 1, nullptr);
+    state.setProperty("bpm", settings.bpm, nullptr);
+    state.setProperty("speed", settings.speed, nullptr);
+    state.setProperty("timeFigure", settings.timeFigure, nullptr);
+    state.setProperty("metronome", settings.metronome, nullptr);
+    state.setProperty("position", getPlaybackPosition().seconds, nullptr);
+    state.setProperty("drums", settings.drums, nullptr);
+    state.setProperty("inputHits", settings.inputHits, nullptr);
+    state.setProperty("inputWaveform", settings.inputWaveform, nullptr);
+    state.setProperty("hitClassifier", getHitClassifier()->toString(), nullptr);
+    state.setProperty("filter", getNoteFilter().toString(), nullptr);
+    state.setProperty("drumKit", getDrumKitFolder().getFullPathName(), nullptr);
+
+    // Canción, archivo y hash se leen juntos: setSong los cambia bajo el mismo lock
+    PreparedSong::Ptr song;
+    juce::File file;
+    juce::uint64 contentHash = 0;
+    SongAlignment alignment;
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        song = getPreparedSong();
+        file = loadedMidiFile;
+        contentHash = loadedContentHash;
+        alignment = songAlignment;
+    }
+
+    if (song != nullptr)
+    {
+        state.setProperty("file", file.getFullPathName(), nullptr);
+        state.setProperty("hash", juce::String::toHexString((juce::int64) contentHash), nullptr);
+
+        // Canción alineada: se guarda la correspondencia y se vuelve a aplicar al restaurar
+        if (!alignment.warp.isEmpty())
+        {
+            state.setProperty("recording", alignment.recording.getFullPathName(), nullptr);
+            state.setProperty("warp", alignment.warp.toString(), nullptr);
+        }
+
+        // Canciones pequeñas: incrustar las notas preprocesadas para reabrir sin leer el SMF
+        juce::MemoryBlock embeddedSong;
+        if (contentHash != 0
+            && alignment.warp.isEmpty()
+            && !song->getNotes().isPaged()
+            && song->getMemoryBytes() <= maximumEmbeddedSongBytes
+            && SongCacheFile::saveToMemory(file, contentHash, *song, embeddedSong))
+        {
+            state.setProperty("song", embeddedSong, nullptr);
+        }
+    }
+
+    juce::MemoryOutputStream out(destData, false);
+    state.writeToStream(out);
 }
 
 void DrumVisualizerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    const auto state = juce::ValueTree::readFromData(data, (size_t) sizeInBytes);
+    if (!state.hasType("DrumVisualizerState"))
+        return;
+
+    // Los ajustes se aplican ya; son solo unos pocos valores
+    ViewSettings settings;
+    settings.bpm = state.getProperty("bpm", settings.bpm);
+    settings.speed = state.getProperty("speed", settings.speed);
+    settings.timeFigure = state.getProperty("timeFigure", settings.timeFigure);
+    settings.metronome = state.getProperty("metronome", settings.metronome);
+    settings.drums = state.getProperty("drums", settings.drums);
+    settings.inputHits = state.getProperty("inputHits", settings.inputHits);
+    settings.inputWaveform = state.getProperty("inputWaveform", settings.inputWaveform);
+    setViewSettings(settings);
+    setNoteFilter(NoteFilter::fromString(state.getProperty("filter").toString()));
+    setHitClassifier(HitClassifier::fromString(state.getProperty("hitClassifier").toString()));
+
+    // Kit de muestras: se lee en restorePool, como la canción; si el audio aún no está preparado,
+    // prepareToPlay lo carga. La carpeta se apunta ya para que prepareToPlay y el estado guardado la usen.
+    const juce::String kitPath = state.getProperty("drumKit");
+    const auto kitFolder = juce::File::isAbsolutePath(kitPath) ? juce::File(kitPath) : juce::File();
+    auto currentKit = drumKit.get();
+
+    // Una restauración anterior aún en marcha queda superada aunque el kit ya sea este
+    const int request = ++drumKitRequests;
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        drumKitFolder = kitFolder;
+    }
+
+    if (currentKit != nullptr && currentKit->getFolder() != kitFolder)
+    {
+        getRestorePool().addJob([this, kitFolder, request] { restoreSessionKit(kitFolder, request); });
+    }
+
+    const juce::String path = state.getProperty("file");
+    if (path.isEmpty() || !juce::File::isAbsolutePath(path))
+        return;
+
+    // La canción se prepara en segundo plano: el host no espera a leer ni parsear el MIDI
+    auto restore = std::make_unique<PendingRestore>();
+    restore->file = juce::File(path);
+    restore->contentHash = (juce::uint64) state.getProperty("hash").toString().getHexValue64();
+    restore->positionSeconds = state.getProperty("position", 0.0);
+    restore->songGeneration = songGeneration;
+
+    if (auto* embeddedSong = state.getProperty("song").getBinaryData())
+        restore->embeddedSong = *embeddedSong;
+
+    const juce::String recordingPath = state.getProperty("recording");
+    restore->alignment.recording = juce::File::isAbsolutePath(recordingPath) ? juce::File(recordingPath) : juce::File();
+    restore->alignment.warp = AudioAligner::WarpMap::fromString(state.getProperty("warp").toString());
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        restoringState.replaceAll(data, (size_t) sizeInBytes);
+        pendingRestore = std::move(restore);
+    }
+
+    getRestorePool().addJob([this] { restoreSessionSong(); });
+}
+
+juce::ThreadPool& DrumVisualizerAudioProcessor::getRestorePool()
+{
+    if (restorePool == nullptr)
+        restorePool = std::make_unique<juce::ThreadPool>(1);
+
+    return *restorePool;
+}
+
+juce::ThreadPool& DrumVisualizerAudioProcessor::getBackgroundPool()
+{
+    // Dos hilos: un escaneo largo de la biblioteca no retrasa una alineación
+    if (backgroundPool == nullptr)
+        backgroundPool = std::make_unique<juce::ThreadPool>(2);
+
+    return *backgroundPool;
+}
+
+void DrumVisualizerAudioProcessor::restoreSessionKit(const juce::File& folder, int request)
+{
+    juce::String error;
+    auto kit = buildDrumKit(folder, error);
+
+    if (kit == nullptr)
+    {
+        juce::Logger::writeToLog("Error: " + error);
+
+        // Si nadie pidió otro kit entretanto, la sesión sigue con el que suena
+        const juce::ScopedLock sl(stateLock);
+        if (drumKitRequests == request)
+            if (auto currentKit = drumKit.get())
+                drumKitFolder = currentKit->getFolder();
+
+        return;
+    }
+
+    publishDrumKit(folder, std::move(kit), request);
+}
+
+void DrumVisualizerAudioProcessor::restoreSessionSong()
+{
+    juce::File file;
+    juce::uint64 contentHash = 0;
+    juce::MemoryBlock embeddedSong;
+    SongAlignment alignment;
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        if (pendingRestore == nullptr || pendingRestore->song != nullptr)
+            return;
+
+        file = pendingRestore->file;
+        contentHash = pendingRestore->contentHash;
+        embeddedSong = pendingRestore->embeddedSong;
+        alignment = pendingRestore->alignment;
+    }
+
+    PreparedSong::Ptr song;
+    juce::uint64 currentHash = 0;
+
+    if (file.existsAsFile())
+    {
+        // Si el MIDI cambió desde que se guardó la sesión, ni la copia incrustada ni la alineación sirven
+        currentHash = SongCacheFile::computeContentHash(file);
+
+        if (contentHash != 0 && contentHash != currentHash)
+        {
+            juce::Logger::writeToLog("Aviso: El MIDI cambió desde que se guardó la sesión - " + file.getFullPathName());
+            embeddedSong.reset();
+            alignment = {};
+        }
+
+        if (!alignment.warp.isEmpty())
+        {
+            // La canción alineada no es la del archivo: se construye aparte, fuera de la caché compartida
+            juce::String error;
+            song = AudioAligner::applyWarp(file, alignment.warp, error);
+
+            if (song == nullptr)
+                juce::Logger::writeToLog("Error: " + error);
+        }
+        else
+        {
+            song = songCache->getSong(file, currentHash, embeddedSong);
+        }
+    }
+
+    if (song == nullptr)
+    {
+        juce::Logger::writeToLog("Error: No se pudo restaurar el MIDI de la sesión - " + file.getFullPathName());
+
+        const juce::ScopedLock sl(stateLock);
+        if (pendingRestore != nullptr && pendingRestore->file == file)
+        {
+            pendingRestore.reset();
+            restoringState.reset();
+        }
+        return;
+    }
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        if (pendingRestore != nullptr && pendingRestore->file == file)
+        {
+            pendingRestore->contentHash = currentHash;
+            pendingRestore->alignment = std::move(alignment);
+            pendingRestore->song = std::move(song);
+        }
+    }
+
+    triggerAsyncUpdate();
+}
+
+void DrumVisualizerAudioProcessor::handleAsyncUpdate()
+{
+    std::unique_ptr<PendingRestore> restore;
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        if (pendingRestore == nullptr || pendingRestore->song == nullptr)
+            return;
+
+        restore = std::move(pendingRestore);
+        restoringState.reset();
+    }
+
+    // Si el usuario cargó otra canción mientras tanto, esa tiene prioridad
+    if (restore->songGeneration != songGeneration)
+        return;
+
+    setSong(restore->file, restore->contentHash, restore->song, std::move(restore->alignment));
+    seekTo(restore->positionSeconds);
+
+    juce::Logger::writeToLog("Sesión restaurada: " + restore->file.getFileName());
+    sendChangeMessage();
 }
 
 //==============================================================================
@@ -203,29 +685,15 @@ bool DrumVisualizerAudioProcessor::loadMidiFile(const juce::File& file)
         return false;
     }
     
-    // Intenta cargar el archivo MIDI
-    juce::FileInputStream inputStream(file);
-    if (!inputStream.openedOk())
-    {
-        juce::Logger::writeToLog("Error: No se pudo abrir el archivo - " + file.getFullPathName());
-        return false;
-    }
-    
-    // Lee el archivo MIDI
-    midiFile.clear();
-    if (!midiFile.readFrom(inputStream))
-    {
-        juce::Logger::writeToLog("Error: No se pudo leer el archivo MIDI - Archivo posiblemente dañado");
+    // Canción compartida con otras instancias; si no, caché en disco o lectura completa del SMF.
+    // El hash se calcula una sola vez: la clave de la caché y el estado de la sesión lo reutilizan.
+    const auto contentHash = SongCacheFile::computeContentHash(file);
+    auto song = songCache->getSong(file, contentHash);
+    if (song == nullptr)
         return false;
-    }
-
-    // Convertir timestamps de ticks a segundos para uso en la UI/animación
-    // Esto asegura que event.getTimeStamp() devuelva tiempos en segundos
-    midiFile.convertTimestampTicksToSeconds();
 
     // Si llegamos aquí, la carga fue exitosa
-    loadedMidiFile = file;
-    midiLoaded = true;
+    setSong(file, contentHash, std::move(song));
     
     // Log información del archivo cargado
     juce::Logger::writeToLog("MIDI cargado exitosamente:");
@@ -234,169 +702,291 @@ bool DrumVisualizerAudioProcessor::loadMidiFile(const juce::File& file)
     juce::Logger::writeToLog("  Tempo: " + juce::String(getTempoFromMidi(), 2) + " BPM");
     juce::Logger::writeToLog("  Duración: " + juce::String(getLengthInSeconds(), 2) + " segundos");
     juce::Logger::writeToLog("  Rango de notas: " + juce::String(getLowestNote()) + " - " + juce::String(getHighestNote()));
+    juce::Logger::writeToLog("  Caché compartida: " + songCache->getStatisticsText());
     
     return true;
 }
 
+void DrumVisualizerAudioProcessor::setSong(const juce::File& file, juce::uint64 contentHash, PreparedSong::Ptr song, SongAlignment alignment)
+{
+    // Cambio atómico: el renderer y la vista pasan a la nueva canción en el siguiente frame.
+    // processBlock puede tener aún la anterior; se libera cuando termina ese bloque, fuera del hilo de audio.
+    PreparedSong::Ptr previousSong;
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        previousSong = preparedSong.exchange(std::move(song));
+        loadedMidiFile = file;
+        loadedContentHash = contentHash;
+        songAlignment = std::move(alignment);
+        midiLoaded = true;
+        ++songGeneration;
+    }
+
+    releasePool.retire(std::move(previousSong));
+}
+
 void DrumVisualizerAudioProcessor::clearMidiData()
 {
-    midiFile.clear();
-    loadedMidiFile = juce::File();
-    midiLoaded = false;
+    PreparedSong::Ptr previousSong;
+
+    {
+        const juce::ScopedLock sl(stateLock);
+        previousSong = preparedSong.exchange({});
+        loadedMidiFile = juce::File();
+        loadedContentHash = 0;
+        songAlignment = {};
+        midiLoaded = false;
+        ++songGeneration;
+    }
+
+    releasePool.retire(std::move(previousSong));
     juce::Logger::writeToLog("Datos MIDI limpiados");
 }
 
+void DrumVisualizerAudioProcessor::releaseRetiredObjects()
+{
+    releasePool.releaseUnused();
+}
+
 bool DrumVisualizerAudioProcessor::hasMidiLoaded() const
 {
-    return midiLoaded;
+    return midiLoaded.load();
 }
 
 juce::String DrumVisualizerAudioProcessor::getLoadedFileName() const
 {
+    const juce::ScopedLock sl(stateLock);
     if (midiLoaded)
         return loadedMidiFile.getFileName();
     return "Ningún archivo cargado";
 }
 
+juce::File DrumVisualizerAudioProcessor::getLoadedFile() const
+{
+    const juce::ScopedLock sl(stateLock);
+    return loadedMidiFile;
+}
+
+juce::uint64 DrumVisualizerAudioProcessor::getLoadedContentHash() const
+{
+    const juce::ScopedLock sl(stateLock);
+    return loadedContentHash;
+}
+
 int DrumVisualizerAudioProcessor::getNumTracks() const
 {
-    if (midiLoaded)
-        return midiFile.getNumTracks();
+    if (auto song = getPreparedSong())
+        return song->getSummary().numTracks;
     return 0;
 }
 
 double DrumVisualizerAudioProcessor::getTempoFromMidi() const
 {
-    if (!midiLoaded)
-        return 120.0; // Tempo por defecto
-        
-    // Busca eventos de tempo en todas las pistas
-    for (int track = 0; track < midiFile.getNumTracks(); ++track)
-    {
-        const auto* trackPtr = midiFile.getTrack(track);
-        if (trackPtr != nullptr)
-        {
-            for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-            {
-                const auto& event = trackPtr->getEventPointer(i)->message;
-                if (event.isTempoMetaEvent())
-                {
-                    return event.getTempoSecondsPerQuarterNote() > 0 ? 
-                           60.0 / event.getTempoSecondsPerQuarterNote() : 120.0;
-                }
-            }
-        }
-    }
-    
-    return 120.0; // Valor por defecto si no se encuentra tempo
+    if (auto song = getPreparedSong())
+        return song->getSummary().tempoBpm;
+
+    return 120.0; // Tempo por defecto
 }
 
 double DrumVisualizerAudioProcessor::getLengthInSeconds() const
 {
-    if (!midiLoaded)
-        return 0.0;
-        
-    return midiFile.getLastTimestamp();
+    if (auto song = getPreparedSong())
+        return song->getSummary().lengthSeconds;
+
+    return 0.0;
+}
+
+double DrumVisualizerAudioProcessor::getFirstNoteTime() const
+{
+    // Note On (velocidad > 0) más temprano de todas las pistas, calculado en la carga
+    if (auto song = getPreparedSong())
+        return song->getSummary().firstNoteTime;
+
+    return 0.0;
 }
 
 // Funciones para obtener datos MIDI para el piano roll
-const juce::MidiFile& DrumVisualizerAudioProcessor::getMidiFile() const
+int DrumVisualizerAudioProcessor::getLowestNote() const
 {
-    return midiFile;
+    if (auto song = getPreparedSong())
+        return song->getSummary().lowestNote;
+
+    return 0;
 }
 
-juce::Array<juce::MidiMessage> DrumVisualizerAudioProcessor::getAllNoteEvents() const
+int DrumVisualizerAudioProcessor::getHighestNote() const
 {
-    juce::Array<juce::MidiMessage> noteEvents;
-    
-    if (!midiLoaded)
-        return noteEvents;
-    
-    // Iterar sobre todas las pistas
-    for (int track = 0; track < midiFile.getNumTracks(); ++track)
-    {
-        const auto* trackPtr = midiFile.getTrack(track);
-        if (trackPtr != nullptr)
-        {
-            // Iterar sobre todos los eventos de la pista
-            for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-            {
-                const auto& event = trackPtr->getEventPointer(i)->message;
-                
-                // Solo agregar eventos de nota (Note On y Note Off)
-                if (event.isNoteOn() || event.isNoteOff())
-                {
-                    noteEvents.add(event);
-                }
-            }
-        }
-    }
-    
-    return noteEvents;
+    if (auto song = getPreparedSong())
+        return song->getSummary().highestNote;
+
+    return 127;
 }
 
-int DrumVisualizerAudioProcessor::getLowestNote() const
+PreparedSong::Ptr DrumVisualizerAudioProcessor::getPreparedSong() const
 {
-    if (!midiLoaded)
-        return 0;
-    
-    int lowestNote = 127; // Valor máximo MIDI
-    bool foundNote = false;
-    
-    // Iterar sobre todas las pistas
-    for (int track = 0; track < midiFile.getNumTracks(); ++track)
-    {
-        const auto* trackPtr = midiFile.getTrack(track);
-        if (trackPtr != nullptr)
-        {
-            // Iterar sobre todos los eventos de la pista
-            for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-            {
-                const auto& event = trackPtr->getEventPointer(i)->message;
-                
-                // Solo considerar eventos de nota
-                if (event.isNoteOn())
-                {
-                    foundNote = true;
-                    lowestNote = std::min(lowestNote, event.getNoteNumber());
-                }
-            }
-        }
-    }
-    
-    return foundNote ? lowestNote : 0;
+    return preparedSong.get();
 }
 
-int DrumVisualizerAudioProcessor::getHighestNote() const
+NoteRange DrumVisualizerAudioProcessor::getNotes(double startSeconds, double endSeconds, const NoteFilter& filter) const
 {
-    if (!midiLoaded)
-        return 127;
-    
-    int highestNote = 0; // Valor mínimo MIDI
-    bool foundNote = false;
-    
-    // Iterar sobre todas las pistas
-    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    // La vista guarda su propia referencia a la canción: sigue siendo válida aunque se cambie de MIDI
+    return NoteRange(getPreparedSong(), startSeconds, endSeconds, filter);
+}
+
+NoteRange DrumVisualizerAudioProcessor::getAllNotes() const
+{
+    return getNotes(0.0, std::numeric_limits<double>::max());
+}
+
+DrumVisualizerAudioProcessor::PlaybackPosition DrumVisualizerAudioProcessor::seekTo (double seconds)
+{
+    auto position = updatePlaybackPosition (seconds);
+
+    // processBlock toma la nueva posición al empezar el siguiente bloque
+    requestedSeekSeconds.store (position.seconds);
+    transportSeconds.store (position.seconds);
+    seekRequests.fetch_add (1, std::memory_order_release);
+    return position;
+}
+
+DrumVisualizerAudioProcessor::PlaybackPosition DrumVisualizerAudioProcessor::followTransport (double seconds)
+{
+    return updatePlaybackPosition (seconds);
+}
+
+DrumVisualizerAudioProcessor::PlaybackPosition DrumVisualizerAudioProcessor::updatePlaybackPosition (double seconds)
+{
+    PlaybackPosition position;
+
+    if (auto song = getPreparedSong())
     {
-        const auto* trackPtr = midiFile.getTrack(track);
-        if (trackPtr != nullptr)
-        {
-            // Iterar sobre todos los eventos de la pista
-            for (int i = 0; i < trackPtr->getNumEvents(); ++i)
-            {
-                const auto& event = trackPtr->getEventPointer(i)->message;
-                
-                // Solo considerar eventos de nota
-                if (event.isNoteOn())
-                {
-                    foundNote = true;
-                    highestNote = std::max(highestNote, event.getNoteNumber());
-                }
-            }
-        }
+        position.seconds = juce::jlimit (0.0, song->getSummary().lengthSeconds, seconds);
+        position.nextNoteIndex = song->findFirstNoteAtOrAfter (position.seconds);
+
+        // En canciones paginadas, leer por adelantado los bloques que vienen
+        song->getNotes().prefetch (position.seconds);
     }
-    
-    return foundNote ? highestNote : 127;
+
+    // Tiempo e índice se publican juntos para que nadie vea uno sin el otro
+    REALTIME_AUDIT_LOCK ("DrumVisualizerAudioProcessor::playbackPositionLock");
+    const juce::SpinLock::ScopedLockType lock (playbackPositionLock);
+    playbackPosition = position;
+    return position;
+}
+
+DrumVisualizerAudioProcessor::PlaybackPosition DrumVisualizerAudioProcessor::getPlaybackPosition() const
+{
+    REALTIME_AUDIT_LOCK ("DrumVisualizerAudioProcessor::playbackPositionLock");
+    const juce::SpinLock::ScopedLockType lock (playbackPositionLock);
+    return playbackPosition;
+}
+
+void DrumVisualizerAudioProcessor::setTransportPlaying (bool shouldPlay)
+{
+    transportPlaying.store (shouldPlay);
+}
+
+bool DrumVisualizerAudioProcessor::isTransportRunning() const
+{
+    return transportPlaying.load()
+        && juce::Time::getMillisecondCounter() - lastBlockTimeMs.load() < transportTimeoutMs;
+}
+
+double DrumVisualizerAudioProcessor::getTransportSeconds() const
+{
+    return transportSeconds.load();
+}
+
+//==============================================================================
+DrumVisualizerAudioProcessor::ViewSettings DrumVisualizerAudioProcessor::getViewSettings() const
+{
+    REALTIME_AUDIT_LOCK("DrumVisualizerAudioProcessor::stateLock");
+    const juce::ScopedLock sl(stateLock);
+    return viewSettings;
+}
+
+void DrumVisualizerAudioProcessor::setViewSettings(const ViewSettings& newSettings)
+{
+    REALTIME_AUDIT_LOCK("DrumVisualizerAudioProcessor::stateLock");
+    const juce::ScopedLock sl(stateLock);
+    viewSettings = newSettings;
+
+    // Copia para processBlock, que no toma stateLock
+    transportRate = PianoRollRenderer::getScrollSpeed(newSettings.bpm, newSettings.speed);
+    metronomeDivision = BeatGrid::getDivisionForTimeFigure(newSettings.timeFigure);
+    metronomeEnabled = newSettings.metronome;
+    drumsEnabled = newSettings.drums;
+    inputHitsEnabled = newSettings.inputHits;
+    inputWaveformEnabled = newSettings.inputWaveform;
+}
+
+//==============================================================================
+bool DrumVisualizerAudioProcessor::loadDrumKit(const juce::File& folder, juce::String& error)
+{
+    // Supera cualquier restauración del kit aún en marcha
+    const int request = ++drumKitRequests;
+
+    auto kit = buildDrumKit(folder, error);
+    if (kit == nullptr)
+        return false;
+
+    publishDrumKit(folder, std::move(kit), request);
+    return true;
+}
+
+DrumKit::Ptr DrumVisualizerAudioProcessor::buildDrumKit(const juce::File& folder, juce::String& error) const
+{
+    auto kit = folder == juce::File() ? DrumKit::createSynthesized(sampleRate)
+                                      : DrumKit::loadFromFolder(folder, sampleRate, error);
+    if (kit == nullptr)
+        return nullptr;
+
+    juce::Logger::writeToLog("Kit de batería: " + (folder == juce::File() ? juce::String("integrado") : folder.getFileName())
+                             + " (" + juce::String(kit->getNumSamples()) + " muestras, "
+                             + juce::String((double) kit->getMemoryBytes() / (1024.0 * 1024.0), 1) + " MB, "
+                             + juce::String((int) kit->getStreamSources().size()) + " archivos en disco)");
+    return kit;
+}
+
+bool DrumVisualizerAudioProcessor::publishDrumKit(const juce::File& folder, DrumKit::Ptr kit, int request)
+{
+    // El streamer conoce el kit antes de que el hilo de audio pueda pedirle canales
+    const juce::ScopedLock sl(stateLock);
+    if (drumKitRequests != request)
+        return false;
+
+    const int generation = drumKitGeneration.load() + 1;
+    drumStreamer.setKit(kit, generation);
+
+    drumKitFolder = folder;
+    auto previousKit = drumKit.exchange(std::move(kit));
+
+    // Con la nueva generación publicada, el primer bloque que ya no pueda ver el kit anterior
+    // apaga sus voces antes de mezclar
+    drumKitGeneration = generation;
+    releasePool.retire(std::move(previousKit));
+    return true;
+}
+
+juce::File DrumVisualizerAudioProcessor::getDrumKitFolder() const
+{
+    const juce::ScopedLock sl(stateLock);
+    return drumKitFolder;
+}
+
+NoteFilter DrumVisualizerAudioProcessor::getNoteFilter() const
+{
+    REALTIME_AUDIT_LOCK("DrumVisualizerAudioProcessor::stateLock");
+    const juce::ScopedLock sl(stateLock);
+    return noteFilter;
+}
+
+void DrumVisualizerAudioProcessor::setNoteFilter(const NoteFilter& newFilter)
+{
+    REALTIME_AUDIT_LOCK("DrumVisualizerAudioProcessor::stateLock");
+    const juce::ScopedLock sl(stateLock);
+    noteFilter = newFilter;
 }
 
 //==============================================================================
@@ -9,11 +9,28 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PreparedSong.h"
+#include "Setlist.h"
+#include "SharedSongCache.h"
+#include "NoteFilter.h"
+#include "NoteRange.h"
+#include "AsyncLogger.h"
+#include "RealtimeAudit.h"
+#include "Metronome.h"
+#include "DrumSampler.h"
+#include "HitClassifier.h"
+#include "InputWaveform.h"
+#include "MidiRecorder.h"
+#include "TransportTimeline.h"
+#include "RealtimeShared.h"
+#include "AudioAligner.h"
 
 //==============================================================================
 /**
 */
-class DrumVisualizerAudioProcessor  : public juce::AudioProcessor
+class DrumVisualizerAudioProcessor  : public juce::AudioProcessor,
+                                      public juce::ChangeBroadcaster,  // Avisa al editor cuando termina de restaurar la sesión
+                                      private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -57,25 +74,251 @@ public:
     // Funciones para manejo de archivos MIDI
     bool loadMidiFile (const juce::File& file);
     void clearMidiData();
+    void releaseRetiredObjects();       // Libera ya lo sustituido, sin esperar al timer (con el audio parado, todo)
     bool hasMidiLoaded() const;
     juce::String getLoadedFileName() const;
+    juce::File getLoadedFile() const;
+    juce::uint64 getLoadedContentHash() const;     // Calculado al cargar (0 si no se pudo leer)
     int getNumTracks() const;
     double getTempoFromMidi() const;
     double getLengthInSeconds() const;
+    double getFirstNoteTime() const;
 
     // Funciones para obtener datos MIDI para el piano roll
-    const juce::MidiFile& getMidiFile() const;
-    juce::Array<juce::MidiMessage> getAllNoteEvents() const;
     int getLowestNote() const;
     int getHighestNote() const;
 
+    // Canción preprocesada (notas ordenadas, resumen y densidad); nullptr si no hay MIDI
+    PreparedSong::Ptr getPreparedSong() const;
+
+    // Vista sin copias de las notas (Note On) entre dos tiempos que pasan el filtro
+    NoteRange getNotes(double startSeconds, double endSeconds, const NoteFilter& filter = {}) const;
+
+    // Todas las notas de la canción
+    NoteRange getAllNotes() const;
+
+    // Canción ajustada a una grabación: la sesión guarda la correspondencia y no la canción,
+    // que no es la del archivo (ni se incrusta con su hash ni entra en la caché compartida)
+    struct SongAlignment
+    {
+        juce::File recording;
+        AudioAligner::WarpMap warp;         // Vacío: la canción es la del archivo tal cual
+    };
+
+    // Sustituye la canción actual por una ya preparada (p. ej. precargada por el setlist).
+    // contentHash es el del archivo al prepararla: el estado lo guarda sin volver a leerlo.
+    void setSong (const juce::File& file, juce::uint64 contentHash, PreparedSong::Ptr song, SongAlignment alignment = {});
+
+    // Registro asíncrono compartido (seguro desde el hilo de audio)
+    AsyncLogger& getLogger() { return *logger; }
+
+    // Setlist del procesador (sobrevive al cierre del editor)
+    Setlist& getSetlist() { return setlist; }
+
+    // Posición de reproducción: tiempo y primera nota pendiente
+    struct PlaybackPosition
+    {
+        double seconds = 0.0;
+        size_t nextNoteIndex = 0;   // Primera nota con time >= seconds
+    };
+
+    // Reposiciona el cursor con búsqueda binaria sobre las notas ordenadas (O(log n));
+    // el reloj de audio salta a la nueva posición al empezar el siguiente bloque
+    PlaybackPosition seekTo (double seconds);
+    PlaybackPosition getPlaybackPosition() const;
+
+    // Reloj de reproducción del hilo de audio: mientras suena, processBlock lo avanza
+    // según las muestras procesadas y el metrónomo y la vista lo siguen
+    void setTransportPlaying (bool shouldPlay);
+    bool isTransportRunning() const;    // Reproduciendo y el host está llamando a processBlock
+    double getTransportSeconds() const;
+
+    // Como seekTo pero sin mover el reloj de audio (la vista siguiendo al reloj)
+    PlaybackPosition followTransport (double seconds);
+
+    // Ajustes de la vista; viven en el procesador para guardarse con la sesión
+    struct ViewSettings
+    {
+        int bpm = 120;
+        float speed = 1.0f;
+        juce::String timeFigure = "1/4";
+        bool metronome = false;
+        bool drums = false;         // Sonar la canción con el kit de batería
+        bool inputHits = false;     // Detectar golpes en la entrada de audio (batería acústica)
+        bool inputWaveform = false; // Carril con la forma de onda de la entrada bajo el piano roll
+    };
+
+    ViewSettings getViewSettings() const;
+    void setViewSettings(const ViewSettings& newSettings);
+
+    // Pistas, canales y notas ocultas en el piano roll (también se guardan con la sesión)
+    NoteFilter getNoteFilter() const;
+    void setNoteFilter(const NoteFilter& newFilter);
+
+    // Kit de batería con el que suena la canción: carpeta de muestras o, con una carpeta
+    // vacía, el kit integrado. Se prepara para la frecuencia de muestreo actual.
+    bool loadDrumKit(const juce::File& folder, juce::String& error);
+    juce::File getDrumKitFolder() const;
+
+    // Canales de streaming en uso y cortes por falta de datos del disco
+    DrumStreamer::Statistics getDrumStreamingStatistics() const { return drumStreamer.getStatistics(); }
+
+    // Bloques de audio en los que las notas de una canción paginada aún no estaban en memoria
+    // (sus golpes no suenan; el hilo de audio nunca espera al disco)
+    int getNoteUnderruns() const { return noteUnderruns.load(std::memory_order_relaxed); }
+
+    // Golpe detectado en la entrada de audio, en tiempo de la canción
+    struct InputHit
+    {
+        double time = 0.0;
+        int lane = 0;               // HitClassifier::Lane
+        int noteNumber = 0;         // Nota GM del carril (el editor la ajusta a la de la partitura)
+        float strength = 0.0f;
+        OnsetDetector::Features features {};    // Para calibrar el clasificador
+        bool matched = false;       // El editor encontró una nota del mismo carril en la partitura
+    };
+
+    // Saca como mucho maximum golpes de la cola (un solo lector: el editor). Sin locks.
+    int popInputHits(InputHit* destination, int maximum);
+
+    // Picos de la entrada para el carril de forma de onda (un solo lector: el editor). Sin locks.
+    int popInputWaveform(InputWaveform::Peak* destination, int maximum) { return inputWaveform.read(destination, maximum); }
+
+    // Grabación de lo que se toca (pads MIDI y golpes detectados en la entrada) mientras suena
+    // la canción, en un .mid con los tiempos de la canción que se puede abrir con loadMidiFile
+    bool startMidiRecording(const juce::File& file, juce::String& error) { return midiRecorder.start(file, error); }
+    juce::File stopMidiRecording() { return midiRecorder.stop(); }
+    bool isRecordingMidi() const { return midiRecorder.isRecording(); }
+    MidiRecorder::Statistics getMidiRecordingStatistics() const { return midiRecorder.getStatistics(); }
+
+    // Trabajos largos del editor (alineación, escaneo de la biblioteca). El pool es del procesador
+    // para que su destructor los cancele y los espere; cada trabajo consulta shouldExit() de
+    // juce::ThreadPoolJob::getCurrentThreadPoolJob(). Solo desde el hilo de mensajes.
+    juce::ThreadPool& getBackgroundPool();
+
+    // Clasificador de los golpes de la entrada; se sustituye entero (calibración) y se guarda con la sesión
+    HitClassifier::Ptr getHitClassifier() const;
+    void setHitClassifier(HitClassifier::Ptr newClassifier);
+
 private:
+    // Primer miembro: el registro asíncrono queda instalado antes de que nada escriba en él.
+    // Desde processBlock usar logger->logf(), nunca juce::Logger::writeToLog.
+    juce::SharedResourcePointer<AsyncLogger> logger;
+
+    //==============================================================================
+    // Restauración de la sesión: el estado se lee en el hilo del host y la canción
+    // se prepara en restorePool; el cambio de canción se aplica en el hilo de mensajes
+    struct PendingRestore
+    {
+        juce::File file;
+        juce::uint64 contentHash = 0;
+        juce::MemoryBlock embeddedSong;
+        SongAlignment alignment;
+        double positionSeconds = 0.0;
+        PreparedSong::Ptr song;         // Resultado del hilo de fondo
+        int songGeneration = 0;         // Si la canción cambió entretanto, la restauración se descarta
+    };
+
+    void restoreSessionSong();
+    void restoreSessionKit(const juce::File& folder, int request);
+    void handleAsyncUpdate() override;
+    juce::ThreadPool& getRestorePool();
+
+    // Construir el kit (lento: lee y convierte las muestras) y publicarlo van por separado;
+    // solo se publica el kit de la última petición
+    DrumKit::Ptr buildDrumKit(const juce::File& folder, juce::String& error) const;
+    bool publishDrumKit(const juce::File& folder, DrumKit::Ptr kit, int request);
+
+    // Las canciones mayores no se incrustan en el estado (solo la referencia al archivo)
+    static constexpr size_t maximumEmbeddedSongBytes = 4 * 1024 * 1024;
+
+    PlaybackPosition updatePlaybackPosition (double seconds);
+
+    // Mezcla los golpes de la canción que caen en el bloque, cada uno en su muestra
+    void renderDrums (juce::AudioBuffer<float>& buffer, const PreparedSong& song, int generation, const DrumKit& kit);
+
+    // Busca golpes en la entrada (antes de mezclar metrónomo y batería) y los encola para el editor
+    void detectInputHits (const juce::AudioBuffer<float>& buffer, int numInputChannels);
+
+    // Pasa los mensajes de los pads del bloque a la grabación, cada uno en su tiempo
+    void recordMidiInput (const juce::MidiBuffer& midiMessages);
+
+    // Sin bloques durante este tiempo se considera que el host no está procesando audio
+    static constexpr juce::uint32 transportTimeoutMs = 250;
+
     //==============================================================================
-    // Variables para manejo de archivos MIDI
-    juce::MidiFile midiFile;
+    // Variables para manejo de archivos MIDI: se escriben bajo stateLock; midiLoaded se lee sin él (paint)
     juce::File loadedMidiFile;
-    bool midiLoaded = false;
+    juce::uint64 loadedContentHash = 0;
+    SongAlignment songAlignment;
+    std::atomic<bool> midiLoaded { false };
+    RealtimeReleasePool releasePool;        // Canciones, kits y clasificadores sustituidos, hasta que el audio los suelta
+    RealtimeShared<PreparedSong> preparedSong;
+    PlaybackPosition playbackPosition;
+    juce::SpinLock playbackPositionLock;
+    Setlist setlist;
+    juce::SharedResourcePointer<SharedSongCache> songCache; // Compartida entre instancias
     double sampleRate = 44100.0;
 
+    ViewSettings viewSettings;
+    NoteFilter noteFilter;
+    juce::MemoryBlock restoringState;   // Estado recibido mientras se restaura (se devuelve tal cual)
+    std::unique_ptr<PendingRestore> pendingRestore;
+    std::atomic<int> songGeneration { 0 };
+    mutable juce::CriticalSection stateLock;
+
+    //==============================================================================
+    // Transporte y metrónomo. Los atomics los escribe el hilo de mensajes y los lee processBlock;
+    // el resto solo lo usa el hilo de audio.
+    std::atomic<bool> transportPlaying { false };
+    std::atomic<double> transportRate { 1.0 };          // Segundos de canción por segundo real
+    std::atomic<double> requestedSeekSeconds { 0.0 };
+    std::atomic<int> seekRequests { 0 };                // Se incrementa después de escribir requestedSeekSeconds
+    std::atomic<double> transportSeconds { 0.0 };       // Posición publicada por processBlock
+    std::atomic<juce::uint32> lastBlockTimeMs { 0 };
+    std::atomic<bool> metronomeEnabled { false };
+    std::atomic<int> metronomeDivision { 4 };
+
+    Metronome metronome;
+    TransportTimeline timeline;   // Ancla del reloj de audio; se reinicia al buscar o cambiar la velocidad
+    int seekRequestsSeen = 0;
+
+    // Batería: el kit se sustituye como la canción
+    std::atomic<bool> drumsEnabled { false };
+    RealtimeShared<DrumKit> drumKit;
+    std::atomic<int> drumKitGeneration { 0 };
+    juce::File drumKitFolder;               // Protegida por stateLock
+    std::atomic<int> drumKitRequests { 0 }; // Cada carga de kit; una restauración superada se descarta
+
+    DrumStreamer drumStreamer;              // Resto de las tomas largas, leído del disco en su hilo
+    DrumSampler drumSampler { drumStreamer };
+    int drumKitGenerationSeen = -1;
+    const PreparedSong* drumSong = nullptr; // Canción del cursor; solo se compara, no se usa
+    int drumSongGeneration = -1;
+    size_t drumNoteIndex = 0;               // Siguiente nota a sonar
+    bool drumCursorValid = false;
+    std::atomic<int> noteUnderruns { 0 };
+
+    // Golpes de la entrada: cola de un productor (processBlock) y un consumidor (editor)
+    std::atomic<bool> inputHitsEnabled { false };
+    OnsetDetector onsetDetector;
+    RealtimeShared<HitClassifier> hitClassifier { HitClassifier::createDefault() };
+    static constexpr int inputHitQueueSize = 512;
+    juce::AbstractFifo inputHitFifo { inputHitQueueSize };
+    std::array<InputHit, inputHitQueueSize> inputHitQueue;
+
+    // Forma de onda de la entrada: solo picos por intervalo, en su propia cola
+    std::atomic<bool> inputWaveformEnabled { false };
+    InputWaveform inputWaveform;
+
+    // Grabación: el hilo de audio solo rellena bloques ya reservados; escribe el hilo del grabador
+    MidiRecorder midiRecorder;
+
+    // Se crea solo al restaurar una sesión; el destructor espera a que termine
+    std::unique_ptr<juce::ThreadPool> restorePool;
+
+    // Se crea con el primer trabajo del editor; el destructor lo cancela y espera
+    std::unique_ptr<juce::ThreadPool> backgroundPool;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumVisualizerAudioProcessor)
 };
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    PreparedSong.cpp
+    Datos de la canción preprocesados al cargar: notas ordenadas, resumen,
+    pirámide de densidad, rejilla de tiempo y curvas de controladores.
+
+  ==============================================================================
+*/
+
+#include "PreparedSong.h"
+
+//==============================================================================
+PreparedSong::Ptr PreparedSong::build (const juce::MidiFile& midiFile)
+{
+    std::shared_ptr<PreparedSong> song (new PreparedSong());
+    auto& summary = song->summary;
+
+    summary.numTracks = midiFile.getNumTracks();
+    summary.lengthSeconds = midiFile.getLastTimestamp();
+    song->tracks.resize ((size_t) summary.numTracks);
+
+    bool foundTempo = false;
+    std::vector<BeatGrid::TempoChange> tempoChanges;
+    std::vector<BeatGrid::MeterChange> meterChanges;
+    std::vector<SongNote> notes;
+    std::vector<ControllerLanes::Event> controllerEvents;
+    int lowestNote = 127;
+    int highestNote = 0;
+
+    // Una sola pasada sobre todos los eventos de todas las pistas
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    {
+        const auto* trackPtr = midiFile.getTrack (track);
+        if (trackPtr == nullptr)
+            continue;
+
+        summary.numEvents += trackPtr->getNumEvents();
+        auto& trackInfo = song->tracks[(size_t) track];
+
+        for (const auto* holder : *trackPtr)
+        {
+            const auto& event = holder->message;
+
+            if (event.isNoteOn())
+            {
+                SongNote note;
+                note.time = event.getTimeStamp();
+                note.track = (juce::uint16) track;
+                note.noteNumber = (juce::uint8) event.getNoteNumber();
+                note.velocity = event.getVelocity();
+                note.channel = (juce::uint8) event.getChannel();
+                notes.push_back (note);
+
+                ++trackInfo.numNotes;
+                trackInfo.channels |= (juce::uint16) (1u << ((note.channel - 1) & 15));
+                trackInfo.notes.set (note.noteNumber);
+
+                lowestNote = std::min (lowestNote, (int) note.noteNumber);
+                highestNote = std::max (highestNote, (int) note.noteNumber);
+            }
+            else if (event.isController())
+            {
+                controllerEvents.push_back ({ event.getTimeStamp(), (juce::uint8) event.getControllerNumber(),
+                                              (juce::uint8) event.getControllerValue() });
+            }
+            else if (event.isTempoMetaEvent())
+            {
+                const double secondsPerQuarter = event.getTempoSecondsPerQuarterNote();
+                tempoChanges.push_back ({ event.getTimeStamp(), secondsPerQuarter });
+
+                if (!foundTempo)
+                {
+                    summary.tempoBpm = secondsPerQuarter > 0 ? 60.0 / secondsPerQuarter : 120.0;
+                    foundTempo = true;
+                }
+            }
+            else if (event.isTrackNameEvent() && trackInfo.name.isEmpty())
+            {
+                trackInfo.name = event.getTextFromTextMetaEvent().trim();
+            }
+            else if (event.isTimeSignatureMetaEvent())
+            {
+                int numerator = 4, denominator = 4;
+                event.getTimeSignatureInfo (numerator, denominator);
+                meterChanges.push_back ({ event.getTimeStamp(), numerator, denominator });
+            }
+        }
+    }
+
+    // Orden estable por tiempo: a igual tiempo se conserva el orden de pista
+    std::stable_sort (notes.begin(), notes.end(),
+                      [] (const SongNote& a, const SongNote& b) { return a.time < b.time; });
+
+    if (!notes.empty())
+    {
+        summary.lowestNote = lowestNote;
+        summary.highestNote = highestNote;
+        summary.firstNoteTime = notes.front().time;
+    }
+
+    song->density.build (notes, summary.lengthSeconds);
+    song->beatGrid.build (std::move (tempoChanges), std::move (meterChanges), summary.lengthSeconds);
+    song->controllers.build (std::move (controllerEvents));
+    song->notes.setNotes (std::move (notes));
+    return song;
+}
+
+size_t PreparedSong::findFirstNoteAtOrAfter (double seconds) const
+{
+    return notes.findFirstAtOrAfter (seconds);
+}
+
+size_t PreparedSong::getMemoryBytes() const
+{
+    return sizeof (PreparedSong)
+         + notes.getMemoryBytes()
+         + density.getMemoryBytes()
+         + beatGrid.getMemoryBytes()
+         + controllers.getMemoryBytes()
+         + tracks.capacity() * sizeof (TrackInfo);
+}
+
+bool PreparedSong::readMidiFile (const juce::File& file, juce::MidiFile& result)
+{
+    // Intenta cargar el archivo MIDI
+    juce::FileInputStream inputStream (file);
+    if (!inputStream.openedOk())
+    {
+        juce::Logger::writeToLog ("Error: No se pudo abrir el archivo - " + file.getFullPathName());
+        return false;
+    }
+
+    // Lee el archivo MIDI
+    result.clear();
+    if (!result.readFrom (inputStream))
+    {
+        juce::Logger::writeToLog ("Error: No se pudo leer el archivo MIDI - Archivo posiblemente dañado");
+        return false;
+    }
+
+    // Convertir timestamps de ticks a segundos para uso en la UI/animación
+    // Esto asegura que event.getTimeStamp() devuelva tiempos en segundos
+    result.convertTimestampTicksToSeconds();
+    return true;
+}
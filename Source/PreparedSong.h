@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    PreparedSong.h
+    Datos de la canción preprocesados al cargar: notas ordenadas, resumen,
+    pirámide de densidad, rejilla de tiempo y curvas de controladores.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <bitset>
+#include "SongNote.h"
+#include "NoteStore.h"
+#include "DensityPyramid.h"
+#include "BeatGrid.h"
+#include "ControllerLanes.h"
+
+//==============================================================================
+/**
+    Representación inmutable de una canción lista para dibujar. Se construye una
+    vez por carga a partir del juce::MidiFile (con tiempos ya en segundos) y se
+    comparte como std::shared_ptr<const PreparedSong>.
+*/
+class PreparedSong
+{
+public:
+    using Ptr = std::shared_ptr<const PreparedSong>;
+
+    // Resumen calculado en la carga
+    struct Summary
+    {
+        int numTracks = 0;
+        int numEvents = 0;          // Todos los eventos del SMF (no solo notas)
+        int lowestNote = 0;         // 0 si no hay notas
+        int highestNote = 127;      // 127 si no hay notas
+        double firstNoteTime = 0.0;
+        double lengthSeconds = 0.0;
+        double tempoBpm = 120.0;    // Primer evento de tempo encontrado
+    };
+
+    // Resumen de cada pista del SMF, para ofrecer los filtros sin recorrer las notas
+    struct TrackInfo
+    {
+        juce::String name;
+        int numNotes = 0;
+        juce::uint16 channels = 0;  // Bit (canal - 1) de cada canal usado
+        std::bitset<128> notes;     // Notas usadas
+    };
+
+    // Construye la canción a partir de un MidiFile con timestamps en segundos
+    static Ptr build (const juce::MidiFile& midiFile);
+
+    // Lee un SMF y convierte sus timestamps a segundos (lo que espera build)
+    static bool readMidiFile (const juce::File& file, juce::MidiFile& result);
+
+    const Summary& getSummary() const                { return summary; }
+    const NoteStore& getNotes() const                { return notes; }
+    const DensityPyramid& getDensity() const         { return density; }
+    const BeatGrid& getBeatGrid() const              { return beatGrid; }
+    const ControllerLanes& getControllers() const    { return controllers; }
+    const std::vector<TrackInfo>& getTracks() const  { return tracks; }
+
+    // Índice de la primera nota con time >= seconds (búsqueda binaria)
+    size_t findFirstNoteAtOrAfter (double seconds) const;
+
+    // Memoria aproximada de los arrays residentes de la canción, para límites de caché
+    size_t getMemoryBytes() const;
+
+private:
+    friend class SongCacheFile;   // Lee y escribe los arrays en bloque
+
+    PreparedSong() = default;
+
+    Summary summary;
+    NoteStore notes;                // Ordenadas por tiempo; paginadas en archivos enormes
+    DensityPyramid density;
+    BeatGrid beatGrid;
+    ControllerLanes controllers;    // Mensajes de control (CC) por controlador
+    std::vector<TrackInfo> tracks;
+
+    JUCE_LEAK_DETECTOR (PreparedSong)
+};
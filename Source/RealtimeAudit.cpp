@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.cpp
+    Auditoría de reservas de memoria y locks en processBlock y en cada frame.
+
+  ==============================================================================
+*/
+
+#include "RealtimeAudit.h"
+
+#if DRUMVISUALIZER_REALTIME_AUDIT
+
+#include <new>
+#include <cstdlib>
+
+//==============================================================================
+namespace
+{
+    // Solo datos triviales: se inicializa sin código y sirve incluso antes de main
+    struct ThreadState
+    {
+        const char* scopeName = nullptr;
+        juce::uint32 allocations = 0;
+        juce::uint32 deallocations = 0;
+        juce::uint32 locks = 0;
+        juce::uint32 scopesSinceReport = 0;
+        const char* firstLockSite = nullptr;
+        bool capturing = false;             // Evita contar las reservas de la propia captura
+        bool hasBacktrace = false;
+        bool reportThisScope = false;
+        double lastReportMs = -RealtimeAudit::reportIntervalMs;
+        char backtrace[2048] {};
+    };
+
+    thread_local ThreadState threadState;
+
+    void noteAllocation()
+    {
+        auto& state = threadState;
+        if (state.scopeName == nullptr || state.capturing)
+            return;
+
+        ++state.allocations;
+
+        // Pila de la primera reserva del ámbito (solo si este ámbito se va a avisar)
+        if (state.reportThisScope && !state.hasBacktrace)
+        {
+            state.capturing = true;
+            juce::SystemStats::getStackBacktrace().copyToUTF8 (state.backtrace, sizeof (state.backtrace));
+            state.hasBacktrace = true;
+            state.capturing = false;
+        }
+    }
+
+    void noteDeallocation()
+    {
+        auto& state = threadState;
+        if (state.scopeName != nullptr && !state.capturing)
+            ++state.deallocations;
+    }
+
+    void* allocate (std::size_t size)
+    {
+        noteAllocation();
+
+        if (auto* pointer = std::malloc (size > 0 ? size : 1))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment)
+    {
+        noteAllocation();
+
+        const auto align = juce::jmax ((std::size_t) alignment, sizeof (void*));
+        const auto roundedSize = (juce::jmax (size, (std::size_t) 1) + align - 1) / align * align;
+
+       #if JUCE_WINDOWS
+        if (auto* pointer = _aligned_malloc (roundedSize, align))
+            return pointer;
+       #else
+        void* pointer = nullptr;
+        if (posix_memalign (&pointer, align, roundedSize) == 0)
+            return pointer;
+       #endif
+
+        throw std::bad_alloc();
+    }
+
+    void release (void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        noteDeallocation();
+        std::free (pointer);
+    }
+
+    void releaseAligned (void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        noteDeallocation();
+
+       #if JUCE_WINDOWS
+        _aligned_free (pointer);
+       #else
+        std::free (pointer);
+       #endif
+    }
+}
+
+//==============================================================================
+void* operator new (std::size_t size)                                           { return allocate (size); }
+void* operator new[] (std::size_t size)                                         { return allocate (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept           { try { return allocate (size); } catch (...) { return nullptr; } }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept         { try { return allocate (size); } catch (...) { return nullptr; } }
+void* operator new (std::size_t size, std::align_val_t alignment)               { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)             { return allocateAligned (size, alignment); }
+
+void operator delete (void* pointer) noexcept                                   { release (pointer); }
+void operator delete[] (void* pointer) noexcept                                 { release (pointer); }
+void operator delete (void* pointer, std::size_t) noexcept                      { release (pointer); }
+void operator delete[] (void* pointer, std::size_t) noexcept                    { release (pointer); }
+void operator delete (void* pointer, const std::nothrow_t&) noexcept            { release (pointer); }
+void operator delete[] (void* pointer, const std::nothrow_t&) noexcept          { release (pointer); }
+void operator delete (void* pointer, std::align_val_t) noexcept                 { releaseAligned (pointer); }
+void operator delete[] (void* pointer, std::align_val_t) noexcept               { releaseAligned (pointer); }
+void operator delete (void* pointer, std::size_t, std::align_val_t) noexcept    { releaseAligned (pointer); }
+void operator delete[] (void* pointer, std::size_t, std::align_val_t) noexcept  { releaseAligned (pointer); }
+
+//==============================================================================
+RealtimeAudit::Scope::Scope (const char* name, AsyncLogger& loggerToUse)
+    : logger (loggerToUse), previousName (threadState.scopeName)
+{
+    auto& state = threadState;
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+
+    // Ámbitos anidados: el externo sigue contando lo del interno
+    if (previousName == nullptr)
+    {
+        state.allocations = state.deallocations = state.locks = 0;
+        state.firstLockSite = nullptr;
+        state.hasBacktrace = false;
+        state.reportThisScope = now - state.lastReportMs >= reportIntervalMs;
+    }
+
+    reportThisScope = state.reportThisScope;
+    state.scopeName = name;
+}
+
+RealtimeAudit::Scope::~Scope()
+{
+    auto& state = threadState;
+    const auto* name = state.scopeName;
+    state.scopeName = previousName;
+
+    if (previousName != nullptr || (state.allocations == 0 && state.locks == 0))
+        return;
+
+    ++state.scopesSinceReport;
+
+    if (reportThisScope)
+    {
+        // logf no reserva: los avisos se pueden emitir desde el hilo de audio
+        logger.logf ("RealtimeAudit: %s: %u reservas, %u liberaciones, %u locks (%s); %u ambitos con avisos en el ultimo segundo",
+                     name, state.allocations, state.deallocations, state.locks,
+                     state.firstLockSite != nullptr ? state.firstLockSite : "-", state.scopesSinceReport);
+
+        if (state.hasBacktrace)
+        {
+            const char* line = state.backtrace;
+
+            for (int i = 0; i < maximumBacktraceLines && *line != 0; ++i)
+            {
+                const char* end = std::strchr (line, '\n');
+                const int length = end != nullptr ? (int) (end - line) : (int) std::strlen (line);
+                logger.logf ("RealtimeAudit:   %.*s", length, line);
+                line = end != nullptr ? end + 1 : line + length;
+            }
+        }
+
+        state.lastReportMs = juce::Time::getMillisecondCounterHiRes();
+        state.scopesSinceReport = 0;
+    }
+
+   #if DRUMVISUALIZER_REALTIME_AUDIT >= 2
+    jassertfalse; // Reserva o lock dentro de un ámbito de tiempo real (ver el log)
+   #endif
+}
+
+void RealtimeAudit::noteLock (const char* site) noexcept
+{
+    auto& state = threadState;
+    if (state.scopeName == nullptr)
+        return;
+
+    if (state.locks++ == 0)
+        state.firstLockSite = site;
+}
+
+#endif
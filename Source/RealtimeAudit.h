@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.h
+    Auditoría de reservas de memoria y locks en processBlock y en cada frame.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AsyncLogger.h"
+
+//==============================================================================
+// Opción de compilación (añadir a las definiciones del preprocesador en Projucer):
+//   0 = desactivada (por defecto), sin coste
+//   1 = cuenta reservas y locks dentro de los ámbitos de tiempo real y los avisa por el log
+//   2 = como 1 y además jassertfalse al salir de un ámbito que reservó o bloqueó
+#ifndef DRUMVISUALIZER_REALTIME_AUDIT
+ #define DRUMVISUALIZER_REALTIME_AUDIT 0
+#endif
+
+//==============================================================================
+/**
+    Con la auditoría activa se reemplazan operator new/delete globales y cada
+    hilo lleva sus contadores en variables thread_local. Un Scope marca una
+    sección que no debe reservar memoria ni esperar locks (processBlock, paint):
+    al salir, si hubo alguno, se avisa por el AsyncLogger con el nombre del
+    ámbito, los contadores, el primer lock y la pila de la primera reserva.
+
+    Los locks no se pueden interceptar de forma portable, así que los del
+    propio código se marcan con REALTIME_AUDIT_LOCK ("sitio") junto al lock.
+*/
+class RealtimeAudit
+{
+public:
+    class Scope
+    {
+    public:
+       #if DRUMVISUALIZER_REALTIME_AUDIT
+        Scope (const char* name, AsyncLogger& logger);
+        ~Scope();
+       #else
+        Scope (const char*, AsyncLogger&) noexcept {}
+       #endif
+
+    private:
+       #if DRUMVISUALIZER_REALTIME_AUDIT
+        AsyncLogger& logger;
+        const char* previousName;
+        bool reportThisScope;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    // Anota la adquisición de un lock (si el hilo está dentro de un Scope)
+    static void noteLock (const char* site) noexcept;
+
+    // Avisos como mucho una vez por segundo y por hilo (el resto solo se cuenta)
+    static constexpr double reportIntervalMs = 1000.0;
+    static constexpr int maximumBacktraceLines = 12;
+};
+
+#if DRUMVISUALIZER_REALTIME_AUDIT
+ #define REALTIME_AUDIT_LOCK(site)  RealtimeAudit::noteLock (site)
+#else
+ #define REALTIME_AUDIT_LOCK(site)
+#endif
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    RealtimeShared.cpp
+    Objetos inmutables compartidos con el hilo de audio sin locks y liberados
+    fuera de él.
+
+  ==============================================================================
+*/
+
+#include "RealtimeShared.h"
+
+//==============================================================================
+RealtimeReleasePool::RealtimeReleasePool()
+{
+    startTimer (releaseIntervalMs);
+}
+
+RealtimeReleasePool::~RealtimeReleasePool()
+{
+    // El dueño se destruye con el audio ya parado: todo se puede liberar
+    stopTimer();
+}
+
+void RealtimeReleasePool::retire (std::shared_ptr<const void> object)
+{
+    if (object == nullptr)
+        return;
+
+    // El contador se lee después de publicar el objeto nuevo (orden secuencial con el audio)
+    const auto blocks = audioBlocks.load();
+
+    const juce::ScopedLock sl (lock);
+    retired.push_back ({ std::move (object), blocks });
+}
+
+void RealtimeReleasePool::releaseUnused()
+{
+    std::vector<Retired> released;
+    const auto blocks = audioBlocks.load();
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (auto it = retired.begin(); it != retired.end();)
+        {
+            if ((it->audioBlocks & 1) == 0 || blocks > it->audioBlocks)
+            {
+                released.push_back (std::move (*it));
+                it = retired.erase (it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // Liberar una canción o un kit puede tardar: fuera del lock
+    released.clear();
+}
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    RealtimeShared.h
+    Objetos inmutables compartidos con el hilo de audio sin locks y liberados
+    fuera de él.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Guarda los objetos sustituidos (canción, kit, clasificador) hasta que el
+    hilo de audio ya no puede estar usándolos, y los libera en el hilo de
+    mensajes desde un timer.
+
+    El hilo de audio incrementa un contador al empezar y al terminar cada
+    bloque (impar: dentro de un bloque). Un objeto retirado con el contador
+    par no lo tiene ningún bloque; con el contador impar, basta con que ese
+    bloque termine. Cualquier número de cambios seguidos es seguro, no solo
+    el último.
+*/
+class RealtimeReleasePool : private juce::Timer
+{
+public:
+    RealtimeReleasePool();
+    ~RealtimeReleasePool() override;
+
+    // Hilo de audio: marca el bloque entero, con todas sus salidas
+    class AudioBlock
+    {
+    public:
+        explicit AudioBlock (RealtimeReleasePool& poolToUse) noexcept
+            : pool (poolToUse)
+        {
+            pool.audioBlocks.fetch_add (1);
+        }
+
+        ~AudioBlock()
+        {
+            pool.audioBlocks.fetch_add (1);
+        }
+
+    private:
+        RealtimeReleasePool& pool;
+
+        JUCE_DECLARE_NON_COPYABLE (AudioBlock)
+    };
+
+    // Cualquier hilo menos el de audio, después de publicar el objeto nuevo
+    void retire (std::shared_ptr<const void> object);
+
+    // Libera ya lo que el hilo de audio no puede ver (el timer lo llama solo)
+    void releaseUnused();
+
+    static constexpr int releaseIntervalMs = 100;
+
+private:
+    struct Retired
+    {
+        std::shared_ptr<const void> object;
+        juce::uint64 audioBlocks = 0;       // Contador al retirarlo
+    };
+
+    void timerCallback() override       { releaseUnused(); }
+
+    std::atomic<juce::uint64> audioBlocks { 0 };
+    juce::CriticalSection lock;
+    std::vector<Retired> retired;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeReleasePool)
+};
+
+//==============================================================================
+/**
+    Un shared_ptr<const ObjectType> que el resto de hilos copian bajo un
+    SpinLock y el hilo de audio lee como puntero atómico, sin locks ni
+    contadores de referencias. El puntero del audio vale hasta el final del
+    bloque; el objeto sustituido se entrega a un RealtimeReleasePool.
+*/
+template <typename ObjectType>
+class RealtimeShared
+{
+public:
+    using Ptr = std::shared_ptr<const ObjectType>;
+
+    RealtimeShared() = default;
+    explicit RealtimeShared (Ptr initialObject)     { exchange (std::move (initialObject)); }
+
+    // Cualquier hilo menos el de audio
+    Ptr get() const
+    {
+        const juce::SpinLock::ScopedLockType sl (lock);
+        return object;
+    }
+
+    // Publica el objeto nuevo y devuelve el anterior, que hay que pasar a RealtimeReleasePool::retire
+    // (después de publicar cualquier otro estado que el audio lea junto a este objeto)
+    Ptr exchange (Ptr newObject)
+    {
+        const juce::SpinLock::ScopedLockType sl (lock);
+        audioObject.store (newObject.get());
+        return std::exchange (object, std::move (newObject));
+    }
+
+    // Hilo de audio
+    const ObjectType* getForAudio() const noexcept  { return audioObject.load(); }
+
+private:
+    mutable juce::SpinLock lock;
+    Ptr object;
+    std::atomic<const ObjectType*> audioObject { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeShared)
+};
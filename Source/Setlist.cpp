@@ -0,0 +1,274 @@
+/*
+  ==============================================================================
+
+    Setlist.cpp
+    Lista ordenada de canciones con precarga en segundo plano de la siguiente.
+
+  ==============================================================================
+*/
+
+#include "Setlist.h"
+#include "SharedSongCache.h"
+#include "SongCacheFile.h"
+#include "MinimapComponent.h"
+
+//==============================================================================
+Setlist::Setlist()
+    : juce::Thread ("Setlist prefetch")
+{
+}
+
+Setlist::~Setlist()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread (5000);
+}
+
+void Setlist::setFiles (const juce::Array<juce::File>& newFiles)
+{
+    // El hilo de precarga solo se arranca si se usa un setlist
+    if (!isThreadRunning())
+        startThread (juce::Thread::Priority::low);
+
+    const juce::ScopedLock sl (lock);
+    files = newFiles;
+    currentIndex = -1;
+
+    prefetched.erase (std::remove_if (prefetched.begin(), prefetched.end(),
+                                      [this] (const Slot& slot) { return !files.contains (slot.entry->file); }),
+                      prefetched.end());
+}
+
+juce::Array<juce::File> Setlist::readSetlistFile (const juce::File& setlistFile)
+{
+    juce::Array<juce::File> result;
+    juce::StringArray lines;
+    setlistFile.readLines (lines);
+
+    for (auto line : lines)
+    {
+        line = line.trim().unquoted();
+        if (line.isEmpty() || line.startsWithChar ('#'))
+            continue;
+
+        // getChildFile resuelve tanto rutas relativas como absolutas
+        const auto file = setlistFile.getParentDirectory().getChildFile (line);
+        if (file.existsAsFile())
+            result.add (file);
+    }
+
+    return result;
+}
+
+bool Setlist::isSetlistFile (const juce::File& file)
+{
+    return file.hasFileExtension ("txt;m3u;m3u8");
+}
+
+int Setlist::getNumSongs() const
+{
+    const juce::ScopedLock sl (lock);
+    return files.size();
+}
+
+int Setlist::getCurrentIndex() const
+{
+    const juce::ScopedLock sl (lock);
+    return currentIndex;
+}
+
+juce::File Setlist::getFile (int index) const
+{
+    const juce::ScopedLock sl (lock);
+    return files[index];
+}
+
+void Setlist::setOverviewSize (int width, int height)
+{
+    const juce::ScopedLock sl (lock);
+    overviewWidth = width;
+    overviewHeight = height;
+}
+
+void Setlist::setMemoryLimit (size_t bytes)
+{
+    const juce::ScopedLock sl (lock);
+    memoryLimit = bytes;
+    evictOverLimit (files[currentIndex]);
+}
+
+size_t Setlist::getResidentBytes() const
+{
+    const juce::ScopedLock sl (lock);
+
+    size_t total = 0;
+    for (const auto& slot : prefetched)
+        total += slot.bytes;
+
+    return total;
+}
+
+int Setlist::getNumPrefetched() const
+{
+    const juce::ScopedLock sl (lock);
+    return (int) prefetched.size();
+}
+
+//==============================================================================
+Setlist::EntryPtr Setlist::select (int index)
+{
+    juce::File file;
+    int width = 0, height = 0;
+
+    {
+        const juce::ScopedLock sl (lock);
+        if (!juce::isPositiveAndBelow (index, files.size()))
+            return {};
+
+        currentIndex = index;
+        file = files[index];
+        width = overviewWidth;
+        height = overviewHeight;
+
+        if (auto entry = findPrefetched (file))
+        {
+            notify(); // Preparar las nuevas vecinas
+            return entry;
+        }
+    }
+
+    // No estaba precargada (p. ej. la primera canción): prepararla aquí
+    auto entry = prepare (file, width, height);
+
+    if (entry != nullptr)
+    {
+        const juce::ScopedLock sl (lock);
+        storePrefetched (entry);
+    }
+
+    notify();
+    return entry;
+}
+
+Setlist::EntryPtr Setlist::prepare (const juce::File& file, int width, int height) const
+{
+    // A través de la caché compartida: si otra instancia ya tiene la canción no se prepara otra vez
+    juce::SharedResourcePointer<SharedSongCache> songCache;
+    const auto contentHash = SongCacheFile::computeContentHash (file);
+    auto song = songCache->getSong (file, contentHash);
+    if (song == nullptr)
+        return {};
+
+    auto entry = std::make_shared<Entry>();
+    entry->file = file;
+    entry->contentHash = contentHash;
+    entry->song = std::move (song);
+
+    if (width > 0 && height > 0)
+        entry->overview = MinimapComponent::renderOverview (entry->song.get(), width, height);
+
+    return entry;
+}
+
+Setlist::EntryPtr Setlist::findPrefetched (const juce::File& file)
+{
+    for (auto& slot : prefetched)
+    {
+        if (slot.entry->file == file)
+        {
+            slot.lastUsed = ++useCounter;
+            return slot.entry;
+        }
+    }
+
+    return {};
+}
+
+void Setlist::storePrefetched (EntryPtr entry)
+{
+    if (findPrefetched (entry->file) != nullptr)
+        return;
+
+    Slot slot;
+    slot.bytes = entry->song->getMemoryBytes();
+
+    // La vista general es una imagen de software: sus filas ocupan lineStride bytes, con relleno
+    if (entry->overview.isValid())
+    {
+        const juce::Image::BitmapData pixels (entry->overview, juce::Image::BitmapData::readOnly);
+        slot.bytes += (size_t) pixels.lineStride * (size_t) pixels.height;
+    }
+
+    slot.lastUsed = ++useCounter;
+    slot.entry = std::move (entry);
+
+    const auto file = slot.entry->file;
+    prefetched.push_back (std::move (slot));
+    evictOverLimit (file);
+}
+
+void Setlist::evictOverLimit (const juce::File& keep)
+{
+    // Descartar las entradas usadas hace más tiempo, salvo la que se acaba de usar
+    for (;;)
+    {
+        size_t total = 0;
+        for (const auto& slot : prefetched)
+            total += slot.bytes;
+
+        if (total <= memoryLimit || prefetched.size() <= 1)
+            return;
+
+        auto oldest = prefetched.end();
+        for (auto it = prefetched.begin(); it != prefetched.end(); ++it)
+            if (it->entry->file != keep && (oldest == prefetched.end() || it->lastUsed < oldest->lastUsed))
+                oldest = it;
+
+        if (oldest == prefetched.end())
+            return;
+
+        prefetched.erase (oldest);
+    }
+}
+
+//==============================================================================
+void Setlist::run()
+{
+    while (!threadShouldExit())
+    {
+        wait (-1);
+
+        // Preparar primero la siguiente canción y después la anterior
+        for (const int offset : { 1, -1 })
+        {
+            if (threadShouldExit())
+                return;
+
+            juce::File file;
+            int width = 0, height = 0;
+
+            {
+                const juce::ScopedLock sl (lock);
+                if (currentIndex < 0)
+                    break;
+
+                file = files[currentIndex + offset];
+                width = overviewWidth;
+                height = overviewHeight;
+
+                if (file == juce::File() || findPrefetched (file) != nullptr)
+                    continue;
+            }
+
+            if (auto entry = prepare (file, width, height))
+            {
+                const juce::ScopedLock sl (lock);
+
+                // La lista puede haber cambiado mientras se preparaba
+                if (files.contains (file))
+                    storePrefetched (entry);
+            }
+        }
+    }
+}
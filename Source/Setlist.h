@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    Setlist.h
+    Lista ordenada de canciones con precarga en segundo plano de la siguiente.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreparedSong.h"
+
+//==============================================================================
+/**
+    Mientras suena una canción, un hilo de fondo prepara la siguiente y la
+    anterior (caché en disco o lectura del SMF, índices y vista general
+    dibujada). Al avanzar, select() devuelve la entrada ya lista y el procesador
+    solo tiene que cambiar el puntero de la canción.
+
+    Las entradas precargadas tienen un límite de memoria; al superarlo se
+    descartan las usadas hace más tiempo.
+*/
+class Setlist : private juce::Thread
+{
+public:
+    // Canción lista para mostrar
+    struct Entry
+    {
+        juce::File file;
+        juce::uint64 contentHash = 0;
+        PreparedSong::Ptr song;
+        juce::Image overview;       // Vista general para el minimap (puede ser nula)
+    };
+
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    Setlist();
+    ~Setlist() override;
+
+    // Sustituye la lista; descarta las precargas que ya no pertenezcan a ella
+    void setFiles (const juce::Array<juce::File>& newFiles);
+
+    // Lista de texto: una ruta por línea (relativa a la lista o absoluta), '#' para comentarios
+    static juce::Array<juce::File> readSetlistFile (const juce::File& setlistFile);
+    static bool isSetlistFile (const juce::File& file);
+
+    int getNumSongs() const;
+    int getCurrentIndex() const;
+    juce::File getFile (int index) const;
+
+    // Devuelve la entrada del índice y programa la precarga de sus vecinas. Si no estaba
+    // precargada se prepara en el hilo que llama. Devuelve nullptr si no se puede leer.
+    EntryPtr select (int index);
+
+    // Tamaño de la vista general que se dibuja al precargar (el del minimap)
+    void setOverviewSize (int width, int height);
+
+    void setMemoryLimit (size_t bytes);
+    size_t getResidentBytes() const;
+    int getNumPrefetched() const;
+
+private:
+    struct Slot
+    {
+        EntryPtr entry;
+        size_t bytes = 0;
+        juce::uint32 lastUsed = 0;
+    };
+
+    void run() override;
+
+    EntryPtr prepare (const juce::File& file, int width, int height) const;
+    EntryPtr findPrefetched (const juce::File& file);
+    void storePrefetched (EntryPtr entry);
+    void evictOverLimit (const juce::File& keep);
+
+    mutable juce::CriticalSection lock;
+    juce::Array<juce::File> files;
+    int currentIndex = -1;
+    std::vector<Slot> prefetched;
+    juce::uint32 useCounter = 0;
+    size_t memoryLimit = 256 * 1024 * 1024;
+    int overviewWidth = 0, overviewHeight = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Setlist)
+};
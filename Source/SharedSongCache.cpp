@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    SharedSongCache.cpp
+    Caché de canciones preprocesadas compartida por todas las instancias del plugin.
+
+  ==============================================================================
+*/
+
+#include "SharedSongCache.h"
+#include "SongCacheFile.h"
+
+//==============================================================================
+SharedSongCache::SharedSongCache()
+{
+}
+
+SharedSongCache::~SharedSongCache()
+{
+}
+
+PreparedSong::Ptr SharedSongCache::getSong (const juce::File& file, juce::uint64 contentHash, const juce::MemoryBlock& embeddedSong)
+{
+    if (contentHash == 0)
+        return {};
+
+    std::shared_ptr<Slot> slot;
+
+    {
+        const juce::ScopedLock sl (lock);
+        removeExpiredSlots();
+
+        auto& found = slots[contentHash];
+        if (found == nullptr)
+            found = std::make_shared<Slot>();
+
+        slot = found;
+    }
+
+    // Si otra instancia está preparando este mismo archivo, se espera a que termine
+    const juce::ScopedLock slotLock (slot->lock);
+
+    if (auto song = slot->song.lock())
+    {
+        ++hits;
+        return song;
+    }
+
+    ++misses;
+
+    // La copia incrustada solo se acepta si sigue coincidiendo con el archivo (tamaño, fecha y hash)
+    auto song = SongCacheFile::loadFromMemory (file, contentHash, embeddedSong.getData(), embeddedSong.getSize());
+
+    if (song == nullptr)
+        song = SongCacheFile::loadOrBuild (file, contentHash);
+
+    slot->song = song;
+    return song;
+}
+
+void SharedSongCache::removeExpiredSlots()
+{
+    for (auto it = slots.begin(); it != slots.end();)
+    {
+        // Una ranura en uso por otro hilo (use_count > 1) puede estar preparándose todavía
+        if (it->second.use_count() == 1 && it->second->song.expired())
+            it = slots.erase (it);
+        else
+            ++it;
+    }
+}
+
+SharedSongCache::Statistics SharedSongCache::getStatistics() const
+{
+    Statistics statistics;
+    statistics.hits = hits;
+    statistics.misses = misses;
+
+    const juce::ScopedLock sl (lock);
+
+    for (const auto& entry : slots)
+    {
+        // Las ranuras que se están preparando aún no cuentan
+        const juce::ScopedTryLock slotLock (entry.second->lock);
+        if (!slotLock.isLocked())
+            continue;
+
+        if (auto song = entry.second->song.lock())
+        {
+            ++statistics.numSongs;
+            statistics.residentBytes += song->getMemoryBytes();
+        }
+    }
+
+    return statistics;
+}
+
+juce::String SharedSongCache::getStatisticsText() const
+{
+    const auto statistics = getStatistics();
+    return juce::String (statistics.hits) + " aciertos, " + juce::String (statistics.misses) + " fallos, "
+         + juce::String (statistics.numSongs) + " canciones en memoria ("
+         + juce::String ((double) statistics.residentBytes / (1024.0 * 1024.0), 2) + " MB)";
+}
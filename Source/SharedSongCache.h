@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    SharedSongCache.h
+    Caché de canciones preprocesadas compartida por todas las instancias del plugin.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreparedSong.h"
+
+//==============================================================================
+/**
+    Varias instancias del plugin en la misma sesión suelen abrir el mismo MIDI.
+    Esta caché, usada a través de juce::SharedResourcePointer, guarda las
+    canciones por hash de contenido: un archivo idéntico se prepara una sola vez
+    y todas las instancias comparten la misma PreparedSong inmutable.
+
+    Solo guarda referencias débiles, así que una canción se libera cuando la
+    deja de usar la última instancia.
+*/
+class SharedSongCache
+{
+public:
+    struct Statistics
+    {
+        int hits = 0;               // Canciones servidas sin prepararlas
+        int misses = 0;             // Canciones preparadas (caché en disco o SMF)
+        int numSongs = 0;           // Canciones vivas en este momento
+        size_t residentBytes = 0;   // Memoria de esas canciones
+    };
+
+    SharedSongCache();
+    ~SharedSongCache();
+
+    // Canción para este archivo: la compartida si ya está en memoria, si no la prepara.
+    // contentHash es el de SongCacheFile::computeContentHash, calculado una vez por quien carga:
+    // la caché en disco lo reutiliza sin volver a leer el archivo.
+    // Si se da una canción serializada (p. ej. la del estado del plugin) se prueba antes
+    // que la caché en disco. Devuelve nullptr si el MIDI no se puede leer.
+    PreparedSong::Ptr getSong (const juce::File& file, juce::uint64 contentHash, const juce::MemoryBlock& embeddedSong = {});
+
+    Statistics getStatistics() const;
+    juce::String getStatisticsText() const;
+
+private:
+    // Una ranura por hash; su propio lock evita preparar dos veces el mismo archivo
+    // sin bloquear la carga de archivos distintos
+    struct Slot
+    {
+        juce::CriticalSection lock;
+        std::weak_ptr<const PreparedSong> song;
+    };
+
+    void removeExpiredSlots();
+
+    mutable juce::CriticalSection lock;
+    std::map<juce::uint64, std::shared_ptr<Slot>> slots;
+    std::atomic<int> hits { 0 }, misses { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedSongCache)
+};
@@ -0,0 +1,459 @@
+/*
+  ==============================================================================
+
+    SongCacheFile.cpp
+    Caché en disco de canciones preprocesadas para reabrirlas sin parsear el MIDI.
+
+  ==============================================================================
+*/
+
+#include "SongCacheFile.h"
+
+//==============================================================================
+namespace
+{
+    // "DVSC" en orden nativo: una caché escrita con otro orden de bytes no se reconoce
+    constexpr juce::uint32 cacheMagic = 0x44565343;
+
+    juce::CriticalSection cacheDirectoryLock;
+    juce::File cacheDirectoryOverride;
+
+    template <typename Type>
+    bool writeValue (juce::OutputStream& out, const Type& value)
+    {
+        static_assert (std::is_trivially_copyable<Type>::value, "Solo tipos copiables en bloque");
+        return out.write (&value, sizeof (Type));
+    }
+
+    template <typename Type>
+    bool writeArray (juce::OutputStream& out, const std::vector<Type>& values)
+    {
+        static_assert (std::is_trivially_copyable<Type>::value, "Solo tipos copiables en bloque");
+
+        if (!writeValue (out, (juce::uint64) values.size()))
+            return false;
+
+        return values.empty() || out.write (values.data(), values.size() * sizeof (Type));
+    }
+
+    bool writeNotes (juce::OutputStream& out, const NoteStore& notes)
+    {
+        // Mismo formato que writeArray; una canción paginada se copia bloque a bloque
+        if (!writeValue (out, (juce::uint64) notes.size()))
+            return false;
+
+        for (size_t i = 0; i < notes.getNumChunks(); ++i)
+        {
+            const auto chunk = notes.getChunk (i);
+            if (chunk == nullptr || !out.write (chunk->data(), chunk->size() * sizeof (SongNote)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool writeString (juce::OutputStream& out, const juce::String& text)
+    {
+        const auto numBytes = (juce::uint32) text.getNumBytesAsUTF8();
+        return writeValue (out, numBytes) && (numBytes == 0 || out.write (text.toRawUTF8(), numBytes));
+    }
+
+    //==============================================================================
+    // Lectura secuencial con comprobación de límites sobre el bloque mapeado
+    class BlockReader
+    {
+    public:
+        BlockReader (const void* blockData, size_t blockSize)
+            : data (static_cast<const char*> (blockData)), size (blockSize)
+        {
+        }
+
+        template <typename Type>
+        bool read (Type& value)
+        {
+            static_assert (std::is_trivially_copyable<Type>::value, "Solo tipos copiables en bloque");
+
+            if (size - position < sizeof (Type))
+                return false;
+
+            std::memcpy (&value, data + position, sizeof (Type));
+            position += sizeof (Type);
+            return true;
+        }
+
+        template <typename Type>
+        bool readArray (std::vector<Type>& values)
+        {
+            juce::uint64 count = 0;
+            if (!read (count) || count > (size - position) / sizeof (Type))
+                return false;
+
+            values.resize ((size_t) count);
+
+            if (count > 0)
+                std::memcpy (values.data(), data + position, (size_t) count * sizeof (Type));
+
+            position += (size_t) count * sizeof (Type);
+            return true;
+        }
+
+        // Salta el array sin copiarlo; devuelve sus bytes (sin alinear) y su posición
+        template <typename Type>
+        bool skipArray (const void*& values, juce::uint64& count, size_t& offset)
+        {
+            if (!read (count) || count > (size - position) / sizeof (Type))
+                return false;
+
+            values = data + position;
+            offset = position;
+            position += (size_t) count * sizeof (Type);
+            return true;
+        }
+
+        bool readString (juce::String& text)
+        {
+            juce::uint32 numBytes = 0;
+            if (!read (numBytes) || numBytes > size - position)
+                return false;
+
+            text = juce::String::fromUTF8 (data + position, (int) numBytes);
+            position += numBytes;
+            return true;
+        }
+
+    private:
+        const char* data;
+        size_t size;
+        size_t position = 0;
+    };
+}
+
+//==============================================================================
+PreparedSong::Ptr SongCacheFile::load (const juce::File& songFile, juce::uint64 contentHash)
+{
+    const auto cacheFile = getCacheFileFor (songFile);
+    if (!cacheFile.existsAsFile())
+        return {};
+
+    juce::MemoryMappedFile mapped (cacheFile, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr)
+        return {};
+
+    return readSong (mapped.getData(), mapped.getSize(), songFile, contentHash, cacheFile);
+}
+
+bool SongCacheFile::save (const juce::File& songFile, juce::uint64 contentHash, const PreparedSong& song)
+{
+    const auto cacheFile = getCacheFileFor (songFile);
+    if (!cacheFile.getParentDirectory().createDirectory())
+        return false;
+
+    const auto key = makeKey (songFile, contentHash);
+
+    // Escribir en un temporal y reemplazar: una caché a medio escribir nunca queda visible
+    juce::TemporaryFile temporary (cacheFile);
+
+    {
+        juce::FileOutputStream out (temporary.getFile());
+        if (!out.openedOk() || !writeSong (out, songFile, key, song))
+            return false;
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temporary.overwriteTargetFileWithTemporary();
+}
+
+PreparedSong::Ptr SongCacheFile::loadOrBuild (const juce::File& songFile, juce::uint64 contentHash)
+{
+    // Si hay una caché válida de este archivo, la canción se usa sin parsear el SMF
+    if (auto cachedSong = load (songFile, contentHash))
+    {
+        juce::Logger::writeToLog ("Canción cargada desde la caché: " + songFile.getFileName());
+        return cachedSong;
+    }
+
+    juce::MidiFile midiFile;
+    if (!PreparedSong::readMidiFile (songFile, midiFile))
+        return {};
+
+    // Preprocesar una sola vez: notas ordenadas, resumen, pirámide de densidad y rejilla
+    auto song = PreparedSong::build (midiFile);
+
+    if (!save (songFile, contentHash, *song))
+    {
+        juce::Logger::writeToLog ("Aviso: No se pudo escribir la caché de " + songFile.getFileName());
+        return song;
+    }
+
+    // Archivos enormes: reabrir desde la caché recién escrita para dejar las notas paginadas
+    if (song->getNotes().size() > NoteStore::pagingThreshold)
+        if (auto pagedSong = load (songFile, contentHash))
+            return pagedSong;
+
+    return song;
+}
+
+bool SongCacheFile::saveToMemory (const juce::File& songFile, juce::uint64 contentHash, const PreparedSong& song, juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream out (destData, false);
+    return writeSong (out, songFile, makeKey (songFile, contentHash), song);
+}
+
+PreparedSong::Ptr SongCacheFile::loadFromMemory (const juce::File& songFile, juce::uint64 contentHash, const void* data, size_t size)
+{
+    if (data == nullptr || size == 0)
+        return {};
+
+    return readSong (data, size, songFile, contentHash, {});
+}
+
+void SongCacheFile::remove (const juce::File& songFile)
+{
+    getCacheFileFor (songFile).deleteFile();
+}
+
+juce::uint64 SongCacheFile::computeContentHash (const juce::File& file)
+{
+    juce::MemoryMappedFile mapped (file, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr)
+        return 0;
+
+    auto hash = (juce::uint64) 0xcbf29ce484222325ULL;
+    const auto* bytes = static_cast<const juce::uint8*> (mapped.getData());
+
+    for (size_t i = 0; i < mapped.getSize(); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+juce::File SongCacheFile::getCacheDirectory()
+{
+    {
+        const juce::ScopedLock sl (cacheDirectoryLock);
+
+        if (cacheDirectoryOverride != juce::File())
+            return cacheDirectoryOverride;
+    }
+
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("drumVisualizer")
+               .getChildFile ("SongCache");
+}
+
+void SongCacheFile::setCacheDirectoryOverride (const juce::File& directory)
+{
+    const juce::ScopedLock sl (cacheDirectoryLock);
+    cacheDirectoryOverride = directory;
+}
+
+juce::File SongCacheFile::getCacheFileFor (const juce::File& songFile)
+{
+    // Un archivo por ruta; la ruta completa se guarda dentro para descartar colisiones
+    const auto pathHash = (juce::uint64) songFile.getFullPathName().hashCode64();
+    return getCacheDirectory().getChildFile (juce::String::toHexString ((juce::int64) pathHash) + ".dvcache");
+}
+
+//==============================================================================
+SongCacheFile::Key SongCacheFile::makeKey (const juce::File& songFile, juce::uint64 contentHash)
+{
+    Key key;
+    key.fileSize = songFile.getSize();
+    key.modificationTime = songFile.getLastModificationTime().toMilliseconds();
+    key.contentHash = contentHash;
+    return key;
+}
+
+bool SongCacheFile::writeSong (juce::OutputStream& out, const juce::File& songFile, const Key& key, const PreparedSong& song)
+{
+    const auto& density = song.density;
+    const auto& grid = song.beatGrid;
+
+    bool ok = writeValue (out, cacheMagic)
+           && writeValue (out, formatVersion)
+           && writeValue (out, (juce::uint32) sizeof (SongNote))
+           && writeValue (out, (juce::uint32) sizeof (BeatGrid::Line))
+           && writeString (out, songFile.getFullPathName())
+           && writeValue (out, key)
+           && writeValue (out, song.summary)
+           && writeNotes (out, song.notes)
+           && writeValue (out, density.firstLaneForNote)
+           && writeArray (out, density.lanes)
+           && writeValue (out, (juce::uint32) density.levels.size());
+
+    for (size_t i = 0; ok && i < density.levels.size(); ++i)
+    {
+        const auto& level = density.levels[i];
+        ok = writeValue (out, level.bucketSeconds)
+          && writeValue (out, level.numBuckets)
+          && writeArray (out, level.counts)
+          && writeArray (out, level.maxVelocities);
+    }
+
+    ok = ok
+      && writeArray (out, grid.tempoSegments)
+      && writeArray (out, grid.lines)
+      && writeValue (out, (juce::uint32) song.tracks.size());
+
+    for (size_t i = 0; ok && i < song.tracks.size(); ++i)
+    {
+        const auto& track = song.tracks[i];
+        ok = writeString (out, track.name)
+          && writeValue (out, track.numNotes)
+          && writeValue (out, track.channels)
+          && writeValue (out, (juce::uint64) (track.notes >> 64).to_ullong())
+          && writeValue (out, (juce::uint64) (track.notes & std::bitset<128> (~0ULL)).to_ullong());
+    }
+
+    // Solo tiempos y valores: la pirámide de cada carril se rehace al leer
+    const auto& lanes = song.controllers.lanes;
+    ok = ok && writeValue (out, (juce::uint32) lanes.size());
+
+    for (size_t i = 0; ok && i < lanes.size(); ++i)
+        ok = writeValue (out, (juce::int32) lanes[i].controller)
+          && writeArray (out, lanes[i].times)
+          && writeArray (out, lanes[i].values);
+
+    return ok;
+}
+
+PreparedSong::Ptr SongCacheFile::readSong (const void* data, size_t size, const juce::File& songFile, juce::uint64 contentHash,
+                                           const juce::File& pagingFile)
+{
+    BlockReader reader (data, size);
+
+    juce::uint32 magic = 0, version = 0, noteSize = 0, lineSize = 0;
+    juce::String path;
+    Key storedKey;
+
+    if (!reader.read (magic) || magic != cacheMagic
+        || !reader.read (version) || version != formatVersion
+        || !reader.read (noteSize) || noteSize != sizeof (SongNote)
+        || !reader.read (lineSize) || lineSize != sizeof (BeatGrid::Line)
+        || !reader.readString (path) || path != songFile.getFullPathName()
+        || !reader.read (storedKey))
+        return {};
+
+    // El hash lo da quien carga: validar la clave no vuelve a leer el MIDI
+    const auto currentKey = makeKey (songFile, contentHash);
+    if (contentHash == 0
+        || storedKey.fileSize != currentKey.fileSize
+        || storedKey.modificationTime != currentKey.modificationTime
+        || storedKey.contentHash != currentKey.contentHash)
+        return {};
+
+    std::shared_ptr<PreparedSong> song (new PreparedSong());
+    auto& density = song->density;
+    juce::uint32 numLevels = 0;
+
+    const void* mappedNotes = nullptr;
+    juce::uint64 numNotes = 0;
+    size_t notesOffset = 0;
+
+    if (!reader.read (song->summary)
+        || !reader.skipArray<SongNote> (mappedNotes, numNotes, notesOffset))
+        return {};
+
+    // Con millones de notas solo se crea el índice de bloques; las notas se leen del archivo
+    // de caché según avanza la reproducción. Si no, se copian en bloque como el resto.
+    if (pagingFile != juce::File() && numNotes > NoteStore::pagingThreshold)
+    {
+        if (!song->notes.openPaged (pagingFile, (juce::int64) notesOffset, (size_t) numNotes, mappedNotes))
+            return {};
+    }
+    else
+    {
+        std::vector<SongNote> notes ((size_t) numNotes);
+        if (numNotes > 0)
+            std::memcpy (notes.data(), mappedNotes, (size_t) numNotes * sizeof (SongNote));
+
+        song->notes.setNotes (std::move (notes));
+    }
+
+    if (!reader.read (density.firstLaneForNote)
+        || !reader.readArray (density.lanes)
+        || !reader.read (numLevels)
+        || numLevels > 64)
+        return {};
+
+    // Una caché dañada o de otra versión no puede apuntar fuera de los carriles: se reconstruye
+    const auto& firstLanes = density.firstLaneForNote;
+
+    if (firstLanes.front() != 0 || firstLanes.back() != density.getNumLanes()
+        || !std::is_sorted (firstLanes.begin(), firstLanes.end()))
+        return {};
+
+    for (int noteNumber = 0; noteNumber < 128; ++noteNumber)
+        for (int lane = firstLanes[(size_t) noteNumber]; lane < firstLanes[(size_t) noteNumber + 1]; ++lane)
+            if (density.lanes[(size_t) lane].noteNumber != noteNumber)
+                return {};
+
+    density.levels.resize (numLevels);
+
+    for (auto& level : density.levels)
+    {
+        if (!reader.read (level.bucketSeconds)
+            || !reader.read (level.numBuckets)
+            || level.numBuckets < 0
+            || !reader.readArray (level.counts)
+            || !reader.readArray (level.maxVelocities)
+            || level.counts.size() != (size_t) density.getNumLanes() * (size_t) level.numBuckets
+            || level.maxVelocities.size() != level.counts.size())
+            return {};
+    }
+
+    juce::uint32 numTracks = 0;
+
+    if (!reader.readArray (song->beatGrid.tempoSegments)
+        || !reader.readArray (song->beatGrid.lines)
+        || song->beatGrid.tempoSegments.empty()
+        || !reader.read (numTracks)
+        || numTracks > 65536)
+        return {};
+
+    song->tracks.resize (numTracks);
+
+    for (auto& track : song->tracks)
+    {
+        juce::uint64 highNotes = 0, lowNotes = 0;
+
+        if (!reader.readString (track.name)
+            || !reader.read (track.numNotes)
+            || !reader.read (track.channels)
+            || !reader.read (highNotes)
+            || !reader.read (lowNotes))
+            return {};
+
+        track.notes = (std::bitset<128> (highNotes) << 64) | std::bitset<128> (lowNotes);
+    }
+
+    juce::uint32 numLanes = 0;
+    if (!reader.read (numLanes) || numLanes > 128)
+        return {};
+
+    auto& lanes = song->controllers.lanes;
+    lanes.resize (numLanes);
+
+    for (auto& lane : lanes)
+    {
+        juce::int32 controller = 0;
+
+        if (!reader.read (controller)
+            || !juce::isPositiveAndBelow (controller, 128)
+            || !reader.readArray (lane.times)
+            || !reader.readArray (lane.values)
+            || lane.values.size() != lane.times.size())
+            return {};
+
+        lane.controller = controller;
+        lane.buildPyramid();
+    }
+
+    return song;
+}
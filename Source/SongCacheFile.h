@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    SongCacheFile.h
+    Caché en disco de canciones preprocesadas para reabrirlas sin parsear el MIDI.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreparedSong.h"
+
+//==============================================================================
+/**
+    Guarda una PreparedSong (resumen, notas ordenadas, pirámide de densidad,
+    rejilla de tiempo, curvas de controladores y resumen de pistas) en un archivo binario compacto dentro del directorio de
+    datos de usuario. La clave es la ruta del MIDI más su tamaño, fecha de
+    modificación y hash del contenido; si algo no coincide la caché se ignora.
+
+    Al reabrir, el archivo se mapea en memoria y los arrays se copian en bloque,
+    sin decodificar eventos MIDI ni repetir la conversión de ticks a segundos.
+    En archivos con millones de notas las notas no se copian: se leen por bloques
+    del propio archivo de caché (ver NoteStore).
+*/
+class SongCacheFile
+{
+public:
+    // contentHash es siempre el del MIDI tal como está ahora (computeContentHash), calculado una
+    // sola vez por quien carga: nada de aquí vuelve a leer el archivo entero para validar la clave.
+
+    // Canción guardada para este MIDI, o nullptr si no hay caché válida
+    static PreparedSong::Ptr load (const juce::File& songFile, juce::uint64 contentHash);
+
+    // Escribe (o reemplaza) la caché de este MIDI. Devuelve false si no se pudo escribir.
+    static bool save (const juce::File& songFile, juce::uint64 contentHash, const PreparedSong& song);
+
+    // Canción de la caché si es válida; si no, lee el MIDI, la construye y actualiza la caché.
+    // Devuelve nullptr si el MIDI no se puede leer.
+    static PreparedSong::Ptr loadOrBuild (const juce::File& songFile, juce::uint64 contentHash);
+
+    // Mismo formato en memoria, p. ej. para incrustar la canción en el estado del plugin
+    static bool saveToMemory (const juce::File& songFile, juce::uint64 contentHash, const PreparedSong& song, juce::MemoryBlock& destData);
+    static PreparedSong::Ptr loadFromMemory (const juce::File& songFile, juce::uint64 contentHash, const void* data, size_t size);
+
+    // Elimina la caché de este MIDI si existe
+    static void remove (const juce::File& songFile);
+
+    // Hash FNV-1a de 64 bits del contenido del archivo (0 si no se puede leer)
+    static juce::uint64 computeContentHash (const juce::File& file);
+
+    static juce::File getCacheDirectory();
+
+    // Otro directorio para todas las cachés del proceso (p. ej. uno temporal para el benchmark,
+    // que así no borra las del usuario); juce::File() vuelve al directorio de datos de usuario
+    static void setCacheDirectoryOverride (const juce::File& directory);
+    static juce::File getCacheFileFor (const juce::File& songFile);
+
+private:
+    struct Key
+    {
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;   // Milisegundos desde 1970
+        juce::uint64 contentHash = 0;
+    };
+
+    static Key makeKey (const juce::File& songFile, juce::uint64 contentHash);
+
+    static bool writeSong (juce::OutputStream& out, const juce::File& songFile, const Key& key, const PreparedSong& song);
+    // Con pagingFile (el archivo de donde viene el bloque) las canciones enormes quedan paginadas
+    static PreparedSong::Ptr readSong (const void* data, size_t size, const juce::File& songFile, juce::uint64 contentHash,
+                                       const juce::File& pagingFile);
+
+    // Se incrementa cuando cambia el formato o la disposición de SongNote/BeatGrid::Line
+    static constexpr juce::uint32 formatVersion = 4;
+};
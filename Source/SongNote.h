@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+
+    SongNote.h
+    Golpe (Note On) preprocesado de una canción cargada.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Note On con velocidad > 0, con el tiempo ya convertido a segundos
+struct SongNote
+{
+    double time = 0.0;          // Segundos desde el inicio del archivo
+    juce::uint16 track = 0;     // Índice de pista en el SMF
+    juce::uint8 noteNumber = 0;
+    juce::uint8 velocity = 0;
+    juce::uint8 channel = 1;    // 1..16, como juce::MidiMessage::getChannel()
+};
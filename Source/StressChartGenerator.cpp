@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    StressChartGenerator.cpp
+    Generador de archivos MIDI (SMF) sintéticos para pruebas de escala.
+
+  ==============================================================================
+*/
+
+#include "StressChartGenerator.h"
+
+namespace
+{
+    const int drumChannel = 9; // Canal 10 (GM percusión), base 0
+
+    // Segmento del mapa de tempo generado
+    struct TempoSegment
+    {
+        juce::int64 tick;
+        double seconds;
+        double bpm;
+    };
+
+    // Escribe los eventos de una pista con deltas en formato de longitud variable
+    struct TrackWriter
+    {
+        void writeVariableLength (juce::uint32 value)
+        {
+            juce::uint8 bytes[5];
+            int numBytes = 0;
+            bytes[numBytes++] = (juce::uint8) (value & 0x7f);
+
+            while ((value >>= 7) != 0)
+                bytes[numBytes++] = (juce::uint8) ((value & 0x7f) | 0x80);
+
+            while (numBytes > 0)
+                data.writeByte ((char) bytes[--numBytes]);
+        }
+
+        void writeDelta (juce::int64 tick)
+        {
+            jassert (tick >= lastTick);
+            writeVariableLength ((juce::uint32) (tick - lastTick));
+            lastTick = tick;
+        }
+
+        void shortMessage (juce::int64 tick, int status, int data1, int data2)
+        {
+            writeDelta (tick);
+            data.writeByte ((char) status);
+            data.writeByte ((char) data1);
+            data.writeByte ((char) data2);
+        }
+
+        void metaEvent (juce::int64 tick, int type, const void* bytes, int numBytes)
+        {
+            writeDelta (tick);
+            data.writeByte ((char) 0xff);
+            data.writeByte ((char) type);
+            writeVariableLength ((juce::uint32) numBytes);
+
+            if (numBytes > 0)
+                data.write (bytes, (size_t) numBytes);
+        }
+
+        void trackName (const juce::String& name)
+        {
+            const auto utf8 = name.toStdString();
+            metaEvent (0, 0x03, utf8.data(), (int) utf8.size());
+        }
+
+        void endOfTrack (juce::int64 tick)
+        {
+            metaEvent (juce::jmax (tick, lastTick), 0x2f, nullptr, 0);
+        }
+
+        bool writeChunkTo (juce::OutputStream& output) const
+        {
+            return output.write ("MTrk", 4)
+                && output.writeIntBigEndian ((int) data.getDataSize())
+                && output.write (data.getData(), data.getDataSize());
+        }
+
+        juce::MemoryOutputStream data;
+        juce::int64 lastTick = 0;
+    };
+
+    juce::Array<TempoSegment> buildTempoMap (const StressChartGenerator::Options& options, juce::int64& totalTicks)
+    {
+        juce::Array<TempoSegment> segments;
+        juce::Random random (options.seed);
+
+        const double segmentSeconds = options.tempoChangesPerMinute > 0.0 ? 60.0 / options.tempoChangesPerMinute
+                                                                          : options.lengthSeconds;
+        juce::int64 tick = 0;
+        double seconds = 0.0;
+
+        do
+        {
+            const double bpm = options.minBpm + (options.maxBpm - options.minBpm) * random.nextDouble();
+            segments.add ({ tick, seconds, bpm });
+
+            const double duration = juce::jmin (segmentSeconds, options.lengthSeconds - seconds);
+            const auto ticks = juce::jmax ((juce::int64) 1,
+                                           (juce::int64) std::llround (duration * bpm / 60.0 * options.ticksPerQuarter));
+            tick += ticks;
+            seconds += (double) ticks * 60.0 / (bpm * options.ticksPerQuarter);
+        }
+        while (seconds < options.lengthSeconds);
+
+        totalTicks = tick;
+        return segments;
+    }
+}
+
+//==============================================================================
+juce::Array<int> StressChartGenerator::getDrumKeysByPriority()
+{
+    juce::Array<int> keys { 36, 38, 42, 46, 44, 49, 51, 45, 48, 50, 47, 43, 41, 57, 52, 55, 53, 37, 39, 35, 40 };
+
+    for (int key = 35; key <= 81; ++key)
+        keys.addIfNotAlreadyThere (key);
+
+    return keys;
+}
+
+double StressChartGenerator::getNoteEventsPerSecond (const Options& options)
+{
+    const double averageBpm = (options.minBpm + options.maxBpm) * 0.5;
+    const int numKeys = juce::jlimit (1, 47, options.numKeys);
+    return 2.0 * numKeys * options.hitProbability * options.stepsPerQuarter * averageBpm / 60.0;
+}
+
+bool StressChartGenerator::writeToFile (const Options& options, const juce::File& file)
+{
+    file.deleteFile();
+    juce::FileOutputStream output (file);
+
+    if (!output.openedOk())
+        return false;
+
+    if (!write (options, output))
+        return false;
+
+    output.flush();
+    return output.getStatus().wasOk();
+}
+
+bool StressChartGenerator::write (const Options& options, juce::OutputStream& output)
+{
+    const int ppq = juce::jlimit (24, 0x7fff, options.ticksPerQuarter);
+    const int stepTicks = juce::jmax (2, ppq / juce::jmax (1, options.stepsPerQuarter));
+    const int numNoteTracks = juce::jmax (1, options.numTracks);
+
+    auto sanitised = options;
+    sanitised.ticksPerQuarter = ppq;
+    sanitised.lengthSeconds = juce::jmax (1.0, options.lengthSeconds);
+    sanitised.minBpm = juce::jlimit (20.0, 400.0, options.minBpm);
+    sanitised.maxBpm = juce::jlimit (sanitised.minBpm, 400.0, options.maxBpm);
+
+    juce::int64 totalTicks = 0;
+    const auto tempoMap = buildTempoMap (sanitised, totalTicks);
+
+    juce::OwnedArray<TrackWriter> tracks;
+
+    //==========================================================================
+    // Pista 0: nombre, compás 4/4 y mapa de tempo
+    {
+        auto* conductor = tracks.add (new TrackWriter());
+        conductor->trackName ("Tempo");
+
+        const juce::uint8 timeSignature[] = { 4, 2, 24, 8 };
+        conductor->metaEvent (0, 0x58, timeSignature, 4);
+
+        for (const auto& segment : tempoMap)
+        {
+            const auto microsecondsPerQuarter = (juce::uint32) std::llround (60000000.0 / segment.bpm);
+            const juce::uint8 tempo[] = { (juce::uint8) (microsecondsPerQuarter >> 16),
+                                          (juce::uint8) (microsecondsPerQuarter >> 8),
+                                          (juce::uint8) microsecondsPerQuarter };
+            conductor->metaEvent (segment.tick, 0x51, tempo, 3);
+        }
+
+        conductor->endOfTrack (totalTicks);
+    }
+
+    //==========================================================================
+    // Pistas de notas: las teclas se reparten entre pistas de forma cíclica
+    const auto allKeys = getDrumKeysByPriority();
+    const int numKeys = juce::jlimit (1, allKeys.size(), options.numKeys);
+    const juce::int64 numSteps = totalTicks / stepTicks;
+
+    for (int trackIndex = 0; trackIndex < numNoteTracks; ++trackIndex)
+    {
+        auto* track = tracks.add (new TrackWriter());
+        track->trackName ("Drums " + juce::String (trackIndex + 1));
+
+        juce::Array<int> trackKeys;
+        for (int k = trackIndex; k < numKeys; k += numNoteTracks)
+            trackKeys.add (allKeys[k]);
+
+        // Cada pista usa su propio generador para que su contenido no dependa del resto
+        juce::Random random (options.seed * 7919 + trackIndex + 1);
+        juce::Array<int> hitKeys;
+
+        for (juce::int64 step = 0; step < numSteps && trackKeys.size() > 0; ++step)
+        {
+            const juce::int64 tick = step * stepTicks;
+            hitKeys.clearQuick();
+
+            for (auto key : trackKeys)
+            {
+                if (random.nextDouble() < options.hitProbability)
+                {
+                    track->shortMessage (tick, 0x90 | drumChannel, key, 40 + random.nextInt (88));
+                    hitKeys.add (key);
+                }
+            }
+
+            for (auto key : hitKeys)
+                track->shortMessage (tick + stepTicks / 2, 0x80 | drumChannel, key, 0);
+        }
+
+        track->endOfTrack (totalTicks);
+    }
+
+    //==========================================================================
+    // Pista de CC4 (apertura del hi-hat) como paseo aleatorio
+    if (options.ccPerSecond > 0.0)
+    {
+        auto* track = tracks.add (new TrackWriter());
+        track->trackName ("CC4");
+
+        juce::Random random (options.seed * 104729 + 1);
+        const auto numControllers = (juce::int64) (sanitised.lengthSeconds * options.ccPerSecond);
+        int value = 0;
+        int segmentIndex = 0;
+
+        for (juce::int64 i = 0; i < numControllers; ++i)
+        {
+            const double seconds = (double) i / options.ccPerSecond;
+
+            while (segmentIndex + 1 < tempoMap.size() && tempoMap[segmentIndex + 1].seconds <= seconds)
+                ++segmentIndex;
+
+            const auto& segment = tempoMap.getReference (segmentIndex);
+            const auto tick = juce::jmin (totalTicks,
+                                          segment.tick + (juce::int64) ((seconds - segment.seconds) * segment.bpm / 60.0 * ppq));
+
+            value = juce::jlimit (0, 127, value + random.nextInt (17) - 8);
+            track->shortMessage (juce::jmax (tick, track->lastTick), 0xb0 | drumChannel, 4, value);
+        }
+
+        track->endOfTrack (totalTicks);
+    }
+
+    //==========================================================================
+    // Cabecera MThd: formato 1, número de pistas y resolución
+    bool ok = output.write ("MThd", 4)
+           && output.writeIntBigEndian (6)
+           && output.writeShortBigEndian (1)
+           && output.writeShortBigEndian ((short) tracks.size())
+           && output.writeShortBigEndian ((short) ppq);
+
+    for (auto* track : tracks)
+        ok = ok && track->writeChunkTo (output);
+
+    return ok;
+}
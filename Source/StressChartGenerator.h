@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    StressChartGenerator.h
+    Generador de archivos MIDI (SMF) sintéticos para pruebas de escala.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Escribe archivos SMF formato 1 válidos con número de pistas, densidad de
+    cambios de tempo, densidad de notas, densidad de CC y duración controlables.
+    Para una misma semilla y opciones la salida es idéntica byte a byte.
+*/
+class StressChartGenerator
+{
+public:
+    struct Options
+    {
+        int numTracks = 1;                  // Pistas de notas (además de la pista de tempo)
+        double lengthSeconds = 180.0;       // Duración aproximada de la canción
+        double minBpm = 120.0;              // Rango de tempo
+        double maxBpm = 120.0;
+        double tempoChangesPerMinute = 0.0; // 0 = tempo fijo
+        int stepsPerQuarter = 4;            // 4 = semicorcheas, 16 = garrapateas (blast beats)
+        int numKeys = 3;                    // Teclas GM de percusión usadas (1..47)
+        double hitProbability = 1.0;        // Probabilidad de golpe por tecla y paso
+        double ccPerSecond = 0.0;           // Densidad de CC4 (pedal de hi-hat)
+        int ticksPerQuarter = 960;
+        juce::int64 seed = 1;
+    };
+
+    // Número aproximado de eventos de nota (On + Off) por segundo para unas opciones dadas
+    static double getNoteEventsPerSecond (const Options& options);
+
+    static bool write (const Options& options, juce::OutputStream& output);
+    static bool writeToFile (const Options& options, const juce::File& file);
+
+    // Teclas GM de percusión (35..81) ordenadas por relevancia en un kit típico
+    static juce::Array<int> getDrumKeysByPriority();
+};
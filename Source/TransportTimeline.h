@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    TransportTimeline.h
+    Correspondencia entre muestras de audio y segundos de la canción.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Reloj del hilo de audio: la muestra n (contada desde el ancla) suena en
+// anchorSeconds + n * secondsPerSample. Los extremos de cada bloque se calculan
+// desde el ancla y nunca sumando duraciones de bloque, así que el final de un
+// bloque es exactamente el inicio del siguiente sea cual sea su tamaño.
+struct TransportTimeline
+{
+    double anchorSeconds = 0.0;
+    double secondsPerSample = 1.0 / 44100.0;   // Segundos de canción por muestra (incluye la velocidad)
+    juce::int64 firstSample = 0;                // Primera muestra del bloque desde el ancla
+
+    double getSeconds (juce::int64 sample) const
+    {
+        return anchorSeconds + (double) sample * secondsPerSample;
+    }
+
+    // Primera muestra cuyo tiempo alcanza seconds
+    juce::int64 getSampleAtOrAfter (double seconds) const
+    {
+        return (juce::int64) std::ceil ((seconds - anchorSeconds) / secondsPerSample);
+    }
+
+    // Posición dentro del bloque [firstSample, firstSample + numSamples) de un evento en seconds
+    int getOffsetInBlock (double seconds, int numSamples) const
+    {
+        return (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples - 1, getSampleAtOrAfter (seconds) - firstSample);
+    }
+};
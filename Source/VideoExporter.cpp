@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    VideoExporter.cpp
+    Exportación offline del piano roll frame a frame con un pool de hilos.
+
+  ==============================================================================
+*/
+
+#include "VideoExporter.h"
+
+#include <map>
+
+//==============================================================================
+VideoExporter::VideoExporter (const DrumVisualizerAudioProcessor& processor, const Options& exportOptions)
+    : audioProcessor (processor), renderer (processor), options (exportOptions)
+{
+    options.width = juce::jmax (64, options.width);
+    options.height = juce::jmax (64, options.height);
+    options.framesPerSecond = juce::jlimit (1.0, 240.0, options.framesPerSecond);
+
+    // El vídeo muestra la vista en reproducción desde la primera nota (como al pulsar PLAY tras STOP)
+    options.viewState.isPlaying = true;
+
+    startTime = options.startTime >= 0.0 ? options.startTime : audioProcessor.getFirstNoteTime();
+    const double endTime = options.endTime >= 0.0 ? options.endTime : audioProcessor.getLengthInSeconds();
+
+    // El tiempo de la canción avanza a scrollSpeed segundos por segundo de vídeo
+    const double scrollSpeed = PianoRollRenderer::getScrollSpeed (options.viewState.bpm, options.viewState.speed);
+    const double videoSeconds = scrollSpeed > 0.0 ? juce::jmax (0.0, endTime - startTime) / scrollSpeed : 0.0;
+    numFrames = audioProcessor.hasMidiLoaded() ? (int) std::ceil (videoSeconds * options.framesPerSecond) : 0;
+}
+
+VideoExporter::~VideoExporter()
+{
+}
+
+int VideoExporter::getNumFrames() const
+{
+    return numFrames;
+}
+
+juce::Image VideoExporter::renderFrame (int frameIndex) const
+{
+    auto state = options.viewState;
+    const double scrollSpeed = PianoRollRenderer::getScrollSpeed (state.bpm, state.speed);
+    state.currentTime = startTime + (frameIndex / options.framesPerSecond) * scrollSpeed;
+
+    // Imagen de software: cada hilo dibuja en su propia imagen sin tocar el hilo de mensajes
+    juce::Image image (juce::Image::ARGB, options.width, options.height, true, juce::SoftwareImageType());
+    juce::Graphics g (image);
+    g.fillAll (juce::Colour::fromString ("#404040"));
+    renderer.render (g, image.getBounds().reduced (10), state);
+    return image;
+}
+
+//==============================================================================
+bool VideoExporter::exportToDirectory (const juce::File& directory)
+{
+    options.format = Format::pngSequence;
+
+    if (!directory.createDirectory())
+        return false;
+
+    return run ([&directory] (int frameIndex, const juce::MemoryBlock& encodedFrame)
+    {
+        auto file = directory.getChildFile ("frame_" + juce::String (frameIndex).paddedLeft ('0', 6) + ".png");
+        return file.replaceWithData (encodedFrame.getData(), encodedFrame.getSize());
+    });
+}
+
+bool VideoExporter::exportToStream (juce::OutputStream& output)
+{
+    if (options.format == Format::pngSequence)
+        options.format = Format::y4m;
+
+    if (options.format == Format::y4m)
+    {
+        const auto header = getY4mHeader();
+        if (!output.write (header.toRawUTF8(), header.getNumBytesAsUTF8()))
+            return false;
+    }
+
+    const bool ok = run ([&output] (int, const juce::MemoryBlock& encodedFrame)
+    {
+        return output.write (encodedFrame.getData(), encodedFrame.getSize());
+    });
+
+    output.flush();
+    return ok;
+}
+
+//==============================================================================
+bool VideoExporter::run (const FrameWriter& writer)
+{
+    const int numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+
+    // Limitar los frames en vuelo para acotar la memoria mientras se espera al más antiguo
+    const int maxFramesInFlight = numThreads * 2;
+
+    juce::ThreadPool pool (numThreads);
+    juce::CriticalSection finishedLock;
+    std::map<int, juce::MemoryBlock> finishedFrames;
+    juce::WaitableEvent frameFinished;
+    std::atomic<bool> cancelled { false };
+
+    int nextToSubmit = 0;
+    bool ok = true;
+
+    for (int nextToWrite = 0; nextToWrite < numFrames && ok; ++nextToWrite)
+    {
+        while (nextToSubmit < numFrames && nextToSubmit - nextToWrite < maxFramesInFlight)
+        {
+            const int frameIndex = nextToSubmit++;
+
+            pool.addJob ([this, frameIndex, &finishedLock, &finishedFrames, &frameFinished, &cancelled]
+            {
+                if (cancelled)
+                    return;
+
+                auto encodedFrame = encodeFrame (renderFrame (frameIndex));
+
+                {
+                    const juce::ScopedLock sl (finishedLock);
+                    finishedFrames[frameIndex] = std::move (encodedFrame);
+                }
+
+                frameFinished.signal();
+            });
+        }
+
+        // Esperar al siguiente frame en orden; los posteriores quedan en el mapa
+        juce::MemoryBlock frame;
+
+        for (;;)
+        {
+            {
+                const juce::ScopedLock sl (finishedLock);
+                auto found = finishedFrames.find (nextToWrite);
+
+                if (found != finishedFrames.end())
+                {
+                    frame = std::move (found->second);
+                    finishedFrames.erase (found);
+                    break;
+                }
+            }
+
+            frameFinished.wait (100);
+        }
+
+        ok = writer (nextToWrite, frame);
+
+        if (ok && onProgress != nullptr)
+            ok = onProgress (nextToWrite + 1, numFrames);
+    }
+
+    cancelled = true;
+    pool.removeAllJobs (true, 10000);
+    return ok;
+}
+
+juce::MemoryBlock VideoExporter::encodeFrame (const juce::Image& image) const
+{
+    if (options.format == Format::pngSequence)
+    {
+        juce::MemoryOutputStream stream;
+        juce::PNGImageFormat png;
+        png.writeImageToStream (image, stream);
+        return stream.getMemoryBlock();
+    }
+
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+    const juce::Image::BitmapData bitmap (image, juce::Image::BitmapData::readOnly);
+
+    if (options.format == Format::rawRgba)
+    {
+        juce::MemoryBlock block ((size_t) (width * height * 4));
+        auto* dest = static_cast<juce::uint8*> (block.getData());
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                // El fondo es opaco, así que el alfa premultiplicado no altera los canales
+                const auto* pixel = reinterpret_cast<const juce::PixelARGB*> (bitmap.getPixelPointer (x, y));
+                *dest++ = pixel->getRed();
+                *dest++ = pixel->getGreen();
+                *dest++ = pixel->getBlue();
+                *dest++ = pixel->getAlpha();
+            }
+        }
+
+        return block;
+    }
+
+    // Y4M 4:4:4: cabecera de frame y planos Y, U, V completos (BT.601, rango limitado)
+    const char frameHeader[] = "FRAME\n";
+    const size_t headerSize = sizeof (frameHeader) - 1;
+    const size_t planeSize = (size_t) (width * height);
+
+    juce::MemoryBlock block (headerSize + planeSize * 3);
+    auto* data = static_cast<juce::uint8*> (block.getData());
+    std::memcpy (data, frameHeader, headerSize);
+
+    auto* yPlane = data + headerSize;
+    auto* uPlane = yPlane + planeSize;
+    auto* vPlane = uPlane + planeSize;
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const auto* pixel = reinterpret_cast<const juce::PixelARGB*> (bitmap.getPixelPointer (x, y));
+            const int r = pixel->getRed();
+            const int g = pixel->getGreen();
+            const int b = pixel->getBlue();
+
+            *yPlane++ = (juce::uint8) (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            *uPlane++ = (juce::uint8) (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            *vPlane++ = (juce::uint8) (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    return block;
+}
+
+juce::String VideoExporter::getY4mHeader() const
+{
+    // Frame rate como fracción: entero si es exacto, si no en milésimas (p. ej. 29.97)
+    const double fps = options.framesPerSecond;
+    const juce::String frameRate = juce::approximatelyEqual (fps, std::round (fps))
+                                       ? juce::String ((int) std::round (fps)) + ":1"
+                                       : juce::String ((int) std::round (fps * 1000.0)) + ":1000";
+
+    return "YUV4MPEG2 W" + juce::String (options.width)
+         + " H" + juce::String (options.height)
+         + " F" + frameRate
+         + " Ip A1:1 C444\n";
+}
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    VideoExporter.h
+    Exportación offline del piano roll frame a frame con un pool de hilos.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PianoRollRenderer.h"
+
+//==============================================================================
+/**
+    Renderiza el piano roll a una tasa de frames y resolución fijas sobre
+    juce::Image fuera de pantalla. Los frames son independientes entre sí (el
+    dibujo es función pura del tiempo), así que se reparten en un ThreadPool y
+    se escriben en orden como secuencia PNG o como flujo RGBA crudo / Y4M.
+*/
+class VideoExporter
+{
+public:
+    enum class Format
+    {
+        pngSequence,    // frame_000000.png, frame_000001.png, ... en un directorio
+        rawRgba,        // RGBA de 8 bits por canal, frames concatenados
+        y4m             // YUV4MPEG2 4:4:4, listo para ffmpeg
+    };
+
+    struct Options
+    {
+        int width = 1280;
+        int height = 720;
+        double framesPerSecond = 60.0;
+        Format format = Format::pngSequence;
+        int numThreads = 0;         // 0 = un hilo por núcleo
+        double startTime = -1.0;    // < 0 = primera nota
+        double endTime = -1.0;      // < 0 = final del MIDI
+        PianoRollRenderer::ViewState viewState;
+    };
+
+    VideoExporter (const DrumVisualizerAudioProcessor& processor, const Options& options);
+    ~VideoExporter();
+
+    int getNumFrames() const;
+
+    // Exporta como secuencia PNG dentro del directorio indicado
+    bool exportToDirectory (const juce::File& directory);
+
+    // Exporta como flujo RGBA / Y4M (p. ej. stdout para canalizar a un codificador)
+    bool exportToStream (juce::OutputStream& output);
+
+    // Se llama desde el hilo que escribe tras cada frame; devolver false cancela
+    std::function<bool (int framesWritten, int totalFrames)> onProgress;
+
+    // Renderiza un frame concreto (útil también para previsualizar)
+    juce::Image renderFrame (int frameIndex) const;
+
+private:
+    using FrameWriter = std::function<bool (int frameIndex, const juce::MemoryBlock& encodedFrame)>;
+
+    bool run (const FrameWriter& writer);
+    juce::MemoryBlock encodeFrame (const juce::Image& image) const;
+    juce::String getY4mHeader() const;
+
+    const DrumVisualizerAudioProcessor& audioProcessor;
+    PianoRollRenderer renderer;
+    Options options;
+    double startTime = 0.0;
+    int numFrames = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VideoExporter)
+};
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    WaveformMipmap.cpp
+    Historial de picos de la entrada en varias resoluciones, para dibujarlo.
+
+  ==============================================================================
+*/
+
+#include "WaveformMipmap.h"
+
+//==============================================================================
+WaveformMipmap::WaveformMipmap()
+{
+    for (auto& level : levels)
+        level.peaks.resize ((size_t) levelSize);
+}
+
+void WaveformMipmap::clear()
+{
+    for (auto& level : levels)
+    {
+        level.count = 0;
+        level.hasPending = false;
+    }
+}
+
+void WaveformMipmap::add (const Peak& peak)
+{
+    if (!isEmpty())
+    {
+        const double lastTime = levels[0].get (levels[0].count - 1).time;
+        if (peak.time < lastTime || peak.time - lastTime > maximumGapSeconds)
+            clear();
+    }
+
+    // Cada dos picos de un nivel forman uno del siguiente
+    auto merged = peak;
+
+    for (auto& level : levels)
+    {
+        level.peaks[(size_t) (level.count & (levelSize - 1))] = merged;
+        ++level.count;
+
+        if (!level.hasPending)
+        {
+            level.pending = merged;
+            level.hasPending = true;
+            return;
+        }
+
+        merged = { level.pending.time,
+                   juce::jmin (level.pending.minimum, merged.minimum),
+                   juce::jmax (level.pending.maximum, merged.maximum) };
+        level.hasPending = false;
+    }
+}
+
+//==============================================================================
+int WaveformMipmap::chooseLevel (double secondsPerPixel) const
+{
+    // Duración real de un pico del nivel 0 (depende de la velocidad de reproducción)
+    const auto& base = levels[0];
+    const auto first = base.getFirst();
+
+    if (base.count - first < 2)
+        return 0;
+
+    const double peakSeconds = (base.get (base.count - 1).time - base.get (first).time) / (double) (base.count - 1 - first);
+    int level = 0;
+
+    while (level + 1 < numLevels && levels[(size_t) level + 1].count > 0
+           && peakSeconds * (double) (2 << level) <= secondsPerPixel)
+        ++level;
+
+    return level;
+}
+
+juce::uint64 WaveformMipmap::findFirstAtOrAfter (const Level& level, double seconds)
+{
+    auto low = level.getFirst();
+    auto high = level.count;
+
+    while (low < high)
+    {
+        const auto middle = low + (high - low) / 2;
+
+        if (level.get (middle).time < seconds)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    WaveformMipmap.h
+    Historial de picos de la entrada en varias resoluciones, para dibujarlo.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "InputWaveform.h"
+
+//==============================================================================
+/**
+    Guarda los últimos picos recibidos de InputWaveform en numLevels niveles:
+    el nivel 0 son los intervalos tal cual y cada nivel siguiente une los
+    intervalos de dos en dos. Cada nivel es un anillo fijo de levelSize picos
+    reservado al crearse, así que añadir no reserva memoria.
+
+    Para dibujar se elige el nivel más grueso cuyos intervalos aún caben en un
+    píxel, de modo que cada columna recorre uno o dos picos: el coste depende
+    del ancho en píxeles y no de cuántas muestras entraron.
+
+    Los tiempos de cada nivel son crecientes; si llega un pico que salta hacia
+    atrás o deja un hueco (búsqueda, pausa larga) el historial empieza de
+    nuevo. Solo se usa desde el hilo de mensajes.
+*/
+class WaveformMipmap
+{
+public:
+    using Peak = InputWaveform::Peak;
+
+    WaveformMipmap();
+
+    void clear();
+    void add (const Peak& peak);
+
+    bool isEmpty() const        { return levels[0].count == 0; }
+
+    // Llama a callback (column, minimum, maximum) para cada columna de píxeles con datos.
+    // La columna c cubre [startSeconds + c * secondsPerPixel, startSeconds + (c + 1) * secondsPerPixel).
+    template <typename Callback>
+    void visitColumns (double startSeconds, double secondsPerPixel, int numColumns, Callback&& callback) const
+    {
+        if (secondsPerPixel <= 0.0)
+            return;
+
+        const auto& level = levels[(size_t) chooseLevel (secondsPerPixel)];
+        auto index = findFirstAtOrAfter (level, startSeconds);
+
+        for (int column = 0; column < numColumns && index < level.count; ++column)
+        {
+            const double columnEnd = startSeconds + (column + 1) * secondsPerPixel;
+            float minimum = std::numeric_limits<float>::max();
+            float maximum = std::numeric_limits<float>::lowest();
+            bool found = false;
+
+            for (; index < level.count && level.get (index).time < columnEnd; ++index)
+            {
+                minimum = juce::jmin (minimum, level.get (index).minimum);
+                maximum = juce::jmax (maximum, level.get (index).maximum);
+                found = true;
+            }
+
+            if (found)
+                callback (column, minimum, maximum);
+        }
+    }
+
+    static constexpr int numLevels = 8;             // De 1 ms a 128 ms por pico
+    static constexpr int levelSize = 8192;          // Picos por nivel (potencia de dos)
+    static constexpr double maximumGapSeconds = 0.25;
+
+private:
+    struct Level
+    {
+        std::vector<Peak> peaks;            // Anillo de levelSize picos
+        juce::uint64 count = 0;             // Picos añadidos desde clear(); el último es count - 1
+        Peak pending;                       // Primera mitad del siguiente pico del nivel superior
+        bool hasPending = false;
+
+        const Peak& get (juce::uint64 index) const      { return peaks[(size_t) (index & (levelSize - 1))]; }
+        juce::uint64 getFirst() const                   { return count > (juce::uint64) levelSize ? count - levelSize : 0; }
+    };
+
+    int chooseLevel (double secondsPerPixel) const;
+    static juce::uint64 findFirstAtOrAfter (const Level& level, double seconds);
+
+    std::array<Level, numLevels> levels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformMipmap)
+};